@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_threaded.hpp"
+#include "et/codegen_backend.hpp"
+
+using namespace et;
+
+template <class E>
+static Tape tape_of(const E& e) {
+  CodegenBackend cb(3);
+  cb.tape.output_id = compile_runtime(compile_to_runtime(e, true), cb);
+  return cb.tape;
+}
+
+// ns per value, gradient and batch row: Tape interpreter, threaded engine and
+// the compiled source (build time reported separately)
+static void measure(const char* name, const Tape& t, std::size_t evals) {
+  using clock = std::chrono::steady_clock;
+  auto b0 = clock::now();
+  CompiledTape c;
+  std::string log;
+  if (!compile_and_load(t, c, {}, &log)) { std::printf("%-12s build failed:\n%s\n", name, log.c_str()); return; }
+  const double build_ms = std::chrono::duration<double, std::milli>(clock::now() - b0).count();
+  const ThreadedTape tt(t);
+
+  std::mt19937 rng(9);
+  std::uniform_real_distribution<double> U(0.5, 1.5);
+  std::vector<std::vector<double>> pts(64, std::vector<double>(t.arity));
+  for (auto& p : pts) for (auto& v : p) v = U(rng);
+  Tape::Workspace ws(t);
+  std::vector<double> grad(t.arity);
+  volatile double sink = 0.0;
+  auto time = [&](auto&& call) {
+    double best = 1e300;
+    for (int rep = 0; rep < 5; ++rep) {
+      auto t0 = clock::now();
+      for (std::size_t k = 0; k < evals; ++k) sink = sink + call(pts[k % pts.size()].data());
+      best = std::min(best, std::chrono::duration<double, std::nano>(clock::now() - t0).count() / double(evals));
+    }
+    return best;
+  };
+  const double sf = time([&](const double* in) { return t.forward(in, ws); });
+  const double tf = time([&](const double* in) { return tt.forward(in, ws); });
+  const double cf = time([&](const double* in) { return c.value(in); });
+  const double sb = time([&](const double* in) { return t.backward(in, ws, grad.data()); });
+  const double tb = time([&](const double* in) { return tt.backward(in, ws, grad.data()); });
+  const double cb = time([&](const double* in) { return c.grad(in, grad.data()); });
+
+  const std::size_t rows = 4096;
+  std::vector<std::vector<double>> cols(t.arity, std::vector<double>(rows));
+  for (auto& col : cols) for (auto& v : col) v = U(rng);
+  std::vector<const double*> ptrs;
+  for (auto& col : cols) ptrs.push_back(col.data());
+  std::vector<double> out(rows);
+  const std::size_t passes = std::max<std::size_t>(1, evals / rows);
+  auto batch = [&](auto&& call) {
+    double best = 1e300;
+    for (int rep = 0; rep < 5; ++rep) {
+      auto t0 = clock::now();
+      for (std::size_t k = 0; k < passes; ++k) { call(); sink = sink + out[k % rows]; }
+      best = std::min(best, std::chrono::duration<double, std::nano>(clock::now() - t0).count() / double(passes * rows));
+    }
+    return best;
+  };
+  const double sr = batch([&]{ t.forward_batch(ptrs.data(), rows, out.data(), ws); });
+  const double cr = batch([&]{ c.batch(ptrs.data(), rows, out.data()); });
+
+  std::printf("%-12s %6zu nodes build %7.1f ms | value ns: tape %8.1f threaded %8.1f codegen %8.1f (%.1fx)"
+              " | grad ns: tape %8.1f threaded %8.1f codegen %8.1f (%.1fx) | batch ns/row: tape %6.2f codegen %6.2f (%.1fx)\n",
+              name, t.nodes.size(), build_ms, sf, tf, cf, sf / cf, sb, tb, cb, sb / cb, sr, cr, sr / cr);
+}
+
+// Interpreted tape vs. generated and compiled C++ on the examples' expressions
+// and a Horner polynomial: bench_codegen [degree]
+int main(int argc, char** argv) {
+  const int degree = argc > 1 ? std::stoi(argv[1]) : 200;
+  auto [x,y,z] = Vars<double,3>();
+  measure("01 basic", tape_of(sin(x)*y + z*z), 2000000);
+  measure("06 ops+cse", tape_of(exp(x)*tanh(y) + log(z) + exp(x)*tanh(y) + sqrt(z*z)), 2000000);
+  auto g = exp(x)*tanh(y);
+  measure("07 hash cse", tape_of(g + log(z) + g + sqrt(z*z) + g), 2000000);
+
+  CodegenBackend cb(3);
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> U(-1.0, 1.0);
+  const int xv = cb.emitVar<double>(0), yv = cb.emitVar<double>(1);
+  int h = cb.emitConst(Const<double>{ U(rng) });
+  for (int d = 0; d < degree; ++d)
+    h = cb.emitApply(AddOp{}, cb.emitApply(MulOp{}, h, d % 2 ? xv : yv), cb.emitConst(Const<double>{ U(rng) * 0.5 }));
+  cb.tape.output_id = h;
+  measure("horner", cb.tape, 200000);
+  return 0;
+}
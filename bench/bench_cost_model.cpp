@@ -0,0 +1,22 @@
+#include <cstdio>
+#include <string>
+
+#include "et/cost_model.hpp"
+
+using namespace et;
+
+// Calibrates the per-operator cost model on this machine, prints it next to
+// the built-in defaults and optionally saves it: bench_cost_model [out.txt]
+int main(int argc, char** argv) {
+  const CostModel d = CostModel::defaults();
+  const CostModel c = CostModel::calibrate(1 << 14, 9);
+  const double add = c.unit[std::size_t(NodeKind::Add)] > 0 ? c.unit[std::size_t(NodeKind::Add)] : 1.0;
+  std::printf("%-6s %10s %10s %10s\n", "kind", "ns/op", "rel. Add", "default");
+  for (std::size_t k = 0; k < CostModel::kKinds; ++k)
+    std::printf("%-6s %10.3f %10.2f %10.2f\n", CostModel::kind_name(NodeKind(k)), c.unit[k], c.unit[k] / add, d.unit[k]);
+  if (argc > 1) {
+    if (!c.save(argv[1])) { std::fprintf(stderr, "cannot write %s\n", argv[1]); return 1; }
+    std::printf("saved to %s\n", argv[1]);
+  }
+  return 0;
+}
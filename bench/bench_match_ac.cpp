@@ -0,0 +1,59 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/match.hpp"
+#include "et/rewrite.hpp"
+#include "et/rules_default.hpp"
+
+using namespace et;
+
+// AC matching on wide sums: the default rules are matched against the root
+// Add of sums with hundreds of terms (sin(x_i)^2, cos(x_j)^2 and products that
+// almost, but not quite, form the Pythagorean / square / factoring patterns),
+// so the multiset matcher backtracks through most of the children.
+static RGraph wide_sum(int terms) {
+  RGraph g;
+  auto var = [&](std::size_t i) { RNode n; n.kind = NodeKind::Var; n.var_index = i; return g.add(n); };
+  auto app = [&](NodeKind k, std::vector<int> ch) { RNode n; n.kind = k; n.ch = std::move(ch); return g.add(n); };
+  std::vector<int> ts;
+  for (int k = 0; k < terms; ++k) {
+    const int a = var((std::size_t)k), b = var((std::size_t)k + 1);
+    switch (k % 4) {
+      case 0: { int s = app(NodeKind::Sin, { a }); ts.push_back(app(NodeKind::Mul, { s, s })); break; }
+      case 1: { int c = app(NodeKind::Cos, { b }); ts.push_back(app(NodeKind::Mul, { c, c })); break; }
+      case 2: ts.push_back(app(NodeKind::Mul, { a, b })); break;
+      default: ts.push_back(app(NodeKind::Exp, { a })); break;
+    }
+  }
+  g.root = app(NodeKind::Add, ts);
+  return normalize(g);
+}
+
+int main(int argc, char** argv) {
+  const int reps = argc > 1 ? std::stoi(argv[1]) : 5;
+  auto rules = default_rules();
+  using clock = std::chrono::steady_clock;
+  std::printf("%8s %14s %14s %10s\n", "terms", "root match ms", "pass ms", "matches");
+  for (int terms : { 100, 200, 400, 800 }) {
+    RGraph g = wide_sum(terms);
+    std::size_t hits = 0;
+    Bindings b; MultiBindings mb;
+    auto t0 = clock::now();
+    for (int r = 0; r < reps; ++r)
+      for (const Rule& rule : rules) {
+        b.clear(); mb.clear();
+        if (match_node(g, g.root, rule.lhs, b, mb)) ++hits;
+      }
+    auto t1 = clock::now();
+    for (int r = 0; r < reps; ++r) apply_rules_once(g, rules);
+    auto t2 = clock::now();
+    std::printf("%8d %14.3f %14.3f %10zu\n", terms,
+                std::chrono::duration<double, std::milli>(t1 - t0).count() / reps,
+                std::chrono::duration<double, std::milli>(t2 - t1).count() / reps, hits / reps);
+  }
+  return 0;
+}
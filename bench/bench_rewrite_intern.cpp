@@ -0,0 +1,65 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/rewrite.hpp"
+#include "et/rules_default.hpp"
+
+using namespace et;
+
+// Plain vs hash-consed RGraph on the tests/test_rewrite_nested_large.cpp
+// workload: node counts, approximate memory and per-pass timings.
+static std::size_t graph_bytes(const RGraph& g) {
+  std::size_t b = g.nodes.capacity() * sizeof(RNode);
+  for (auto& n : g.nodes) b += n.ch.capacity() * sizeof(int);
+  b += g.index.size() * (sizeof(std::uint64_t) + sizeof(int) + 2 * sizeof(void*)) + g.index.bucket_count() * sizeof(void*);
+  return b;
+}
+
+int main(int argc, char** argv) {
+  const int reps = argc > 1 ? std::stoi(argv[1]) : 200;
+
+  auto [x,y,z,p,q,r,s,w] = Vars<double,8>();
+  auto a = log(exp(x + y));
+  auto u = a + sin(w);
+  auto e = sin(u)*sin(u) + cos(u)*cos(u)
+         + log(exp(u))
+         + (lit(2.0)*u + lit(3.0)*u)
+         + (p*p + lit(2.0)*p*q + q*q)
+         + ( (p*p) - (lit(2.0)*p*q) + (q*q) )
+         + lit(5.0);
+  (void)z; (void)r; (void)s;
+  auto rules = default_rules();
+
+  using clock = std::chrono::steady_clock;
+  for (bool interned : { false, true }) {
+    double t_build = 0, t_norm = 0, t_rw = 0, t_post = 0;
+    RGraph g0, gn, gr, gf;
+    for (int i = 0; i < reps; ++i) {
+      auto t0 = clock::now();
+      g0 = compile_to_runtime(e, interned);
+      auto t1 = clock::now();
+      gn = normalize(g0);
+      auto t2 = clock::now();
+      gr = rewrite_fixed_point(gn, rules, 12);
+      auto t3 = clock::now();
+      gf = denormalize_sub(normalize(gr));
+      auto t4 = clock::now();
+      t_build += std::chrono::duration<double, std::micro>(t1 - t0).count();
+      t_norm  += std::chrono::duration<double, std::micro>(t2 - t1).count();
+      t_rw    += std::chrono::duration<double, std::micro>(t3 - t2).count();
+      t_post  += std::chrono::duration<double, std::micro>(t4 - t3).count();
+    }
+    std::printf("%s\n", interned ? "interned" : "plain");
+    std::printf("  nodes  build %5zu  normalized %5zu  rewritten %5zu  final %5zu\n",
+                g0.nodes.size(), gn.nodes.size(), gr.nodes.size(), gf.nodes.size());
+    std::printf("  bytes  build %6zu  rewritten %6zu\n", graph_bytes(g0), graph_bytes(gr));
+    std::printf("  us/run build %7.1f  normalize %7.1f  rewrite %8.1f  post %7.1f\n",
+                t_build / reps, t_norm / reps, t_rw / reps, t_post / reps);
+  }
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/rewrite.hpp"
+#include "et/rewrite_worklist.hpp"
+#include "et/rules_default.hpp"
+
+using namespace et;
+
+// A large generated expression (sums of 16 terms nested three levels deep
+// under sqrt, so no sum gets huge) with a handful of redexes: pass-based fixed
+// point (rebuild + normalize the whole graph per pass) against the worklist
+// rewriter.
+int main(int argc, char** argv) {
+  const int terms = argc > 1 ? std::stoi(argv[1]) : 16 * 16 * 16 * 4;
+  const int redexes = argc > 2 ? std::stoi(argv[2]) : 5;
+
+  RGraph g;
+  auto var = [&](std::size_t i) { RNode n; n.kind = NodeKind::Var; n.var_index = i; return g.add(n); };
+  auto app = [&](NodeKind k, std::vector<int> ch) { RNode n; n.kind = k; n.ch = std::move(ch); return g.add(n); };
+  std::vector<int> ts;
+  for (int k = 0; k < terms; ++k) {
+    int v = var((std::size_t)k);
+    int t = app(NodeKind::Mul, { app(NodeKind::Sin, { v }), app(NodeKind::Tanh, { v }) });
+    if (k % (terms / redexes) == 0) t = app(NodeKind::Log, { app(NodeKind::Exp, { t }) });
+    ts.push_back(t);
+  }
+  while (ts.size() > 16) {
+    std::vector<int> up;
+    for (std::size_t i = 0; i < ts.size(); i += 16) {
+      std::vector<int> grp(ts.begin() + i, ts.begin() + std::min(ts.size(), i + 16));
+      up.push_back(app(NodeKind::Sqrt, { app(NodeKind::Add, grp) }));
+    }
+    ts.swap(up);
+  }
+  g.root = app(NodeKind::Add, ts);
+  g = normalize(g);
+  auto rules = default_rules();
+
+  using clock = std::chrono::steady_clock;
+  auto t0 = clock::now();
+  RGraph a = normalize(rewrite_fixed_point(g, rules, 12));
+  auto t1 = clock::now();
+  WorklistStats st;
+  RGraph b = rewrite_worklist(g, rules, 100000, &st);
+  auto t2 = clock::now();
+
+  std::printf("graph nodes: %zu, redexes: %d\n", g.nodes.size(), redexes);
+  std::printf("rewrite_fixed_point : %8.2f ms\n", std::chrono::duration<double, std::milli>(t1 - t0).count());
+  std::printf("rewrite_worklist    : %8.2f ms  (visited %zu, rewrites %zu, rebuilt %zu)\n",
+              std::chrono::duration<double, std::milli>(t2 - t1).count(), st.visited, st.rewrites, st.rebuilt);
+  std::printf("same result: %s\n", r_to_string(a) == r_to_string(normalize(b)) ? "yes" : "no");
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/rewrite.hpp"
+#include "et/rule_index.hpp"
+#include "et/rules_default.hpp"
+
+using namespace et;
+
+// Matching cost of a large rule set: every node of a generated graph is tested
+// against all 1000+ rules in priority order (what rewrite_node used to do) and
+// against the candidates returned by RuleIndex. Both find the same matches.
+static std::vector<Rule> synthetic_rules(int count) {
+  using namespace et::pat;
+  const NodeKind un[] = { NodeKind::Neg, NodeKind::Sin, NodeKind::Cos, NodeKind::Exp, NodeKind::Log, NodeKind::Sqrt, NodeKind::Tanh };
+  const NodeKind bin[] = { NodeKind::Sub, NodeKind::Div, NodeKind::Pow, NodeKind::Add, NodeKind::Mul };
+  std::vector<Rule> rs;
+  for (int i = 0; i < count; ++i) {
+    const NodeKind u1 = un[i % 7], u2 = un[(i / 7) % 7], b = bin[(i / 49) % 5];
+    Pattern lhs;
+    switch (i % 4) {
+      case 0: lhs = Pattern::node(u1, { Pattern::node(u2, { P(1) }) }); break;
+      case 1: lhs = Pattern::node(b, { P(1), Pattern::node(u2, { P(2) }) }); break;
+      case 2: lhs = Pattern::node(u1, { Pattern::node(b, { Pattern::node(u2, { P(1) }), P(2) }) }); break;
+      default: lhs = Pattern::node(NodeKind::Add, { Pattern::node(u1, { P(1) }), Pattern::node(u2, { P(2) }), S(9) }); break;
+    }
+    rs.push_back(Rule{ lhs, P(1), {}, "synthetic", i % 3 });
+  }
+  return rs;
+}
+
+int main(int argc, char** argv) {
+  const int nrules = argc > 1 ? std::stoi(argv[1]) : 1000;
+  const int terms = argc > 2 ? std::stoi(argv[2]) : 2000;
+
+  RGraph g;
+  auto var = [&](std::size_t i) { RNode n; n.kind = NodeKind::Var; n.var_index = i; return g.add(n); };
+  auto app = [&](NodeKind k, std::vector<int> ch) { RNode n; n.kind = k; n.ch = std::move(ch); return g.add(n); };
+  const NodeKind un[] = { NodeKind::Sin, NodeKind::Cos, NodeKind::Exp, NodeKind::Tanh, NodeKind::Neg };
+  std::vector<int> ts;
+  for (int k = 0; k < terms; ++k) {
+    int v = var((std::size_t)(k % 64));
+    int t = app(NodeKind::Div, { app(un[k % 5], { v }), app(un[(k / 5) % 5], { app(NodeKind::Sqrt, { v }) }) });
+    ts.push_back(app(un[(k / 25) % 5], { t }));
+  }
+  while (ts.size() > 8) {
+    std::vector<int> up;
+    for (std::size_t i = 0; i < ts.size(); i += 8)
+      up.push_back(app(NodeKind::Log, { app(NodeKind::Add, std::vector<int>(ts.begin() + i, ts.begin() + std::min(ts.size(), i + 8))) }));
+    ts.swap(up);
+  }
+  g.root = app(NodeKind::Add, ts);
+  g = normalize(g);
+
+  std::vector<Rule> rules = default_rules();
+  for (auto& r : synthetic_rules(nrules)) rules.push_back(r);
+
+  using clock = std::chrono::steady_clock;
+  auto t0 = clock::now();
+  const RuleIndex index(rules);
+  auto t1 = clock::now();
+
+  std::size_t lin_tries = 0, lin_hits = 0;
+  Bindings b; MultiBindings mb;
+  for (int id = 0; id < (int)g.nodes.size(); ++id)
+    for (const Rule* r : index.order) {
+      b.clear(); mb.clear(); ++lin_tries;
+      if (match_node(g, id, r->lhs, b, mb)) ++lin_hits;
+    }
+  auto t2 = clock::now();
+
+  std::size_t ix_tries = 0, ix_hits = 0;
+  std::vector<const Rule*> cand;
+  for (int id = 0; id < (int)g.nodes.size(); ++id) {
+    cand.clear();
+    index.candidates(g, id, cand);
+    for (const Rule* r : cand) {
+      b.clear(); mb.clear(); ++ix_tries;
+      if (match_node(g, id, r->lhs, b, mb)) ++ix_hits;
+    }
+  }
+  auto t3 = clock::now();
+
+  RewritePassStats st;
+  RGraph once = apply_rules_once(g, index, &st);
+  auto t4 = clock::now();
+
+  auto ms = [](clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+  std::printf("rules: %zu, graph nodes: %zu, trie nodes: %zu\n", rules.size(), g.nodes.size(), index.trie.size());
+  std::printf("index build        : %8.3f ms\n", ms(t1 - t0));
+  std::printf("linear scan        : %8.2f ms  (%zu match calls, %zu matches)\n", ms(t2 - t1), lin_tries, lin_hits);
+  std::printf("indexed            : %8.2f ms  (%zu match calls, %zu matches)\n", ms(t3 - t2), ix_tries, ix_hits);
+  std::printf("apply_rules_once   : %8.2f ms  (visited %zu, attempts %zu, rewrites %zu, %zu nodes out)\n",
+              ms(t4 - t3), st.visited, st.attempts, st.rewrites, once.nodes.size());
+  return lin_hits == ix_hits ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+#include "et/strength_reduce.hpp"
+
+using namespace et;
+
+// Polynomial-heavy expression, sum of c * x_i^p * x_j^q over three inputs with
+// exponents in {2..8, -1, -2, 0.5, -0.5}, evaluated on a Tape as written (Pow)
+// and after strength_reduce: bench_strength_reduce [terms] [rows]
+int main(int argc, char** argv) {
+  const std::size_t terms = argc > 1 ? std::stoul(argv[1]) : 64;
+  const std::size_t rows = argc > 2 ? std::stoul(argv[2]) : 200000;
+
+  RGraph g;
+  g.enable_interning(); // one node per input, so powers of x_i share their chains
+  auto leaf = [&](NodeKind k, double c, std::size_t vi) { RNode n; n.kind = k; n.cval = c; n.var_index = vi; return g.add(std::move(n)); };
+  auto app = [&](NodeKind k, std::vector<int> ch) { RNode n; n.kind = k; n.ch = std::move(ch); return g.add(std::move(n)); };
+  const double exps[] = { 2, 3, 4, 5, 6, 7, 8, -1, -2, 0.5, -0.5 };
+  std::mt19937_64 rng(7);
+  std::vector<int> sum;
+  for (std::size_t t = 0; t < terms; ++t) {
+    const int xi = leaf(NodeKind::Var, 0, rng() % 3), xj = leaf(NodeKind::Var, 0, rng() % 3);
+    const int p = app(NodeKind::Pow, { xi, leaf(NodeKind::Const, exps[rng() % 11], 0) });
+    const int q = app(NodeKind::Pow, { xj, leaf(NodeKind::Const, exps[rng() % 11], 0) });
+    sum.push_back(app(NodeKind::Mul, { leaf(NodeKind::Const, 0.5 + double(t % 7), 0), p, q }));
+  }
+  g.root = app(NodeKind::Add, sum);
+  g = normalize(g);
+
+  StrengthReduceStats st;
+  const RGraph r = strength_reduce(g, 32, &st);
+  auto to_tape = [](const RGraph& h) { TapeBackend tb(3); tb.tape.output_id = compile_runtime(h, tb); return tb.tape; };
+  const Tape tp = to_tape(g), tr = to_tape(r);
+
+  std::vector<std::vector<double>> cols(3, std::vector<double>(rows));
+  std::uniform_real_distribution<double> U(0.5, 2.0); // positive: valid for sqrt and negative powers
+  for (auto& c : cols) for (auto& v : c) v = U(rng);
+  const double* ptrs[3] = { cols[0].data(), cols[1].data(), cols[2].data() };
+
+  using clock = std::chrono::steady_clock;
+  auto secs = [](clock::time_point a, clock::time_point b) { return std::chrono::duration<double>(b - a).count(); };
+  auto run = [&](const Tape& t, std::vector<double>& out, double& gsum, double& tb, double& tg) {
+    auto t0 = clock::now();
+    t.forward_batch(ptrs, rows, out.data());
+    auto t1 = clock::now();
+    Tape::Workspace ws(t);
+    double in[3], grad[3];
+    gsum = 0.0;
+    for (std::size_t k = 0; k < rows; ++k) {
+      in[0] = cols[0][k]; in[1] = cols[1][k]; in[2] = cols[2][k];
+      t.backward(in, ws, grad);
+      gsum += grad[0] + grad[1] + grad[2];
+    }
+    tb = secs(t0, t1); tg = secs(t1, clock::now());
+  };
+
+  std::vector<double> op(rows), orr(rows);
+  double gp, gr, bp, br, dp, dr;
+  run(tp, op, gp, bp, dp);
+  run(tr, orr, gr, br, dr);
+  double max_err = 0.0;
+  for (std::size_t k = 0; k < rows; ++k) max_err = std::max(max_err, std::fabs(orr[k] - op[k]) / (1.0 + std::fabs(op[k])));
+
+  std::printf("terms: %zu, rows: %zu, Pow lowered: %zu/%zu (%zu muls)\n", terms, rows, st.lowered, st.pows, st.muls);
+  std::printf("tape nodes     : %8zu -> %zu\n", tp.nodes.size(), tr.nodes.size());
+  std::printf("forward_batch  : %8.3f s -> %8.3f s  (%.2fx)\n", bp, br, bp / br);
+  std::printf("scalar backward: %8.3f s -> %8.3f s  (%.2fx)\n", dp, dr, dp / dr);
+  std::printf("max rel err %.3e, grad sum rel diff %.3e\n", max_err, std::fabs(gr - gp) / (1.0 + std::fabs(gp)));
+  return 0;
+}
@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_checkpoint.hpp"
+
+using namespace et;
+
+// Explicit time stepping of m coupled damped pendulums, unrolled into one
+// tape; inputs are the initial angles and velocities, stiffness and damping
+static Tape chain(int steps, int m) {
+  TapeBackend tb(2 * m + 2);
+  std::vector<int> th(m), om(m);
+  for (int i = 0; i < m; ++i) { th[i] = tb.emitVar<double>(i); om[i] = tb.emitVar<double>(m + i); }
+  const int k = tb.emitVar<double>(2 * m), c = tb.emitVar<double>(2 * m + 1);
+  const int h = tb.emitConst(Const<double>{ 0.001 }), q = tb.emitConst(Const<double>{ 0.5 });
+  for (int s = 0; s < steps; ++s) {
+    std::vector<int> acc(m);
+    for (int i = 0; i < m; ++i) {
+      int a = tb.emitApply(NegOp{}, tb.emitApply(MulOp{}, k, tb.emitApply(SinOp{}, th[i])));
+      a = tb.emitApply(SubOp{}, a, tb.emitApply(MulOp{}, c, om[i]));
+      if (i + 1 < m) a = tb.emitApply(AddOp{}, a, tb.emitApply(MulOp{}, q, tb.emitApply(SubOp{}, th[i + 1], th[i])));
+      if (i > 0)     a = tb.emitApply(AddOp{}, a, tb.emitApply(MulOp{}, q, tb.emitApply(SubOp{}, th[i - 1], th[i])));
+      acc[i] = a;
+    }
+    for (int i = 0; i < m; ++i) {
+      om[i] = tb.emitApply(AddOp{}, om[i], tb.emitApply(MulOp{}, h, acc[i]));
+      th[i] = tb.emitApply(AddOp{}, th[i], tb.emitApply(MulOp{}, h, om[i]));
+    }
+  }
+  std::vector<int> terms;
+  for (int i = 0; i < m; ++i) terms.push_back(tb.emitApply(MulOp{}, th[i], th[i]));
+  tb.tape.output_id = tb.emitNary(AddOp{}, terms);
+  return tb.tape;
+}
+
+using clock_type = std::chrono::steady_clock;
+
+template <class F>
+static double best_ms(F&& f) {
+  double best = 1e300;
+  for (int rep = 0; rep < 3; ++rep) {
+    auto t0 = clock_type::now();
+    f();
+    best = std::min(best, std::chrono::duration<double, std::milli>(clock_type::now() - t0).count());
+  }
+  return best;
+}
+
+// Memory and recomputation the planner chooses for shrinking budgets, and the
+// measured gradient time against Tape::backward:
+// bench_tape_checkpoint [steps] [pendulums]
+int main(int argc, char** argv) {
+  const int steps = argc > 1 ? std::stoi(argv[1]) : 50000;
+  const int m = argc > 2 ? std::stoi(argv[2]) : 4;
+  const Tape t = chain(steps, m);
+  std::vector<double> in(t.arity, 0.3), grad(t.arity), g2(t.arity);
+  in[2 * m] = 9.0; in[2 * m + 1] = 0.1;
+
+  Tape::Workspace tws(t);
+  const double plain = best_ms([&] { t.backward(in.data(), tws, grad.data()); });
+  std::printf("tape nodes: %zu; Tape::backward %.2f ms, workspace %.1f KiB\n",
+              t.nodes.size(), plain, double((tws.val.size() + tws.bar.size()) * sizeof(double)) / 1024.0);
+  std::printf("%12s | %8s %9s %8s %11s | %11s %9s | %9s %7s %9s\n", "budget KiB", "segments", "snapshots",
+              "max_live", "max_segment", "memory KiB", "recompute", "grad ms", "vs plain", "plan ms");
+  for (std::size_t div = 1; div <= 4096; div *= 4) {
+    const std::size_t budget = (2 * t.nodes.size() + t.max_args) * sizeof(double) / div;
+    auto t0 = clock_type::now();
+    const CheckpointedTape ct(t, budget);
+    const double build = std::chrono::duration<double, std::milli>(clock_type::now() - t0).count();
+    CheckpointedTape::Workspace ws(ct);
+    const double ms = best_ms([&] { ct.backward(in.data(), ws, g2.data()); });
+    double err = 0.0;
+    for (std::size_t j = 0; j < grad.size(); ++j) err = std::max(err, std::fabs(g2[j] - grad[j]) / (1.0 + std::fabs(grad[j])));
+    const CheckpointPlan& p = ct.plan;
+    std::printf("%12.1f | %8zu %9zu %8zu %11zu | %11.1f %8.2fx | %9.2f %6.2fx %9.1f%s\n", double(budget) / 1024.0,
+                p.segments, p.snapshots, p.max_live, p.max_segment, double(p.memory_bytes) / 1024.0, p.recompute(),
+                ms, ms / plain, build, p.fits ? "" : "  (over budget)");
+    if (err > 1e-9) std::printf("  gradient mismatch %.3g\n", err);
+  }
+  return 0;
+}
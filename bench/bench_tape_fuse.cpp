@@ -0,0 +1,76 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "et/runtime_ast.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_fuse.hpp"
+
+using namespace et;
+
+// Scalar forward and backward of a multiply-add heavy tape (Horner
+// polynomials, dot products, rotations through sin/cos of one angle) before
+// and after fuse_tape: bench_tape_fuse [blocks] [reps]
+int main(int argc, char** argv) {
+  const std::size_t blocks = argc > 1 ? std::stoul(argv[1]) : 64;
+  const std::size_t reps = argc > 2 ? std::stoul(argv[2]) : 20000;
+
+  RGraph g;
+  g.enable_interning();
+  auto var = [&](std::size_t i) { RNode n; n.kind = NodeKind::Var; n.var_index = i; return g.add(std::move(n)); };
+  auto cst = [&](double c) { RNode n; n.kind = NodeKind::Const; n.cval = c; return g.add(std::move(n)); };
+  auto app = [&](NodeKind k, std::vector<int> ch) { RNode n; n.kind = k; n.ch = std::move(ch); return g.add(std::move(n)); };
+  constexpr std::size_t kVars = 8;
+  std::mt19937_64 rng(3);
+  std::uniform_real_distribution<double> U(-1.0, 1.0);
+  int acc = -1;
+  for (std::size_t b = 0; b < blocks; ++b) {
+    const int x = var(b % kVars), y = var((b + 3) % kVars), th = var((b + 5) % kVars);
+    int h = cst(U(rng));                                   // Horner, degree 8
+    for (int d = 0; d < 8; ++d) h = app(NodeKind::Add, { app(NodeKind::Mul, { h, x }), cst(U(rng)) });
+    int dot = app(NodeKind::Mul, { x, y });                // 4-term dot product
+    for (std::size_t k = 1; k < 4; ++k)
+      dot = app(NodeKind::Add, { dot, app(NodeKind::Mul, { var((b + k) % kVars), var((b + k + 4) % kVars) }) });
+    const int s = app(NodeKind::Sin, { th }), c = app(NodeKind::Cos, { th });
+    const int rot = app(NodeKind::Sub, { app(NodeKind::Mul, { c, h }), app(NodeKind::Mul, { s, dot }) });
+    acc = acc < 0 ? rot : app(NodeKind::Add, { acc, rot });
+  }
+  g.root = acc;
+
+  TapeBackend tb(kVars);
+  tb.tape.output_id = compile_runtime(g, tb);
+  const Tape& t = tb.tape;
+  FuseStats st;
+  const Tape f = fuse_tape(t, &st);
+
+  std::vector<std::vector<double>> pts(256, std::vector<double>(kVars));
+  for (auto& p : pts) for (auto& v : p) v = U(rng);
+
+  using clock = std::chrono::steady_clock;
+  auto run = [&](const Tape& tp, double& tf, double& tr, double& sum) {
+    Tape::Workspace ws(tp);
+    std::vector<double> grad(kVars);
+    sum = 0.0;
+    auto t0 = clock::now();
+    for (std::size_t r = 0; r < reps; ++r) sum += tp.forward(pts[r % pts.size()].data(), ws);
+    auto t1 = clock::now();
+    for (std::size_t r = 0; r < reps; ++r) { tp.backward(pts[r % pts.size()].data(), ws, grad.data()); sum += grad[0]; }
+    auto t2 = clock::now();
+    tf = std::chrono::duration<double>(t1 - t0).count();
+    tr = std::chrono::duration<double>(t2 - t1).count();
+  };
+  double f0, b0, s0, f1, b1, s1;
+  run(t, f0, b0, s0);
+  run(f, f1, b1, s1);
+
+  std::printf("tape nodes: %zu -> %zu (fma %zu, fms %zu, square %zu, sincos %zu)\n",
+              t.nodes.size(), f.nodes.size(), st.fma, st.fms, st.square, st.sincos);
+  std::printf("forward : %8.3f s -> %8.3f s  (%.2fx)\n", f0, f1, f0 / f1);
+  std::printf("backward: %8.3f s -> %8.3f s  (%.2fx)\n", b0, b1, b0 / b1);
+  std::printf("checksum rel diff %.3e\n", std::fabs(s1 - s0) / (1.0 + std::fabs(s0)));
+  return 0;
+}
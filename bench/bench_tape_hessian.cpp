@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/tape_backend.hpp"
+
+using namespace et;
+
+// Dense 3x3 Hessians: forward-over-reverse on the tape against evaluating the
+// symbolic second derivatives diff(diff(f, xi), xj), plus a single
+// Hessian-vector product. The symbolic route also pays in compile time: each
+// diff(diff(f)) is a separate, much larger template tree.
+int main(int argc, char** argv) {
+  const std::size_t points = argc > 1 ? std::stoul(argv[1]) : 200000;
+
+  auto [x,y,z] = Vars<double,3>();
+  auto f = pow(sin(x) + cos(y), lit(2.0)) * z
+         + exp(x*y) / (lit(2.0) + z*z)
+         + sqrt(x*x + lit(1.0)) * tanh(y)
+         + log(z + lit(3.0));
+
+  auto hxx = diff(diff(f, x), x); auto hxy = diff(diff(f, x), y); auto hxz = diff(diff(f, x), z);
+  auto hyy = diff(diff(f, y), y); auto hyz = diff(diff(f, y), z); auto hzz = diff(diff(f, z), z);
+
+  TapeBackend tb(3);
+  tb.tape.output_id = compile(f, tb);
+  const Tape& t = tb.tape;
+
+  std::mt19937_64 rng(1);
+  std::uniform_real_distribution<double> U(-1.0, 1.0);
+  std::vector<double> pts(3 * points);
+  for (auto& v : pts) v = U(rng);
+
+  using clock = std::chrono::steady_clock;
+  std::vector<double> Hs(9 * points), Ht(9 * points);
+
+  auto t0 = clock::now();
+  for (std::size_t p = 0; p < points; ++p) {
+    const double a = pts[3*p], b = pts[3*p+1], c = pts[3*p+2];
+    double* H = &Hs[9*p];
+    H[0] = hxx(a,b,c); H[1] = hxy(a,b,c); H[2] = hxz(a,b,c);
+    H[4] = hyy(a,b,c); H[5] = hyz(a,b,c); H[8] = hzz(a,b,c);
+    H[3] = H[1]; H[6] = H[2]; H[7] = H[5];
+  }
+  auto t1 = clock::now();
+  Tape::Workspace ws(t);
+  for (std::size_t p = 0; p < points; ++p) t.hessian(&pts[3*p], ws, &Ht[9*p]);
+  auto t2 = clock::now();
+  const double v[3] = {0.5, -1.0, 0.25};
+  double Hv[3], acc = 0.0;
+  for (std::size_t p = 0; p < points; ++p) { t.hvp(&pts[3*p], v, ws, Hv); acc += Hv[0]; }
+  auto t3 = clock::now();
+
+  double max_err = 0.0;
+  for (std::size_t i = 0; i < Hs.size(); ++i)
+    max_err = std::max(max_err, std::fabs(Ht[i] - Hs[i]) / (1.0 + std::fabs(Hs[i])));
+
+  const double ts = std::chrono::duration<double>(t1 - t0).count();
+  const double tt = std::chrono::duration<double>(t2 - t1).count();
+  const double th = std::chrono::duration<double>(t3 - t2).count();
+  std::printf("tape nodes: %zu, points: %zu\n", t.nodes.size(), points);
+  std::printf("symbolic diff(diff(f)) : %8.3f s  %10.3e Hessians/s\n", ts, points / ts);
+  std::printf("tape hessian (fwd/rev) : %8.3f s  %10.3e Hessians/s\n", tt, points / tt);
+  std::printf("tape hvp (one dir)     : %8.3f s  %10.3e HVPs/s     (checksum %.3f)\n", th, points / th, acc);
+  std::printf("ratio                  : %8.2fx   max rel err %.3e\n", ts / tt, max_err);
+  return 0;
+}
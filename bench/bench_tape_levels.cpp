@@ -0,0 +1,57 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_levels.hpp"
+
+#include "random_tape.hpp"
+
+using namespace et;
+
+static void measure(const char* name, const Tape& t, std::size_t max_threads) {
+  const TapeLevels L = level_schedule(t);
+  std::printf("%s: work %zu nodes, critical path %zu levels, widest level %zu, parallelism %.1f\n",
+              name, L.work(), L.levels(), L.widest(), L.parallelism());
+  std::vector<double> in(t.arity);
+  for (std::size_t k = 0; k < in.size(); ++k) in[k] = 0.1 + 0.2 * double(k);
+  std::vector<double> grad(t.arity);
+  using clock = std::chrono::steady_clock;
+  auto time = [&](auto&& call) {
+    double best = 1e300;
+    for (int rep = 0; rep < 7; ++rep) {
+      auto t0 = clock::now();
+      call();
+      best = std::min(best, std::chrono::duration<double, std::milli>(clock::now() - t0).count());
+    }
+    return best;
+  };
+  Tape::Workspace ws(t);
+  const double sf = time([&] { t.forward(in.data(), ws); });
+  const double sg = time([&] { t.value_and_grad(in.data(), ws, grad.data()); });
+  std::printf("  serial          forward %8.3f ms  value_and_grad %8.3f ms\n", sf, sg);
+  for (std::size_t p = 1; p <= max_threads; ++p) {
+    LevelEvaluator le(t, p);
+    const double lf = time([&] { le.forward(in.data()); });
+    const double lg = time([&] { le.value_and_grad(in.data(), grad.data()); });
+    std::printf("  levels x%-3zu    forward %8.3f ms  value_and_grad %8.3f ms (%.2fx vs serial, %zu parallel phases)\n",
+                le.threads(), lf, lg, sg / lg, le.parallel_phases());
+  }
+}
+
+// Critical path vs. total work, and level-parallel forward/reverse against the
+// serial sweeps, on a wide and a deep random tape:
+// bench_tape_levels [nodes] [max_threads]
+int main(int argc, char** argv) {
+  const std::size_t n = argc > 1 ? std::stoul(argv[1]) : 400000;
+  const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+  const std::size_t max_threads = argc > 2 ? std::stoul(argv[2]) : hw;
+  std::printf("hardware threads: %zu\n", hw);
+  measure("wide", random_tape(n, 16, 5, {n}), max_threads);
+  measure("deep", random_tape(n, 16, 5, {40}), max_threads);
+  return 0;
+}
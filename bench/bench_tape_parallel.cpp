@@ -0,0 +1,54 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_parallel.hpp"
+
+#include "random_tape.hpp"
+
+using namespace et;
+
+// Rows per second for values and for values + gradients over 1..max threads,
+// with speedup and parallel efficiency against one thread:
+// bench_tape_parallel [max_threads] [rows] [nodes]
+int main(int argc, char** argv) {
+  const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+  const std::size_t max_threads = argc > 1 ? std::stoul(argv[1]) : hw;
+  const std::size_t rows = argc > 2 ? std::stoul(argv[2]) : 20000;
+  const std::size_t nodes = argc > 3 ? std::stoul(argv[3]) : 400;
+  const Tape t = random_tape(nodes, 4, 11);
+
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> U(-1.0, 1.0);
+  std::vector<double> in(rows * t.arity), values(rows), grads(rows * t.arity);
+  for (auto& v : in) v = U(rng);
+
+  std::printf("hardware threads: %zu, rows: %zu, tape nodes: %zu\n", hw, rows, t.nodes.size());
+  using clock = std::chrono::steady_clock;
+  double base_v = 0.0, base_g = 0.0;
+  for (std::size_t p = 1; p <= max_threads; ++p) {
+    ParallelEvaluator pe(t, p);
+    auto time = [&](double* g, ParallelEvaluator::Stats& st) {
+      double best = 1e300;
+      for (int rep = 0; rep < 5; ++rep) {
+        auto t0 = clock::now();
+        pe.evaluate(in.data(), rows, values.data(), g, &st);
+        best = std::min(best, std::chrono::duration<double>(clock::now() - t0).count());
+      }
+      return double(rows) / best;
+    };
+    ParallelEvaluator::Stats sv, sg;
+    const double rv = time(nullptr, sv), rg = time(grads.data(), sg);
+    if (p == 1) { base_v = rv; base_g = rg; }
+    std::printf("threads %3zu | values %10.0f rows/s (%5.2fx, eff %4.0f%%) | grads %10.0f rows/s (%5.2fx, eff %4.0f%%) | steals %zu\n",
+                p, rv, rv / base_v, 100.0 * rv / base_v / double(p), rg, rg / base_g, 100.0 * rg / base_g / double(p),
+                sg.steals);
+  }
+  return 0;
+}
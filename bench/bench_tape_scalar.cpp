@@ -0,0 +1,98 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/tape_backend.hpp"
+
+#include "random_tape.hpp"
+
+using namespace et;
+
+using clock_type = std::chrono::steady_clock;
+
+template <class F>
+static double best_seconds(F&& f) {
+  double best = 1e300;
+  for (int rep = 0; rep < 5; ++rep) {
+    auto t0 = clock_type::now();
+    f();
+    best = std::min(best, std::chrono::duration<double>(clock_type::now() - t0).count());
+  }
+  return best;
+}
+
+// Max over rows of the relative error of the value and the norm-wise relative
+// error of the gradient against the long double reference, and throughput
+// of forward_batch (rows/s) and value_and_grad (calls/s)
+template <class R, class A>
+static void measure(const char* name, const Tape& t, const std::vector<std::vector<double>>& rows,
+                    const std::vector<long double>& ref_v, const std::vector<std::vector<long double>>& ref_g) {
+  const BasicTape<R, A> tt = tape_cast<R, A>(t);
+  typename BasicTape<R, A>::Workspace ws(tt);
+  const std::size_t n = rows.size(), arity = t.arity;
+  std::vector<R> in(arity);
+  std::vector<A> grad(arity);
+  double err_v = 0.0, err_g = 0.0;
+  for (std::size_t r = 0; r < n; ++r) {
+    for (std::size_t k = 0; k < arity; ++k) in[k] = R(rows[r][k]);
+    const long double v = tt.value_and_grad(in.data(), ws, grad.data());
+    err_v = std::max(err_v, double(std::fabs(v - ref_v[r]) / std::max(std::fabs(ref_v[r]), 1e-300L)));
+    long double d = 0.0L, g = 0.0L;
+    for (std::size_t k = 0; k < arity; ++k) {
+      d = std::max(d, std::fabs(grad[k] - ref_g[r][k]));
+      g = std::max(g, std::fabs(ref_g[r][k]));
+    }
+    err_g = std::max(err_g, double(d / std::max(g, 1e-300L)));
+  }
+  std::vector<std::vector<R>> cols(arity, std::vector<R>(n));
+  std::vector<const R*> ptrs(arity);
+  for (std::size_t k = 0; k < arity; ++k) {
+    for (std::size_t r = 0; r < n; ++r) cols[k][r] = R(rows[r][k]);
+    ptrs[k] = cols[k].data();
+  }
+  std::vector<R> out(n);
+  const double tb = best_seconds([&] { tt.forward_batch(ptrs.data(), n, out.data(), ws); });
+  const std::size_t calls = std::min<std::size_t>(n, 200);
+  const double tg = best_seconds([&] {
+    for (std::size_t r = 0; r < calls; ++r) {
+      for (std::size_t k = 0; k < arity; ++k) in[k] = cols[k][r];
+      tt.value_and_grad(in.data(), ws, grad.data());
+    }
+  });
+  std::printf("%-20s | value err %9.2e  grad err %9.2e | batch %10.0f rows/s | value_and_grad %9.0f calls/s\n",
+              name, err_v, err_g, double(n) / tb, double(calls) / tg);
+}
+
+// Accuracy versus throughput of the scalar instantiations of one tape:
+// bench_tape_scalar [nodes] [rows]
+int main(int argc, char** argv) {
+  const std::size_t nodes = argc > 1 ? std::stoul(argv[1]) : 20000;
+  const std::size_t n = argc > 2 ? std::stoul(argv[2]) : 2048;
+  const Tape t = random_tape(nodes, 8, 17, { 0, true, 2000 });
+
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<double> U(-1.0, 1.0);
+  std::vector<std::vector<double>> rows(n, std::vector<double>(t.arity));
+  for (auto& row : rows) for (auto& v : row) v = U(rng);
+
+  // long double reference
+  const BasicTape<long double> ref = tape_cast<long double>(t);
+  BasicTape<long double>::Workspace ws(ref);
+  std::vector<long double> ref_v(n), in(t.arity);
+  std::vector<std::vector<long double>> ref_g(n, std::vector<long double>(t.arity));
+  for (std::size_t r = 0; r < n; ++r) {
+    for (std::size_t k = 0; k < t.arity; ++k) in[k] = rows[r][k];
+    ref_v[r] = ref.value_and_grad(in.data(), ws, ref_g[r].data());
+  }
+
+  std::printf("tape nodes: %zu, rows: %zu; errors relative to long double\n", t.nodes.size(), n);
+  measure<float, float>("float", t, rows, ref_v, ref_g);
+  measure<float, double>("float, double acc", t, rows, ref_v, ref_g);
+  measure<double, double>("double", t, rows, ref_v, ref_g);
+  measure<long double, long double>("long double", t, rows, ref_v, ref_g);
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_threaded.hpp"
+
+#include "random_tape.hpp"
+
+using namespace et;
+
+template <class E>
+static Tape tape_of(const E& e) {
+  TapeBackend tb(3);
+  tb.tape.output_id = compile_runtime(compile_to_runtime(e, true), tb);
+  return tb.tape;
+}
+
+// ns per forward and per backward call for one engine configuration
+static void measure(const char* name, const Tape& t, std::size_t evals) {
+  using clock = std::chrono::steady_clock;
+  const ThreadedTape plain(t, false), super(t, true);
+  std::mt19937 rng(9);
+  std::uniform_real_distribution<double> U(0.5, 1.5);
+  std::vector<std::vector<double>> pts(64, std::vector<double>(t.arity));
+  for (auto& p : pts) for (auto& v : p) v = U(rng);
+  Tape::Workspace ws(t);
+  std::vector<double> grad(t.arity);
+  volatile double sink = 0.0;
+
+  auto time = [&](auto&& call) {
+    double best = 1e300;
+    for (int rep = 0; rep < 5; ++rep) {
+      auto t0 = clock::now();
+      for (std::size_t k = 0; k < evals; ++k) sink = sink + call(pts[k % pts.size()].data());
+      best = std::min(best, std::chrono::duration<double, std::nano>(clock::now() - t0).count() / double(evals));
+    }
+    return best;
+  };
+  const double sf = time([&](const double* in) { return t.forward(in, ws); });
+  const double pf = time([&](const double* in) { return plain.forward(in, ws); });
+  const double tf = time([&](const double* in) { return super.forward(in, ws); });
+  const double sb = time([&](const double* in) { return t.backward(in, ws, grad.data()); });
+  const double pb = time([&](const double* in) { return plain.backward(in, ws, grad.data()); });
+  const double tb = time([&](const double* in) { return super.backward(in, ws, grad.data()); });
+  std::printf("%-14s %6zu nodes %5zu supers | forward ns: switch %9.1f threaded %9.1f +super %9.1f (%.2fx)"
+              " | backward ns: switch %9.1f threaded %9.1f +super %9.1f (%.2fx)\n",
+              name, t.nodes.size(), super.supers, sf, pf, tf, sf / tf, sb, pb, tb, sb / tb);
+}
+
+// Switch interpreter vs threaded engine (with and without superinstructions)
+// on the examples' expressions and a random tape: bench_tape_threaded [nodes]
+int main(int argc, char** argv) {
+  const std::size_t n = argc > 1 ? std::stoul(argv[1]) : 10000;
+  std::printf("dispatch: %s\n", ThreadedTape::computed_goto() ? "computed goto" : "handler pointers");
+  auto [x,y,z] = Vars<double,3>();
+  measure("01 basic", tape_of(sin(x)*y + z*z), 2000000);
+  measure("06 ops+cse", tape_of(exp(x)*tanh(y) + log(z) + exp(x)*tanh(y) + sqrt(z*z)), 2000000);
+  auto g = exp(x)*tanh(y);
+  measure("07 hash cse", tape_of(g + log(z) + g + sqrt(z*z) + g), 2000000);
+  measure("08 rewrite", tape_of(sin(x)*sin(x) + cos(x)*cos(x) + (lit(2.0)*x + lit(3.0)*x)), 2000000);
+  measure("random", random_tape(n, 4, 11), 20000000 / n);
+  return 0;
+}
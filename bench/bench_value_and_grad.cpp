@@ -0,0 +1,63 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+
+#include "random_tape.hpp"
+
+using namespace et;
+
+template <class E>
+static Tape tape_of(const E& e) {
+  TapeBackend tb(3);
+  tb.tape.output_id = compile_runtime(compile_to_runtime(e, true), tb);
+  return tb.tape;
+}
+
+// ns per call: forward, backward (forward + recomputing reverse) and
+// value_and_grad (forward with local partials + multiply-accumulate reverse)
+static void measure(const char* name, const Tape& t, std::size_t evals) {
+  using clock = std::chrono::steady_clock;
+  std::mt19937 rng(9);
+  std::uniform_real_distribution<double> U(0.5, 1.5);
+  std::vector<std::vector<double>> pts(64, std::vector<double>(t.arity));
+  for (auto& p : pts) for (auto& v : p) v = U(rng);
+  Tape::Workspace ws(t);
+  std::vector<double> grad(t.arity);
+  volatile double sink = 0.0;
+  auto time = [&](auto&& call) {
+    double best = 1e300;
+    for (int rep = 0; rep < 5; ++rep) {
+      auto t0 = clock::now();
+      for (std::size_t k = 0; k < evals; ++k) sink = sink + call(pts[k % pts.size()].data());
+      best = std::min(best, std::chrono::duration<double, std::nano>(clock::now() - t0).count() / double(evals));
+    }
+    return best;
+  };
+  const double f = time([&](const double* in) { return t.forward(in, ws); });
+  const double b = time([&](const double* in) { return t.backward(in, ws, grad.data()); });
+  const double vg = time([&](const double* in) { return t.value_and_grad(in, ws, grad.data()); });
+  std::printf("%-12s %6zu nodes | forward %9.1f ns | backward %9.1f ns | value_and_grad %9.1f ns (%.2fx, %.2f forwards)\n",
+              name, t.nodes.size(), f, b, vg, b / vg, vg / f);
+}
+
+// backward vs value_and_grad on the examples' expressions and a random,
+// transcendental-heavy tape: bench_value_and_grad [nodes]
+int main(int argc, char** argv) {
+  const std::size_t n = argc > 1 ? std::stoul(argv[1]) : 10000;
+  auto [x,y,z] = Vars<double,3>();
+  measure("01 basic", tape_of(sin(x)*y + z*z), 2000000);
+  measure("06 ops+cse", tape_of(exp(x)*tanh(y) + log(z) + exp(x)*tanh(y) + sqrt(z*z)), 2000000);
+  auto g = exp(x)*tanh(y);
+  measure("07 hash cse", tape_of(g + log(z) + g + sqrt(z*z) + g), 2000000);
+  measure("pow", tape_of(pow(x, y) * pow(y, z) + pow(z, x)), 2000000);
+  measure("random", random_tape(n, 4, 11), 20000000 / n);
+  return 0;
+}
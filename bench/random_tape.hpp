@@ -0,0 +1,61 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/tape_backend.hpp"
+
+// Random tape fixture shared by the tape benchmarks (and, through
+// tests/random_tape.hpp, the tape tests)
+struct RandomTapeShape {
+  std::size_t window = 40; // operands come from the last `window` values; 0: from anywhere
+  bool reductions = false; // one op in eight is the mean of 32 values (an n-ary sum)
+  std::size_t tail = 0;    // output is the n-ary sum of the last `tail` values; 0: the last value
+};
+
+// Random DAG of n instructions over `vars` inputs with bounded values. A small
+// window gives a deep, narrow tape and a large one (or 0) a wide, shallow tape
+inline et::Tape random_tape(std::size_t n, std::size_t vars, unsigned seed, const RandomTapeShape& shape = {}) {
+  using namespace et;
+  TapeBackend tb(vars);
+  std::mt19937 rng(seed);
+  std::vector<int> pool;
+  for (std::size_t v = 0; v < vars; ++v) pool.push_back(tb.emitVar<double>(v));
+  pool.push_back(tb.emitConst(Const<double>{ 0.75 }));
+  auto pick = [&]() {
+    const std::size_t w = shape.window ? std::min(pool.size(), shape.window) : pool.size();
+    return pool[pool.size() - 1 - rng() % w];
+  };
+  while (tb.tape.nodes.size() < n) {
+    const int a = pick(), b = pick();
+    int r;
+    switch (rng() % 8) {
+      case 0: r = tb.emitApply(AddOp{}, a, b); break;
+      case 1: r = tb.emitApply(SubOp{}, a, b); break;
+      case 2: r = tb.emitApply(MulOp{}, a, b); break;
+      case 3: r = tb.emitApply(SinOp{}, tb.emitApply(AddOp{}, a, b)); break;
+      case 4: r = tb.emitApply(CosOp{}, a); break;
+      case 5: r = tb.emitApply(TanhOp{}, tb.emitApply(MulOp{}, a, b)); break;
+      case 6:
+        if (shape.reductions) {
+          std::vector<int> ids(32);
+          for (auto& id : ids) id = pick();
+          r = tb.emitApply(MulOp{}, tb.emitConst(Const<double>{ 1.0 / 32 }), tb.emitNary(AddOp{}, ids));
+        } else {
+          r = tb.emitApply(DivOp{}, a, tb.emitApply(ExpOp{}, tb.emitApply(SinOp{}, b)));
+        }
+        break;
+      default: r = tb.emitApply(TanhOp{}, tb.emitApply(SubOp{}, a, b)); break;
+    }
+    pool.push_back(r);
+  }
+  if (shape.tail) {
+    std::vector<int> last(pool.end() - std::min(pool.size(), shape.tail), pool.end());
+    tb.tape.output_id = tb.emitNary(AddOp{}, last);
+  } else {
+    tb.tape.output_id = pool.back();
+  }
+  return tb.tape;
+}
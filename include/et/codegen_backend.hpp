@@ -0,0 +1,298 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#include <unistd.h>
+#define ET_CODEGEN_DLOPEN 1
+#endif
+
+#include "et/tape_backend.hpp"
+
+namespace et {
+
+// C++ source printer for a Tape. For the output node (output_id) it emits
+// three extern "C" functions of straight-line code over the nodes the output
+// depends on, one local per instruction:
+//   double <name>_value(const double* in);
+//   double <name>_grad(const double* in, double* grad);   // grad[arity], returns the value
+//   void   <name>_batch(const double* const* cols, std::size_t n, double* out);
+// The gradient is the tape's reverse sweep unrolled, with one adjoint local per
+// node; adjoints of constants are never formed. Every Tape kind, including the
+// fused ones from fuse_tape, is printed with the same semantics as the
+// interpreter. The batch loop is marked `omp simd` so rows vectorize under
+// -fopenmp-simd; its elementary functions are scalar libm calls, so
+// Tape::forward_batch (vmath kernels) stays ahead on transcendental-heavy
+// batches. The source needs only <cmath> and C++17 (hex float literals).
+inline std::string codegen_source(const Tape& t, const std::string& name = "et_fn") {
+  using K = Tape::Kind;
+  const int N = (int)t.nodes.size();
+  const int out = t.output_id;
+  std::vector<char> live(N, 0);
+  if (out >= 0) live[out] = 1;
+  for (int i = out; i >= 0; --i) {
+    if (!live[i]) continue;
+    const auto& n = t.nodes[i];
+    t.for_each_operand(n, [&](int j){ live[j] = 1; });
+    if (n.kind == K::KSinCos) live[i + 1] = 1; // the pair is evaluated together
+    if (n.kind == K::KCosPair) live[i - 1] = 1;
+  }
+  // last value computed: past the output when it is a KSinCos
+  const int last = out >= 0 && t.nodes[out].kind == K::KSinCos ? out + 1 : out;
+
+  auto v = [](int i) { return "v" + std::to_string(i); };
+  auto g = [](int i) { return "a" + std::to_string(i); };
+  auto literal = [](double c) {
+    if (std::isnan(c)) return std::string("std::numeric_limits<double>::quiet_NaN()");
+    if (std::isinf(c)) return std::string(c < 0 ? "-" : "") + "std::numeric_limits<double>::infinity()";
+    std::ostringstream os;
+    os << std::hexfloat << c;
+    return os.str();
+  };
+  // batch: inputs are columns cols[k][r] rather than in[k]
+  auto value_expr = [&](const Tape::Node& n, bool batch) -> std::string {
+    const std::string a = n.a >= 0 ? v(n.a) : "", b = n.b >= 0 ? v(n.b) : "";
+    switch (n.kind) {
+      case K::KVar:     return batch ? "cols[" + std::to_string(n.var_index) + "][r]"
+                                 : "in[" + std::to_string(n.var_index) + "]";
+      case K::KConst:   return literal(n.c);
+      case K::KAdd:     return a + " + " + b;
+      case K::KSub:     return a + " - " + b;
+      case K::KMul:     return a + " * " + b;
+      case K::KDiv:     return a + " / " + b;
+      case K::KPow:     return "std::pow(" + a + ", " + b + ")";
+      case K::KNeg:     return "-" + a;
+      case K::KSin: case K::KSinCos:  return "std::sin(" + a + ")";
+      case K::KCos: case K::KCosPair: return "std::cos(" + a + ")";
+      case K::KExp:     return "std::exp(" + a + ")";
+      case K::KLog:     return "std::log(" + a + ")";
+      case K::KSqrt:    return "std::sqrt(" + a + ")";
+      case K::KTanh:    return "std::tanh(" + a + ")";
+      case K::KRecip:   return "1.0 / " + a;
+      case K::KRsqrt:   return "1.0 / std::sqrt(" + a + ")";
+      case K::KFma:     return a + " * " + b + " + " + v(n.e);
+      case K::KFms:     return a + " * " + b + " - " + v(n.e);
+      case K::KSquare:  return a + " * " + a;
+      case K::KSum: case K::KProd: {
+        std::string s;
+        for (int k = 0; k < n.b; ++k) s += (k ? (n.kind == K::KSum ? " + " : " * ") : "") + v(t.args[n.a + k]);
+        return s; }
+    }
+    return "0.0";
+  };
+  auto forward = [&](std::ostringstream& os, const char* indent, bool batch) {
+    for (int i = 0; i <= last; ++i)
+      if (live[i]) os << indent << "const double " << v(i) << " = " << value_expr(t.nodes[i], batch) << ";\n";
+  };
+  // adj += term (or -=), skipped for constant operands whose adjoint is unused
+  auto acc = [&](std::ostringstream& os, int j, const char* op, const std::string& term) {
+    if (t.nodes[j].kind != K::KConst) os << "  " << g(j) << " " << op << " " << term << ";\n";
+  };
+  auto reverse = [&](std::ostringstream& os, int i) {
+    const auto& n = t.nodes[i];
+    const std::string gi = g(i);
+    switch (n.kind) {
+      case K::KVar: case K::KConst: break;
+      case K::KAdd:    acc(os, n.a, "+=", gi); acc(os, n.b, "+=", gi); break;
+      case K::KSub:    acc(os, n.a, "+=", gi); acc(os, n.b, "-=", gi); break;
+      case K::KMul:    acc(os, n.a, "+=", gi + " * " + v(n.b)); acc(os, n.b, "+=", gi + " * " + v(n.a)); break;
+      case K::KDiv:
+        acc(os, n.a, "+=", gi + " / " + v(n.b));
+        acc(os, n.b, "-=", gi + " * " + v(n.a) + " / (" + v(n.b) + " * " + v(n.b) + ")");
+        break;
+      case K::KPow:
+        acc(os, n.a, "+=", gi + " * (" + v(n.b) + " * std::pow(" + v(n.a) + ", " + v(n.b) + " - 1.0))");
+        acc(os, n.b, "+=", gi + " * " + v(i) + " * std::log(" + v(n.a) + ")");
+        break;
+      case K::KNeg:    acc(os, n.a, "-=", gi); break;
+      case K::KSin:    acc(os, n.a, "+=", gi + " * std::cos(" + v(n.a) + ")"); break;
+      case K::KCos:    acc(os, n.a, "-=", gi + " * std::sin(" + v(n.a) + ")"); break;
+      case K::KExp:    acc(os, n.a, "+=", gi + " * " + v(i)); break;
+      case K::KLog:    acc(os, n.a, "+=", gi + " / " + v(n.a)); break;
+      case K::KSqrt:   acc(os, n.a, "+=", gi + " * (0.5 / " + v(i) + ")"); break;
+      case K::KTanh:   acc(os, n.a, "+=", gi + " * (1.0 - " + v(i) + " * " + v(i) + ")"); break;
+      case K::KRecip:  acc(os, n.a, "-=", gi + " * (" + v(i) + " * " + v(i) + ")"); break;
+      case K::KRsqrt:  acc(os, n.a, "-=", gi + " * (0.5 * (" + v(i) + " * " + v(i) + " * " + v(i) + "))"); break;
+      case K::KFma: case K::KFms:
+        acc(os, n.a, "+=", gi + " * " + v(n.b));
+        acc(os, n.b, "+=", gi + " * " + v(n.a));
+        acc(os, n.e, n.kind == K::KFma ? "+=" : "-=", gi);
+        break;
+      case K::KSquare:   acc(os, n.a, "+=", gi + " * (2.0 * " + v(n.a) + ")"); break;
+      case K::KSinCos:   acc(os, n.a, "+=", gi + " * " + v(i + 1)); break;
+      case K::KCosPair:  acc(os, n.a, "-=", gi + " * " + v(i - 1)); break;
+      case K::KSum:
+        for (int k = 0; k < n.b; ++k) acc(os, t.args[n.a + k], "+=", gi);
+        break;
+      case K::KProd: { // prefix and suffix products, as the interpreter: linear, and zeros are exact
+        const int* q = &t.args[n.a];
+        auto p = [](int k) { return "p" + std::to_string(k); };
+        os << "  {\n    const double " << p(0) << " = " << gi << ";\n";
+        for (int k = 1; k < n.b; ++k) os << "    const double " << p(k) << " = " << p(k - 1) << " * " << v(q[k - 1]) << ";\n";
+        os << "    double s = 1.0;\n";
+        for (int k = n.b - 1; k >= 0; --k) {
+          if (t.nodes[q[k]].kind != K::KConst) os << "    " << g(q[k]) << " += " << p(k) << " * s;\n";
+          if (k > 0) os << "    s *= " << v(q[k]) << ";\n";
+        }
+        os << "  }\n";
+        break; }
+    }
+  };
+
+  std::ostringstream os;
+  os << "// Generated by et::codegen_source\n#include <cmath>\n#include <cstddef>\n#include <limits>\n\nextern \"C\" {\n\n";
+  os << "double " << name << "_value(const double* in) {\n";
+  forward(os, "  ", false);
+  os << "  return " << (out >= 0 ? v(out) : "0.0") << ";\n}\n\n";
+
+  os << "double " << name << "_grad(const double* in, double* grad) {\n";
+  forward(os, "  ", false);
+  for (std::size_t j = 0, A = t.input_count(); j < A; ++j) os << "  grad[" << j << "] = 0.0;\n";
+  if (out >= 0) {
+    for (int i = 0; i < out; ++i)
+      if (live[i] && t.nodes[i].kind != K::KConst) os << "  double " << g(i) << " = 0.0;\n";
+    os << "  const double " << g(out) << " = 1.0;\n";
+    for (int i = out; i >= 0; --i) {
+      if (!live[i]) continue;
+      reverse(os, i);
+      if (t.nodes[i].kind == K::KVar) os << "  grad[" << t.nodes[i].var_index << "] += " << g(i) << ";\n";
+    }
+  }
+  os << "  return " << (out >= 0 ? v(out) : "0.0") << ";\n}\n\n";
+
+  os << "void " << name << "_batch(const double* const* cols, std::size_t n, double* out) {\n";
+  os << "  #pragma omp simd\n  for (std::size_t r = 0; r < n; ++r) {\n";
+  forward(os, "    ", true);
+  os << "    out[r] = " << (out >= 0 ? v(out) : "0.0") << ";\n  }\n}\n\n} // extern \"C\"\n";
+  return os.str();
+}
+
+// Compiler invocation for compile_and_load
+struct CodegenOptions {
+  std::string compiler;                    // empty: $CXX, else "c++"
+  std::string flags = "-O3 -fopenmp-simd"; // appended after -std=c++17 -shared -fPIC
+  std::string dir;                         // parent of the private build directory; empty: $TMPDIR, else /tmp
+  bool keep_files = false;                 // leave the build directory and its .cpp/.so/.log behind
+};
+
+// Functions loaded from a compiled codegen_source; owns the library handle.
+struct CompiledTape {
+  using ValueFn = double (*)(const double*);
+  using GradFn  = double (*)(const double*, double*);
+  using BatchFn = void (*)(const double* const*, std::size_t, double*);
+  ValueFn value = nullptr;
+  GradFn  grad  = nullptr;
+  BatchFn batch = nullptr;
+  std::size_t arity = 0;
+
+  CompiledTape() = default;
+  CompiledTape(const CompiledTape&) = delete;
+  CompiledTape& operator=(const CompiledTape&) = delete;
+  CompiledTape(CompiledTape&& o) noexcept { swap(o); }
+  CompiledTape& operator=(CompiledTape&& o) noexcept { CompiledTape tmp(std::move(o)); swap(tmp); return *this; }
+  ~CompiledTape() { close(); }
+
+  explicit operator bool() const { return value != nullptr; }
+
+  void close() {
+#ifdef ET_CODEGEN_DLOPEN
+    if (handle) dlclose(handle);
+#endif
+    handle = nullptr; value = nullptr; grad = nullptr; batch = nullptr;
+  }
+
+  double forward(const std::vector<double>& in) const { return value(in.data()); }
+  std::vector<double> backward(const std::vector<double>& in) const {
+    std::vector<double> gr(arity);
+    grad(in.data(), gr.data());
+    return gr;
+  }
+
+  void* handle = nullptr;
+
+private:
+  void swap(CompiledTape& o) noexcept {
+    std::swap(value, o.value); std::swap(grad, o.grad); std::swap(batch, o.batch);
+    std::swap(arity, o.arity); std::swap(handle, o.handle);
+  }
+};
+
+// Prints t, builds it as a shared library with the system compiler and loads
+// it into out. Returns false (with the compiler output in *log when given) if
+// compilation or loading fails, or when dlopen is unavailable on the platform.
+inline bool compile_and_load(const Tape& t, CompiledTape& out, const CodegenOptions& opt = {},
+                             std::string* log = nullptr, const std::string& name = "et_fn") {
+  out.close();
+#ifdef ET_CODEGEN_DLOPEN
+  std::string dir = opt.dir;
+  if (dir.empty()) { const char* d = std::getenv("TMPDIR"); dir = d && *d ? d : "/tmp"; }
+  std::string cxx = opt.compiler;
+  if (cxx.empty()) { const char* c = std::getenv("CXX"); cxx = c && *c ? c : "c++"; }
+  // Build and load inside a fresh mode-0700 directory, so no other user can
+  // plant or swap the library between compiling and dlopen
+  std::string tmpl = dir + "/et_codegen_XXXXXX";
+  if (!::mkdtemp(&tmpl[0])) { if (log) *log = "cannot create a private directory under " + dir; return false; }
+  const std::string base = tmpl + "/" + name;
+  const std::string src = base + ".cpp", so = base + ".so", lg = base + ".log";
+  auto cleanup = [&]() {
+    if (opt.keep_files) return;
+    std::remove(src.c_str()); std::remove(so.c_str()); std::remove(lg.c_str());
+    ::rmdir(tmpl.c_str());
+  };
+  {
+    std::ofstream f(src);
+    if (!f) { if (log) *log = "cannot write " + src; cleanup(); return false; }
+    f << codegen_source(t, name);
+  }
+  // single-quoted for the shell, with embedded quotes as '\''
+  auto quote = [](const std::string& p) {
+    std::string r = "'";
+    for (char c : p) r += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    return r + "'";
+  };
+  const std::string cmd = cxx + " -std=c++17 -shared -fPIC " + opt.flags + " -o " + quote(so) + " " + quote(src)
+                        + " > " + quote(lg) + " 2>&1";
+  const int rc = std::system(cmd.c_str());
+  if (log) { std::ifstream f(lg); *log = std::string(std::istreambuf_iterator<char>(f), {}); }
+  void* h = rc == 0 ? dlopen(so.c_str(), RTLD_NOW | RTLD_LOCAL) : nullptr;
+  if (!h && rc == 0 && log) *log += dlerror();
+  cleanup();
+  if (!h) return false;
+  out.handle = h;
+  out.value = reinterpret_cast<CompiledTape::ValueFn>(dlsym(h, (name + "_value").c_str()));
+  out.grad  = reinterpret_cast<CompiledTape::GradFn>(dlsym(h, (name + "_grad").c_str()));
+  out.batch = reinterpret_cast<CompiledTape::BatchFn>(dlsym(h, (name + "_batch").c_str()));
+  out.arity = t.input_count();
+  if (!out.value || !out.grad || !out.batch) { out.close(); return false; }
+  return true;
+#else
+  (void)t; (void)opt; (void)name;
+  if (log) *log = "dlopen is not available on this platform";
+  return false;
+#endif
+}
+
+// Codegen backend: records through the TapeBackend contract (emitVar,
+// emitConst, emitApply, emitNary), so compile, compile_cse, compile_hash_cse
+// and compile_runtime all drive it unchanged, then prints or builds the
+// recorded program.
+struct CodegenBackend : TapeBackend {
+  using TapeBackend::TapeBackend;
+
+  std::string source(const std::string& name = "et_fn") const { return codegen_source(tape, name); }
+
+  bool build(CompiledTape& out, const CodegenOptions& opt = {}, std::string* log = nullptr) const {
+    return compile_and_load(tape, out, opt, log);
+  }
+};
+
+} // namespace et
@@ -27,6 +27,8 @@ template <> inline const char* op_name<ExpOp>() { return "Exp"; }
 template <> inline const char* op_name<LogOp>() { return "Log"; }
 template <> inline const char* op_name<SqrtOp>() { return "Sqrt"; }
 template <> inline const char* op_name<TanhOp>() { return "Tanh"; }
+template <> inline const char* op_name<RecipOp>() { return "Recip"; }
+template <> inline const char* op_name<RsqrtOp>() { return "Rsqrt"; }
 
 template <class Op, class... Ch>
 inline void to_key_stream(std::ostream& os, const Apply<Op,Ch...>& a) {
@@ -29,6 +29,8 @@ template<> struct op_id<ExpOp>  { static constexpr std::uint64_t value = 0x32; }
 template<> struct op_id<LogOp>  { static constexpr std::uint64_t value = 0x33; };
 template<> struct op_id<SqrtOp> { static constexpr std::uint64_t value = 0x34; };
 template<> struct op_id<TanhOp> { static constexpr std::uint64_t value = 0x35; };
+template<> struct op_id<RecipOp> { static constexpr std::uint64_t value = 0x36; };
+template<> struct op_id<RsqrtOp> { static constexpr std::uint64_t value = 0x37; };
 
 // --- structural key for collision checks --------------------------------
 template <class Expr> inline void to_key_stream(std::ostream& os, const Expr&);
@@ -136,4 +138,12 @@ auto compile_hash_cse(const Expr& e, Backend& b) -> typename Backend::result_typ
   return H(e);
 }
 
+// Shared-memo variant: compiling several expressions into one backend with the
+// same memo emits each common subexpression once (e.g. multi-output tapes)
+template <class Backend, class Expr>
+auto compile_hash_cse(const Expr& e, Backend& b, HashMemo<Backend>& memo) -> typename Backend::result_type {
+  HashCSEHelper<Backend> H{b, memo};
+  return H(e);
+}
+
 } // namespace et
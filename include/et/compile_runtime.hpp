@@ -1,72 +1,123 @@
 #pragma once
 #include <vector>
 #include <type_traits>
+#include <utility>
 
 #include "et/runtime_ast.hpp"
 #include "et/expr.hpp"
 
 namespace et {
 
+// How normalized n-ary Add/Mul nodes are lowered
+enum class Reduction {
+  Native,   // one b.emitNary(op, ids) instruction if the backend has it, else Chain
+  Chain,    // left-leaning chain of binary emitApply calls
+  Pairwise  // balanced tree of binary calls: log-depth dependencies, smaller rounding growth
+};
+
+template <class B, class = void>
+struct has_emit_nary : std::false_type {};
+template <class B>
+struct has_emit_nary<B, std::void_t<decltype(std::declval<B&>().emitNary(
+    AddOp{}, std::declval<const std::vector<typename B::result_type>&>()))>> : std::true_type {};
+
+namespace detail {
+template <class Op, class Backend, class R>
+R reduce_binary(Backend& b, const std::vector<R>& xs, std::size_t lo, std::size_t hi, bool pairwise) {
+  if (hi - lo == 1) return xs[lo];
+  if (pairwise) {
+    const std::size_t mid = lo + (hi - lo) / 2;
+    R l = reduce_binary<Op>(b, xs, lo, mid, true);
+    R r = reduce_binary<Op>(b, xs, mid, hi, true);
+    return b.emitApply(Op{}, l, r);
+  }
+  R acc = xs[lo];
+  for (std::size_t i = lo + 1; i < hi; ++i) acc = b.emitApply(Op{}, acc, xs[i]);
+  return acc;
+}
+
+template <class Op, class Backend, class R>
+R emit_reduction(Backend& b, const std::vector<R>& xs, Reduction mode, std::size_t& emitted) {
+  if constexpr (has_emit_nary<Backend>::value)
+    if (mode == Reduction::Native && xs.size() > 2) { ++emitted; return b.emitNary(Op{}, xs); }
+  emitted += xs.size() - 1;
+  return reduce_binary<Op>(b, xs, 0, xs.size(), mode == Reduction::Pairwise);
+}
+} // namespace detail
+
+// Sizes reported by compile_runtime: every reachable RGraph node is lowered
+// exactly once, so `emitted` exceeds `reachable` only by the extra binary
+// instructions of reductions that are not emitted natively.
+struct CompileRuntimeStats {
+  std::size_t graph_nodes = 0; // g.nodes.size()
+  std::size_t reachable = 0;   // distinct nodes reachable from the root
+  std::size_t emitted = 0;     // backend emit calls
+};
+
 // Compile a runtime AST (RGraph) into a Backend using Backend's emitVar/emitConst/emitApply API.
 // Assumes Backend result_type is a handle and Backend supports the ET Op tag mapping.
+// The graph is treated as a DAG: nodes are lowered in iterative post-order and
+// memoized by id, so a node shared by several parents is emitted once.
 template <class Backend>
-inline auto compile_runtime(const RGraph& g, Backend& b) -> typename Backend::result_type {
+inline auto compile_runtime(const RGraph& g, Backend& b, Reduction mode = Reduction::Native,
+                            CompileRuntimeStats* stats = nullptr)
+    -> typename Backend::result_type {
   using R = typename Backend::result_type;
-  std::vector<R> memo(g.nodes.size());
+  const std::size_t N = g.nodes.size();
+  std::vector<R> memo(N);
+  std::vector<char> state(N, 0); // 0 unvisited, 1 children pending, 2 emitted
+  std::size_t reachable = 0, emitted = 0;
+  std::vector<R> xs;
 
-  std::function<R(int)> rec = [&](int id) -> R {
-    const RNode& n = g.nodes[id];
+  auto emit = [&](const RNode& n) -> R {
+    if (n.kind != NodeKind::Add && n.kind != NodeKind::Mul) ++emitted; // reductions count their own
     switch (n.kind) {
-      case NodeKind::Const: {
-        return b.template emitConst<double>(Const<double>{ static_cast<double>(n.cval) });
-      }
-      case NodeKind::Var: {
-        return b.template emitVar<double>(n.var_index);
-      }
-      case NodeKind::Neg: {
-        auto a = rec(n.ch[0]);
-        return b.emitApply(NegOp{}, a);
-      }
-      case NodeKind::Sin: { auto a = rec(n.ch[0]); return b.emitApply(SinOp{}, a); }
-      case NodeKind::Cos: { auto a = rec(n.ch[0]); return b.emitApply(CosOp{}, a); }
-      case NodeKind::Exp: { auto a = rec(n.ch[0]); return b.emitApply(ExpOp{}, a); }
-      case NodeKind::Log: { auto a = rec(n.ch[0]); return b.emitApply(LogOp{}, a); }
-      case NodeKind::Sqrt:{ auto a = rec(n.ch[0]); return b.emitApply(SqrtOp{}, a); }
-      case NodeKind::Tanh:{ auto a = rec(n.ch[0]); return b.emitApply(TanhOp{}, a); }
-      case NodeKind::Sub: {
-        auto a = rec(n.ch[0]); auto c = rec(n.ch[1]);
-        return b.emitApply(SubOp{}, a, c);
-      }
-      case NodeKind::Div: {
-        auto a = rec(n.ch[0]); auto c = rec(n.ch[1]);
-        return b.emitApply(DivOp{}, a, c);
-      }
-      case NodeKind::Pow: {
-        auto a = rec(n.ch[0]); auto c = rec(n.ch[1]);
-        return b.emitApply(PowOp{}, a, c);
-      }
-      case NodeKind::Add: {
-        auto acc = rec(n.ch[0]);
-        for (std::size_t i = 1; i < n.ch.size(); ++i) {
-          auto rhs = rec(n.ch[i]);
-          acc = b.emitApply(AddOp{}, acc, rhs);
-        }
-        return acc;
-      }
+      case NodeKind::Const: return b.template emitConst<double>(Const<double>{ static_cast<double>(n.cval) });
+      case NodeKind::Var:   return b.template emitVar<double>(n.var_index);
+      case NodeKind::Neg:   return b.emitApply(NegOp{}, memo[n.ch[0]]);
+      case NodeKind::Sin:   return b.emitApply(SinOp{}, memo[n.ch[0]]);
+      case NodeKind::Cos:   return b.emitApply(CosOp{}, memo[n.ch[0]]);
+      case NodeKind::Exp:   return b.emitApply(ExpOp{}, memo[n.ch[0]]);
+      case NodeKind::Log:   return b.emitApply(LogOp{}, memo[n.ch[0]]);
+      case NodeKind::Sqrt:  return b.emitApply(SqrtOp{}, memo[n.ch[0]]);
+      case NodeKind::Tanh:  return b.emitApply(TanhOp{}, memo[n.ch[0]]);
+      case NodeKind::Recip: return b.emitApply(RecipOp{}, memo[n.ch[0]]);
+      case NodeKind::Rsqrt: return b.emitApply(RsqrtOp{}, memo[n.ch[0]]);
+      case NodeKind::Sub:   return b.emitApply(SubOp{}, memo[n.ch[0]], memo[n.ch[1]]);
+      case NodeKind::Div:   return b.emitApply(DivOp{}, memo[n.ch[0]], memo[n.ch[1]]);
+      case NodeKind::Pow:   return b.emitApply(PowOp{}, memo[n.ch[0]], memo[n.ch[1]]);
+      case NodeKind::Add:
       case NodeKind::Mul: {
-        auto acc = rec(n.ch[0]);
-        for (std::size_t i = 1; i < n.ch.size(); ++i) {
-          auto rhs = rec(n.ch[i]);
-          acc = b.emitApply(MulOp{}, acc, rhs);
-        }
-        return acc;
+        xs.clear();
+        for (int c : n.ch) xs.push_back(memo[c]);
+        if (n.kind == NodeKind::Add) return detail::emit_reduction<AddOp>(b, xs, mode, emitted);
+        return detail::emit_reduction<MulOp>(b, xs, mode, emitted);
       }
     }
     // Unreachable
     return b.template emitConst<double>(Const<double>{0.0});
   };
 
-  return rec(g.root);
+  std::vector<int> stack{ g.root };
+  while (!stack.empty()) {
+    const int id = stack.back();
+    if (state[id] == 2) { stack.pop_back(); continue; }
+    const RNode& n = g.nodes[id];
+    if (state[id] == 0) {
+      state[id] = 1;
+      // Push in reverse so children are lowered left to right
+      for (auto it = n.ch.rbegin(); it != n.ch.rend(); ++it)
+        if (state[*it] == 0) stack.push_back(*it);
+      continue;
+    }
+    memo[id] = emit(n);
+    state[id] = 2;
+    ++reachable;
+    stack.pop_back();
+  }
+
+  if (stats) { stats->graph_nodes = N; stats->reachable = reachable; stats->emitted = emitted; }
+  return memo[g.root];
 }
 
 } // namespace et
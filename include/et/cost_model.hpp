@@ -0,0 +1,174 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "et/runtime_ast.hpp"
+
+namespace et {
+
+// Per-NodeKind evaluation cost, used to decide whether a rewrite pays off.
+// Units are nanoseconds per scalar op on the machine that calibrated the
+// model; defaults() holds typical relative values. An n-ary Add/Mul costs
+// n-1 binary ops; Var/Const are free.
+struct CostModel {
+  static constexpr std::size_t kKinds = kNodeKinds;
+  std::array<double, kKinds> unit{};
+
+  static const char* kind_name(NodeKind k) {
+    static const char* names[kKinds] = { "Var", "Const", "Add", "Sub", "Mul", "Div", "Pow",
+                                         "Neg", "Sin", "Cos", "Exp", "Log", "Sqrt", "Tanh",
+                                         "Recip", "Rsqrt" };
+    return names[std::size_t(k)];
+  }
+
+  static CostModel defaults() {
+    CostModel m;
+    auto set = [&](NodeKind k, double v) { m.unit[std::size_t(k)] = v; };
+    set(NodeKind::Add, 1);  set(NodeKind::Sub, 1);  set(NodeKind::Mul, 1);  set(NodeKind::Neg, 1);
+    set(NodeKind::Div, 4);  set(NodeKind::Sqrt, 5);  set(NodeKind::Recip, 4); set(NodeKind::Rsqrt, 6);
+    set(NodeKind::Exp, 15); set(NodeKind::Log, 15);
+    set(NodeKind::Sin, 20); set(NodeKind::Cos, 20); set(NodeKind::Tanh, 20);
+    set(NodeKind::Pow, 40);
+    return m;
+  }
+
+  // Times each operator over n scalars (best of `reps` sweeps) on this machine
+  static CostModel calibrate(std::size_t n = 4096, int reps = 7) {
+    CostModel m;
+    std::vector<double> a(n), b(n), out(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      a[i] = 0.5 + 1.5 * double(i % 97) / 97.0; // positive, away from 0: valid for log/sqrt/pow/div
+      b[i] = 0.25 + double(i % 89) / 89.0;
+    }
+    volatile double sink = 0.0;
+    auto time = [&](auto op) {
+      double best = 1e300;
+      for (int r = 0; r < reps; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < n; ++i) out[i] = op(a[i], b[i]);
+        auto t1 = std::chrono::steady_clock::now();
+        sink = sink + out[n / 2];
+        best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / double(n));
+      }
+      return best;
+    };
+    auto set = [&](NodeKind k, double v) { m.unit[std::size_t(k)] = v; };
+    set(NodeKind::Add,  time([](double x, double y) { return x + y; }));
+    set(NodeKind::Sub,  time([](double x, double y) { return x - y; }));
+    set(NodeKind::Mul,  time([](double x, double y) { return x * y; }));
+    set(NodeKind::Div,  time([](double x, double y) { return x / y; }));
+    set(NodeKind::Pow,  time([](double x, double y) { return std::pow(x, y); }));
+    set(NodeKind::Neg,  time([](double x, double) { return -x; }));
+    set(NodeKind::Sin,  time([](double x, double) { return std::sin(x); }));
+    set(NodeKind::Cos,  time([](double x, double) { return std::cos(x); }));
+    set(NodeKind::Exp,  time([](double x, double) { return std::exp(x); }));
+    set(NodeKind::Log,  time([](double x, double) { return std::log(x); }));
+    set(NodeKind::Sqrt, time([](double x, double) { return std::sqrt(x); }));
+    set(NodeKind::Tanh, time([](double x, double) { return std::tanh(x); }));
+    set(NodeKind::Recip, time([](double x, double) { return 1.0 / x; }));
+    set(NodeKind::Rsqrt, time([](double x, double) { return 1.0 / std::sqrt(x); }));
+    (void)sink;
+    return m;
+  }
+
+  double node_cost(NodeKind k, std::size_t arity) const {
+    if (k == NodeKind::Add || k == NodeKind::Mul) return arity > 1 ? unit[std::size_t(k)] * double(arity - 1) : 0.0;
+    return unit[std::size_t(k)];
+  }
+  double node_cost(const RNode& n) const { return node_cost(n.kind, n.ch.size()); }
+
+  // DAG cost of the graph below `root`: every reachable node counted once, as
+  // it is evaluated once on a tape
+  double cost(const RGraph& g, int root) const {
+    if (root < 0) return 0.0;
+    std::vector<char> seen(g.nodes.size(), 0);
+    std::vector<int> stack{ root };
+    double c = 0.0;
+    while (!stack.empty()) {
+      const int id = stack.back(); stack.pop_back();
+      if (seen[id]) continue;
+      seen[id] = 1;
+      c += node_cost(g.nodes[id]);
+      for (int ch : g.nodes[id].ch) if (!seen[ch]) stack.push_back(ch);
+    }
+    return c;
+  }
+  double cost(const RGraph& g) const { return cost(g, g.root); }
+
+  // Change in cost when node `from` is replaced by `to` in the same graph:
+  // cost of what `to` needs minus cost of what only `from` needed (subterms
+  // both share, typically the bound placeholders, cancel out). On a DAG the
+  // saving is an upper bound: nodes under `from` that other parents still use
+  // are subtracted too. Walks only the two cones; the visited stamps are
+  // scratch reused across calls, so one model is not shared between threads.
+  double rewrite_delta(const RGraph& g, int from, int to) const {
+    if (stamp_from_.size() < g.nodes.size()) {
+      stamp_from_.resize(g.nodes.size(), 0);
+      stamp_to_.resize(g.nodes.size(), 0);
+    }
+    if (++epoch_ == 0) { // wrapped: old stamps could alias
+      std::fill(stamp_from_.begin(), stamp_from_.end(), 0u);
+      std::fill(stamp_to_.begin(), stamp_to_.end(), 0u);
+      epoch_ = 1;
+    }
+    auto reach = [&](int root, std::vector<std::uint32_t>& stamp, std::vector<int>& list) {
+      list.clear();
+      stack_.assign(1, root);
+      while (!stack_.empty()) {
+        const int id = stack_.back(); stack_.pop_back();
+        if (stamp[id] == epoch_) continue;
+        stamp[id] = epoch_; list.push_back(id);
+        for (int ch : g.nodes[id].ch) if (stamp[ch] != epoch_) stack_.push_back(ch);
+      }
+    };
+    reach(from, stamp_from_, from_list_);
+    reach(to, stamp_to_, to_list_);
+    double d = 0.0;
+    for (int id : to_list_) if (stamp_from_[id] != epoch_) d += node_cost(g.nodes[id]);
+    for (int id : from_list_) if (stamp_to_[id] != epoch_) d -= node_cost(g.nodes[id]);
+    return d;
+  }
+
+  // Plain text, one "<Kind> <cost>" line per operator
+  bool save(const std::string& path) const {
+    std::ofstream os(path);
+    if (!os) return false;
+    os.precision(17);
+    os << "et-cost-model 1\n";
+    for (std::size_t k = 0; k < kKinds; ++k) os << kind_name(NodeKind(k)) << ' ' << unit[k] << '\n';
+    return bool(os);
+  }
+  // Leaves *this unchanged unless the whole file parses
+  bool load(const std::string& path) {
+    std::ifstream is(path);
+    std::string tag; int version = 0;
+    if (!(is >> tag >> version) || tag != "et-cost-model" || version != 1) return false;
+    CostModel m;
+    std::array<char, kKinds> got{};
+    std::string name; double v;
+    while (is >> name >> v) {
+      std::size_t k = 0;
+      while (k < kKinds && name != kind_name(NodeKind(k))) ++k;
+      if (k == kKinds || !(v >= 0.0)) return false;
+      m.unit[k] = v; got[k] = 1;
+    }
+    if (!is.eof() || std::count(got.begin(), got.end(), 1) != (long)kKinds) return false;
+    *this = m;
+    return true;
+  }
+
+private:
+  // rewrite_delta scratch: epoch-stamped visited sets and cone lists
+  mutable std::vector<std::uint32_t> stamp_from_, stamp_to_;
+  mutable std::uint32_t epoch_ = 0;
+  mutable std::vector<int> stack_, from_list_, to_list_;
+};
+
+} // namespace et
@@ -0,0 +1,53 @@
+#pragma once
+#include <cmath>
+
+namespace et {
+
+// Forward-mode dual number v + d*eps (eps^2 = 0). Instantiating the tape
+// sweeps with Dual<double> propagates a directional derivative alongside every
+// value, which is how Tape::hvp differentiates the reverse sweep
+// (forward-over-reverse). Operators and math functions are hidden friends so
+// they are found by ADL next to `using std::sin;` etc., and the implicit
+// constructor lets plain constants mix with duals.
+template <class T>
+struct Dual {
+  T v{};  // value
+  T d{};  // tangent
+
+  Dual() = default;
+  Dual(T value, T tangent = T(0)) : v(value), d(tangent) {}
+
+  friend Dual operator+(const Dual& a, const Dual& b) { return { a.v + b.v, a.d + b.d }; }
+  friend Dual operator-(const Dual& a, const Dual& b) { return { a.v - b.v, a.d - b.d }; }
+  friend Dual operator*(const Dual& a, const Dual& b) { return { a.v * b.v, a.d * b.v + a.v * b.d }; }
+  friend Dual operator/(const Dual& a, const Dual& b) {
+    const T q = a.v / b.v;
+    return { q, (a.d - q * b.d) / b.v };
+  }
+  friend Dual operator-(const Dual& a) { return { -a.v, -a.d }; }
+
+  Dual& operator+=(const Dual& b) { v += b.v; d += b.d; return *this; }
+  Dual& operator-=(const Dual& b) { v -= b.v; d -= b.d; return *this; }
+
+  // Comparisons look at the value only
+  friend bool operator<(const Dual& a, const Dual& b) { return a.v < b.v; }
+  friend bool operator>(const Dual& a, const Dual& b) { return a.v > b.v; }
+  friend bool operator==(const Dual& a, const Dual& b) { return a.v == b.v; }
+
+  friend Dual sin(const Dual& a) { using std::sin; using std::cos; return { sin(a.v), a.d * cos(a.v) }; }
+  friend Dual cos(const Dual& a) { using std::sin; using std::cos; return { cos(a.v), -a.d * sin(a.v) }; }
+  friend Dual exp(const Dual& a) { using std::exp; const T e = exp(a.v); return { e, a.d * e }; }
+  friend Dual log(const Dual& a) { using std::log; return { log(a.v), a.d / a.v }; }
+  friend Dual sqrt(const Dual& a) { using std::sqrt; const T s = sqrt(a.v); return { s, a.d / (T(2) * s) }; }
+  friend Dual tanh(const Dual& a) { using std::tanh; const T t = tanh(a.v); return { t, a.d * (T(1) - t * t) }; }
+  friend Dual pow(const Dual& a, const Dual& b) {
+    using std::pow; using std::log;
+    const T f = pow(a.v, b.v);
+    // Skip the d/db term when b is constant so a non-positive base stays finite
+    T d = a.d * b.v * pow(a.v, b.v - T(1));
+    if (b.d != T(0)) d += b.d * f * log(a.v);
+    return { f, d };
+  }
+};
+
+} // namespace et
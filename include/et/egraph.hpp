@@ -0,0 +1,578 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "et/runtime_ast.hpp"
+#include "et/pattern.hpp"
+#include "et/match.hpp"
+#include "et/rule_index.hpp"
+#include "et/cost_model.hpp"
+
+namespace et {
+
+// E-node: an operator over e-class ids. Add/Mul children are kept sorted so
+// commutative variants share one e-node.
+struct ENode {
+  NodeKind kind{NodeKind::Const};
+  double cval{0.0};
+  std::size_t var_index{0};
+  std::vector<int> ch;
+
+  bool operator==(const ENode& o) const {
+    if (kind != o.kind || var_index != o.var_index || ch != o.ch) return false;
+    return std::memcmp(&cval, &o.cval, sizeof(double)) == 0;
+  }
+};
+
+struct ENodeHash {
+  std::size_t operator()(const ENode& n) const {
+    std::uint64_t bits; std::memcpy(&bits, &n.cval, sizeof(double));
+    std::uint64_t h = r_hash_mix(0x9e3779b97f4a7c15ull, (std::uint64_t)n.kind);
+    h = r_hash_mix(h, bits);
+    h = r_hash_mix(h, (std::uint64_t)n.var_index);
+    for (int c : n.ch) h = r_hash_mix(h, (std::uint64_t)(std::uint32_t)c);
+    return (std::size_t)h;
+  }
+};
+
+// Cost of one e-node excluding its children; extraction minimizes the sum
+// over the extracted tree. Must be non-negative.
+using ECostFn = std::function<double(const ENode&)>;
+
+// Tape instruction count: binary ops per reduction, one per other operator,
+// leaves free
+inline double egraph_op_cost(const ENode& n) {
+  switch (n.kind) {
+    case NodeKind::Var: case NodeKind::Const: return 0.0;
+    case NodeKind::Add: case NodeKind::Mul: return n.ch.empty() ? 0.0 : double(n.ch.size() - 1);
+    default: return 1.0;
+  }
+}
+
+// Rough FLOP-weighted cost: transcendental calls dominate arithmetic
+inline double egraph_flop_cost(const ENode& n) {
+  switch (n.kind) {
+    case NodeKind::Var: case NodeKind::Const: return 0.0;
+    case NodeKind::Add: case NodeKind::Mul: return n.ch.empty() ? 0.0 : double(n.ch.size() - 1);
+    case NodeKind::Sub: case NodeKind::Neg: return 1.0;
+    case NodeKind::Div: case NodeKind::Sqrt: case NodeKind::Recip: return 4.0;
+    case NodeKind::Rsqrt: return 5.0;
+    case NodeKind::Exp: case NodeKind::Log: return 10.0;
+    case NodeKind::Sin: case NodeKind::Cos: case NodeKind::Tanh: return 12.0;
+    case NodeKind::Pow: return 20.0;
+  }
+  return 1.0;
+}
+
+// Per-node cost from a (calibrated) CostModel
+inline ECostFn egraph_model_cost(const CostModel& m) {
+  return [m](const ENode& n) { return m.node_cost(n.kind, n.ch.size()); };
+}
+
+struct EGraphOptions {
+  std::size_t max_iterations = 16;
+  std::size_t max_nodes = 20000;             // e-nodes in the hashcons
+  double max_millis = 1000.0;                // wall time for saturate()
+  std::size_t max_matches_per_rule = 1000;   // per iteration; caps AC blowup on wide sums
+};
+
+enum class EGraphStop { Saturated, IterationLimit, NodeLimit, TimeLimit };
+
+struct EGraphStats {
+  std::size_t iterations = 0;
+  std::size_t matches = 0;   // substitutions found (after guards)
+  std::size_t unions = 0;    // merges that joined two distinct classes
+  std::size_t enodes = 0;
+  std::size_t eclasses = 0;
+  EGraphStop stop = EGraphStop::Saturated;
+};
+
+// Equality-saturation e-graph over RGraph terms. Rules are applied
+// non-destructively: a match adds the RHS and merges it with the matched
+// class, so every rewrite stays available and extraction picks the cheapest
+// representative under a cost model afterwards. Congruence is restored in
+// batches by rebuild(), as in egg. Rewrites of a given iteration are all
+// matched before any of them is applied, so the result does not depend on
+// rule order or priority. A constant-folding analysis (the Add/Mul/Sub/Neg/Div
+// folds of normalize) puts a Const e-node into every class whose value is
+// known, so extraction can pick it.
+class EGraph {
+public:
+  struct EClass {
+    std::vector<ENode> nodes;
+    std::vector<std::pair<ENode, int>> parents; // (e-node using this class, its class)
+  };
+
+  int find(int a) const {
+    while (uf_[a] != a) a = uf_[a];
+    return a;
+  }
+  int find(int a) {
+    int r = a;
+    while (uf_[r] != r) r = uf_[r];
+    while (uf_[a] != r) { int nx = uf_[a]; uf_[a] = r; a = nx; }
+    return r;
+  }
+
+  std::size_t num_nodes() const { return memo_.size(); }
+  std::size_t num_classes() const { return live_classes_; }
+  const EClass& eclass(int id) const { return classes_[find(id)]; }
+
+  // Adds an e-node (children are e-class ids) and returns its class
+  int add(ENode n) {
+    canonicalize(n);
+    auto it = memo_.find(n);
+    if (it != memo_.end()) return find(it->second);
+    const int id = (int)uf_.size();
+    uf_.push_back(id);
+    classes_.emplace_back();
+    ++live_classes_;
+    for (int c : n.ch) classes_[find(c)].parents.push_back({ n, id });
+    classes_[id].nodes.push_back(n);
+    const_.push_back(n.kind == NodeKind::Const ? 1 : 0);
+    cval_.push_back(n.cval);
+    double v;
+    const bool folds = n.kind != NodeKind::Const && fold(n, v);
+    ENode partial;
+    const bool combines = !folds && fold_partial(n, partial);
+    memo_.emplace(std::move(n), id);
+    if (folds) merge(id, add_const(v));
+    if (combines) merge(id, reduce_ac(partial.kind, std::move(partial.ch)));
+    return find(id);
+  }
+
+  // Adds every node reachable from g.root; returns the root's class
+  int add_graph(const RGraph& g) {
+    std::vector<int> cls(g.nodes.size(), -1);
+    std::vector<int> stack{ g.root };
+    while (!stack.empty()) {
+      const int id = stack.back();
+      if (cls[id] != -1) { stack.pop_back(); continue; }
+      const RNode& n = g.nodes[id];
+      bool ready = true;
+      for (int c : n.ch) if (cls[c] == -1) { stack.push_back(c); ready = false; }
+      if (!ready) continue;
+      stack.pop_back();
+      ENode e; e.kind = n.kind;
+      if (n.kind == NodeKind::Const) e.cval = n.cval;
+      if (n.kind == NodeKind::Var) e.var_index = n.var_index;
+      for (int c : n.ch) e.ch.push_back(cls[c]);
+      cls[id] = add(std::move(e));
+    }
+    return cls[g.root];
+  }
+
+  // Unions two classes; congruence is restored by the next rebuild()
+  bool merge(int a, int b) {
+    a = find(a); b = find(b);
+    if (a == b) return false;
+    if (classes_[a].nodes.size() + classes_[a].parents.size() <
+        classes_[b].nodes.size() + classes_[b].parents.size()) std::swap(a, b);
+    uf_[b] = a;
+    if (!const_[a] && const_[b]) { const_[a] = 1; cval_[a] = cval_[b]; }
+    EClass& ca = classes_[a]; EClass& cb = classes_[b];
+    ca.nodes.insert(ca.nodes.end(), std::make_move_iterator(cb.nodes.begin()), std::make_move_iterator(cb.nodes.end()));
+    ca.parents.insert(ca.parents.end(), std::make_move_iterator(cb.parents.begin()), std::make_move_iterator(cb.parents.end()));
+    cb = EClass{};
+    --live_classes_;
+    dirty_.push_back(a);
+    return true;
+  }
+
+  // Restores the hashcons and congruence invariants after merges
+  void rebuild() {
+    while (!dirty_.empty()) {
+      std::vector<int> todo;
+      todo.swap(dirty_);
+      for (int& c : todo) c = find(c);
+      std::sort(todo.begin(), todo.end());
+      todo.erase(std::unique(todo.begin(), todo.end()), todo.end());
+      for (int c : todo) repair(c);
+    }
+    for (int c = 0; c < (int)classes_.size(); ++c) {
+      if (uf_[c] != c) continue;
+      auto& ns = classes_[c].nodes;
+      for (auto& n : ns) canonicalize(n);
+      std::sort(ns.begin(), ns.end(), [](const ENode& a, const ENode& b) {
+        if (a.kind != b.kind) return a.kind < b.kind;
+        if (a.ch != b.ch) return a.ch < b.ch;
+        if (a.var_index != b.var_index) return a.var_index < b.var_index;
+        return std::memcmp(&a.cval, &b.cval, sizeof(double)) < 0;
+      });
+      ns.erase(std::unique(ns.begin(), ns.end()), ns.end());
+    }
+  }
+
+  // Applies the rules until nothing changes or a budget runs out
+  EGraphStats saturate(const std::vector<Rule>& rules, const EGraphOptions& opt = {}) {
+    using clock = std::chrono::steady_clock;
+    const auto t0 = clock::now();
+    auto expired = [&]() { return std::chrono::duration<double, std::milli>(clock::now() - t0).count() > opt.max_millis; };
+    EGraphStats st;
+    rebuild();
+    struct Match { const Rule* rule; int cls; Subst s; };
+    std::vector<Match> matches;
+    for (;;) {
+      if (st.iterations >= opt.max_iterations) { st.stop = EGraphStop::IterationLimit; break; }
+      ++st.iterations;
+
+      // Guards see one representative term per class
+      // The clock is also read every 64 classes and matches, so one large
+      // iteration cannot run far past max_millis
+      View view(*this);
+      matches.clear();
+      bool late = false;
+      for (const Rule& r : rules) {
+        std::size_t found = 0;
+        for (int c = 0; c < (int)classes_.size() && found < opt.max_matches_per_rule; ++c) {
+          if ((c & 63) == 63 && expired()) { late = true; break; }
+          if (uf_[c] != c) continue;
+          Subst s;
+          ematch(r.lhs, c, s, [&](const Subst& full) {
+            if (found >= opt.max_matches_per_rule) return;
+            if (r.guard && !view.guard(r, full)) return;
+            matches.push_back({ &r, c, full });
+            ++found;
+          });
+        }
+        st.matches += found;
+        if (late) break;
+      }
+      if (late) { st.stop = EGraphStop::TimeLimit; break; } // nothing applied yet
+
+      const std::size_t before_nodes = num_nodes();
+      std::size_t unions = 0;
+      for (std::size_t k = 0; k < matches.size(); ++k) {
+        const Match& m = matches[k];
+        const int rc = instantiate(m.rule->rhs, m.s);
+        if (rc >= 0 && merge(m.cls, rc)) ++unions;
+        if (num_nodes() > opt.max_nodes) break;
+        if ((k & 63) == 63 && expired()) { late = true; break; }
+      }
+      rebuild();
+      st.unions += unions;
+
+      if (num_nodes() > opt.max_nodes) { st.stop = EGraphStop::NodeLimit; break; }
+      if (late || expired()) { st.stop = EGraphStop::TimeLimit; break; }
+      if (unions == 0 && num_nodes() == before_nodes) { st.stop = EGraphStop::Saturated; break; }
+    }
+    st.enodes = num_nodes();
+    st.eclasses = num_classes();
+    return st;
+  }
+
+  // Cheapest e-node per class under `cost` (tree cost, relaxed to a fixed
+  // point). Classes with no finite-cost term get +inf and best index -1.
+  void best_nodes(const ECostFn& cost, std::vector<double>& best, std::vector<int>& choice) const {
+    const double inf = std::numeric_limits<double>::infinity();
+    best.assign(classes_.size(), inf);
+    choice.assign(classes_.size(), -1);
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (int c = 0; c < (int)classes_.size(); ++c) {
+        if (uf_[c] != c) continue;
+        const auto& ns = classes_[c].nodes;
+        for (int k = 0; k < (int)ns.size(); ++k) {
+          double v = cost(ns[k]);
+          for (int ch : ns[k].ch) v += best[find(ch)];
+          if (v < best[c]) { best[c] = v; choice[c] = k; changed = true; }
+        }
+      }
+    }
+  }
+
+  // Cheapest term of class `root` as an RGraph in `out` (whose mode, plain or
+  // interned, is kept); shared classes are emitted once. Returns the node id
+  // and stores the tree cost in *total if given; returns -1 (out may hold a
+  // partial term) when the class has no finite-cost term.
+  int extract(int root, RGraph& out, const ECostFn& cost = egraph_op_cost, double* total = nullptr) const {
+    std::vector<double> best; std::vector<int> choice;
+    best_nodes(cost, best, choice);
+    root = find(root);
+    if (total) *total = best[root];
+    std::vector<int> memo(classes_.size(), -1);
+    return emit(root, choice, out, memo);
+  }
+
+private:
+  // Placeholder id -> class (or list of classes for spreads), -1 / empty when unbound
+  struct Subst {
+    std::vector<int> one;
+    std::vector<std::vector<int>> many;
+    std::vector<char> many_set;
+  };
+  using Emit = std::function<void(const Subst&)>;
+
+  // Materializes one representative term per class for rule guards, which
+  // are written against RGraph node ids: a class holding a constant shows
+  // it, any other class shows its cheapest term
+  struct View {
+    const EGraph& eg;
+    RGraph g;
+    std::vector<double> best;
+    std::vector<int> choice;
+    std::vector<int> memo;
+    Bindings b; MultiBindings mb;
+    explicit View(const EGraph& e) : eg(e) {
+      eg.best_nodes(egraph_op_cost, best, choice);
+      memo.assign(eg.classes_.size(), -1);
+      for (int c = 0; c < (int)eg.classes_.size(); ++c) {
+        if (eg.uf_[c] != c) continue;
+        const auto& ns = eg.classes_[c].nodes;
+        for (int k = 0; k < (int)ns.size(); ++k)
+          if (ns[k].kind == NodeKind::Const) { choice[c] = k; break; }
+      }
+    }
+    int id(int cls) { return eg.emit(eg.find(cls), choice, g, memo); }
+    bool guard(const Rule& r, const Subst& s) {
+      b.clear(); mb.clear();
+      for (int pid = 0; pid < (int)s.one.size(); ++pid) if (s.one[pid] >= 0) b.bind(pid) = id(s.one[pid]);
+      for (int pid = 0; pid < (int)s.many.size(); ++pid) {
+        if (!s.many_set[pid]) continue;
+        auto& v = mb.bind(pid); v.clear();
+        for (int c : s.many[pid]) v.push_back(id(c));
+      }
+      return r.guard(g, b, mb);
+    }
+  };
+
+  // Leaf fields only count on leaves, and -0 is the same constant as +0
+  // (as in RGraph interning), so stray values never split a class
+  void canonicalize(ENode& n) {
+    if (n.kind != NodeKind::Const || n.cval == 0.0) n.cval = 0.0;
+    if (n.kind != NodeKind::Var) n.var_index = 0;
+    for (int& c : n.ch) c = find(c);
+    if (is_ac(n.kind)) std::sort(n.ch.begin(), n.ch.end());
+  }
+
+  void repair(int c) {
+    std::vector<std::pair<ENode, int>> ps;
+    ps.swap(classes_[c].parents);
+    for (auto& [n, pc] : ps) {
+      memo_.erase(n);
+      canonicalize(n);
+      pc = find(pc);
+      double v;
+      if (!const_[pc] && fold(n, v)) pc = merge_into(pc, add_const(v)); // c became constant
+    }
+    std::unordered_map<ENode, int, ENodeHash> seen;
+    std::vector<std::pair<ENode, int>> kept;
+    for (auto& [n, pc] : ps) {
+      auto it = seen.find(n);
+      if (it != seen.end()) { merge(it->second, pc); continue; } // congruent parents
+      auto mit = memo_.find(n);
+      if (mit != memo_.end() && find(mit->second) != pc) merge(mit->second, pc);
+      seen.emplace(n, pc);
+      memo_[n] = find(pc);
+      kept.push_back({ n, pc });
+    }
+    // c may have been merged into another class meanwhile
+    auto& dst = classes_[find(c)].parents;
+    dst.insert(dst.end(), std::make_move_iterator(kept.begin()), std::make_move_iterator(kept.end()));
+  }
+
+  int add_const(double v) { ENode k; k.kind = NodeKind::Const; k.cval = v; return add(std::move(k)); }
+  int merge_into(int a, int b) { merge(a, b); return find(a); }
+
+  // Constant value of n when all its children are constant classes
+  bool fold(const ENode& n, double& v) {
+    if (n.ch.empty()) return false;
+    for (int c : n.ch) if (!const_[find(c)]) return false;
+    auto at = [&](std::size_t i) { return cval_[find(n.ch[i])]; };
+    switch (n.kind) {
+      case NodeKind::Add: v = 0.0; for (std::size_t i = 0; i < n.ch.size(); ++i) v += at(i); return true;
+      case NodeKind::Mul: v = 1.0; for (std::size_t i = 0; i < n.ch.size(); ++i) v *= at(i); return true;
+      case NodeKind::Sub: v = at(0) - at(1); return true;
+      case NodeKind::Neg: v = -at(0); return true;
+      case NodeKind::Div: if (at(1) == 0.0) return false; v = at(0) / at(1); return true;
+      case NodeKind::Recip: if (at(0) == 0.0) return false; v = 1.0 / at(0); return true;
+      default: return false;
+    }
+  }
+
+  // Add/Mul with two or more constant children: the same node with those
+  // combined into one constant (dropped when neutral)
+  bool fold_partial(const ENode& n, ENode& out) {
+    if (!is_ac(n.kind)) return false;
+    const bool mul = n.kind == NodeKind::Mul;
+    double acc = mul ? 1.0 : 0.0;
+    std::size_t consts = 0;
+    out = ENode{}; out.kind = n.kind;
+    for (int c : n.ch) {
+      const int r = find(c);
+      if (!const_[r]) { out.ch.push_back(r); continue; }
+      ++consts;
+      acc = mul ? acc * cval_[r] : acc + cval_[r];
+    }
+    if (consts < 2) return false;
+    if (mul && acc == 0.0) { out.ch.clear(); out.ch.push_back(add_const(0.0)); return true; } // annihilator, as in normalize
+    if (acc != (mul ? 1.0 : 0.0)) out.ch.push_back(add_const(acc));
+    return true;
+  }
+
+  static bool is_spread(const pat::Pattern& p) { return p.kind == pat::Pattern::Kind::Placeholder && p.is_spread; }
+
+  static void bind_one(Subst& s, int pid, int cls) {
+    if ((int)s.one.size() <= pid) s.one.resize(pid + 1, -1);
+    s.one[pid] = cls;
+  }
+  static void bind_many(Subst& s, int pid, std::vector<int> cls) {
+    if ((int)s.many.size() <= pid) { s.many.resize(pid + 1); s.many_set.resize(pid + 1, 0); }
+    s.many[pid] = std::move(cls); s.many_set[pid] = 1;
+  }
+  static bool has_one(const Subst& s, int pid) { return pid < (int)s.one.size() && s.one[pid] >= 0; }
+  static bool has_many(const Subst& s, int pid) { return pid < (int)s.many_set.size() && s.many_set[pid]; }
+
+  // Calls k once for every extension of s under which `p` matches class `cls`
+  void ematch(const pat::Pattern& p, int cls, Subst& s, const Emit& k) {
+    cls = find(cls);
+    if (p.kind == pat::Pattern::Kind::Placeholder) {
+      if (p.is_spread) {
+        if (!has_many(s, p.placeholder_id)) {
+          Subst t = s; bind_many(t, p.placeholder_id, { cls }); k(t); return;
+        }
+        const auto& v = s.many[p.placeholder_id];
+        if (v.size() == 1 && find(v[0]) == cls) k(s);
+        return;
+      }
+      if (!has_one(s, p.placeholder_id)) { Subst t = s; bind_one(t, p.placeholder_id, cls); k(t); return; }
+      if (find(s.one[p.placeholder_id]) == cls) k(s);
+      return;
+    }
+    for (const ENode& n : classes_[cls].nodes) { // matching never adds nodes or merges
+      if (n.kind != p.node_kind) continue;
+      if (n.kind == NodeKind::Const && std::memcmp(&n.cval, &p.cval, sizeof(double)) != 0) continue;
+      if (n.kind == NodeKind::Var && n.var_index != p.var_index) continue;
+      if (is_ac(n.kind)) { ematch_ac(p, n, s, k); continue; }
+      if (n.ch.size() != p.ch.size()) continue;
+      ematch_seq(p, n, 0, s, k);
+    }
+  }
+
+  void ematch_seq(const pat::Pattern& p, const ENode& n, std::size_t i, Subst& s, const Emit& k) {
+    if (i == p.ch.size()) { k(s); return; }
+    ematch(p.ch[i], n.ch[i], s, [&](const Subst& t) {
+      Subst u = t; ematch_seq(p, n, i + 1, u, k);
+    });
+  }
+
+  // Multiset assignment of the non-spread pattern children to distinct
+  // e-node children; an optional single spread takes the rest
+  void ematch_ac(const pat::Pattern& p, const ENode& n, Subst& s, const Emit& k) {
+    std::vector<std::size_t> fixed; int spread = -1, spreads = 0;
+    for (std::size_t i = 0; i < p.ch.size(); ++i) {
+      if (is_spread(p.ch[i])) { ++spreads; spread = (int)i; } else fixed.push_back(i);
+    }
+    if (spreads > 1) return;
+    if (spreads == 0 && fixed.size() != n.ch.size()) return;
+    if (fixed.size() > n.ch.size()) return;
+    std::vector<char> used(n.ch.size(), 0);
+    std::function<void(std::size_t, const Subst&)> go = [&](std::size_t i, const Subst& cur) {
+      if (i == fixed.size()) {
+        if (spread < 0) { k(cur); return; }
+        std::vector<int> rest;
+        for (std::size_t j = 0; j < n.ch.size(); ++j) if (!used[j]) rest.push_back(n.ch[j]);
+        const int pid = p.ch[spread].placeholder_id;
+        if (!has_many(cur, pid)) { Subst t = cur; bind_many(t, pid, std::move(rest)); k(t); return; }
+        std::vector<int> prev = cur.many[pid];
+        for (int& c : prev) c = find(c);
+        std::sort(prev.begin(), prev.end());
+        std::sort(rest.begin(), rest.end());
+        if (prev == rest) k(cur);
+        return;
+      }
+      for (std::size_t j = 0; j < n.ch.size(); ++j) {
+        if (used[j] || (j > 0 && n.ch[j] == n.ch[j - 1] && !used[j - 1])) continue; // skip duplicate children
+        used[j] = 1;
+        Subst t = cur;
+        ematch(p.ch[fixed[i]], n.ch[j], t, [&](const Subst& u) { go(i + 1, u); });
+        used[j] = 0;
+      }
+    };
+    go(0, s);
+  }
+
+  // Adds the RHS under substitution s; returns its class or -1
+  int instantiate(const pat::Pattern& p, const Subst& s) {
+    if (p.kind == pat::Pattern::Kind::Placeholder) {
+      if (p.is_spread) {
+        if (!has_many(s, p.placeholder_id)) return -1;
+        return reduce_ac(NodeKind::Add, s.many[p.placeholder_id]);
+      }
+      return has_one(s, p.placeholder_id) ? find(s.one[p.placeholder_id]) : -1;
+    }
+    std::vector<int> ch;
+    for (const auto& c : p.ch) {
+      if (is_spread(c) && is_ac(p.node_kind)) {
+        if (has_many(s, c.placeholder_id)) for (int x : s.many[c.placeholder_id]) ch.push_back(find(x));
+        continue;
+      }
+      const int x = instantiate(c, s);
+      if (x < 0) return -1;
+      ch.push_back(x);
+    }
+    if (is_ac(p.node_kind)) return reduce_ac(p.node_kind, ch);
+    ENode n; n.kind = p.node_kind; n.ch = std::move(ch);
+    if (n.kind == NodeKind::Const) n.cval = p.cval;
+    if (n.kind == NodeKind::Var) n.var_index = p.var_index;
+    return add(std::move(n));
+  }
+
+  // Add/Mul with neutral cases: no children is the identity, one is the child
+  int reduce_ac(NodeKind kind, std::vector<int> ch) {
+    if (ch.size() == 1) return find(ch[0]);
+    ENode n; n.kind = kind;
+    if (ch.empty()) { n.kind = NodeKind::Const; n.cval = kind == NodeKind::Mul ? 1.0 : 0.0; return add(std::move(n)); }
+    n.ch = std::move(ch);
+    return add(std::move(n));
+  }
+
+  int emit(int root, const std::vector<int>& choice, RGraph& out, std::vector<int>& memo) const {
+    std::vector<int> stack{ find(root) };
+    while (!stack.empty()) {
+      const int c = stack.back();
+      if (memo[c] != -1) { stack.pop_back(); continue; }
+      if (choice[c] < 0) return -1; // no finite-cost term in this class
+      const ENode& n = classes_[c].nodes[choice[c]];
+      bool ready = true;
+      for (int x : n.ch) if (memo[find(x)] == -1) { stack.push_back(find(x)); ready = false; }
+      if (!ready) continue;
+      stack.pop_back();
+      RNode r; r.kind = n.kind; r.cval = n.cval; r.var_index = n.var_index;
+      for (int x : n.ch) r.ch.push_back(memo[find(x)]);
+      memo[c] = out.add(std::move(r));
+    }
+    return memo[find(root)];
+  }
+
+  std::vector<int> uf_;
+  std::vector<EClass> classes_;
+  std::unordered_map<ENode, int, ENodeHash> memo_;
+  std::vector<int> dirty_;
+  std::vector<char> const_;    // per class: value known (constant-folding analysis)
+  std::vector<double> cval_;
+  std::size_t live_classes_ = 0;
+};
+
+// RGraph -> e-graph -> saturate -> cheapest term, in g's mode
+inline RGraph egraph_optimize(const RGraph& g, const std::vector<Rule>& rules, const EGraphOptions& opt = {},
+                              const ECostFn& cost = egraph_op_cost, EGraphStats* stats = nullptr) {
+  EGraph eg;
+  const int root = eg.add_graph(g);
+  EGraphStats st = eg.saturate(rules, opt);
+  if (stats) *stats = st;
+  RGraph out = g.empty_like();
+  out.root = eg.extract(root, out, cost);
+  return out.root < 0 ? g : out; // no finite-cost term: keep the input
+}
+
+} // namespace et
@@ -163,6 +163,21 @@ struct TanhOp {
   template <std::size_t I, class X>
   static auto d(const X& x);
 };
+// 1/x and 1/sqrt(x): produced by strength reduction of Pow with exponent -1 / -0.5
+struct RecipOp {
+  static constexpr std::size_t arity = 1;
+  template <class A> static constexpr auto eval(A&& a)
+  -> decltype(std::decay_t<A>(1) / std::forward<A>(a)) { return std::decay_t<A>(1) / std::forward<A>(a); }
+  template <std::size_t I, class X>
+  static auto d(const X& x);
+};
+struct RsqrtOp {
+  static constexpr std::size_t arity = 1;
+  template <class A> static constexpr auto eval(A&& a)
+  -> decltype(std::decay_t<A>(1) / sqrt(std::forward<A>(a))) { using std::sqrt; return std::decay_t<A>(1) / sqrt(std::forward<A>(a)); }
+  template <std::size_t I, class X>
+  static auto d(const X& x);
+};
 
 // Operator sugar
 // Binary operators (only when at least one side is an ET node)
@@ -206,6 +221,12 @@ constexpr auto sqrt(A a) { return Apply<SqrtOp, std::decay_t<A>>(std::move(a));
 template <class A, std::enable_if_t<is_node_t<A>::value, int> = 0>
 constexpr auto tanh(A a) { return Apply<TanhOp, std::decay_t<A>>(std::move(a)); }
 
+template <class A, std::enable_if_t<is_node_t<A>::value, int> = 0>
+constexpr auto recip(A a) { return Apply<RecipOp, std::decay_t<A>>(std::move(a)); }
+
+template <class A, std::enable_if_t<is_node_t<A>::value, int> = 0>
+constexpr auto rsqrt(A a) { return Apply<RsqrtOp, std::decay_t<A>>(std::move(a)); }
+
 // Power wrapper (only when at least one side is an ET node)
 template <class L, class R, std::enable_if_t<is_node_t<L>::value || is_node_t<R>::value, int> = 0>
 constexpr auto pow(L l, R r) { return Apply<PowOp, std::decay_t<L>, std::decay_t<R>>(std::move(l), std::move(r)); }
@@ -355,6 +376,31 @@ inline auto TanhOp::d(const X& x) {
       std::move(factor), std::move(dx));
 }
 
+template <std::size_t I, class X>
+inline auto RecipOp::d(const X& x) {
+  // d/dx (1/x) = -(1/x)^2 * dx
+  auto dx = diff(x, std::integral_constant<std::size_t,I>{});
+  auto r = Apply<RecipOp, X>(x);
+  auto r2 = Apply<MulOp, decltype(r), decltype(r)>(r, r);
+  auto factor = Apply<NegOp, decltype(r2)>(r2);
+  return Apply<MulOp, decltype(factor), decltype(dx)>(
+      std::move(factor), std::move(dx));
+}
+
+template <std::size_t I, class X>
+inline auto RsqrtOp::d(const X& x) {
+  // d/dx x^(-1/2) = -0.5 * rsqrt(x)^3 * dx
+  auto dx = diff(x, std::integral_constant<std::size_t,I>{});
+  using TX = value_type_of_t<X>;
+  auto half = lit(TX(-0.5));
+  auto r = Apply<RsqrtOp, X>(x);
+  auto r3 = Apply<MulOp, decltype(r), Apply<MulOp, decltype(r), decltype(r)>>(
+      r, Apply<MulOp, decltype(r), decltype(r)>(r, r));
+  auto factor = Apply<MulOp, decltype(half), decltype(r3)>(half, std::move(r3));
+  return Apply<MulOp, decltype(factor), decltype(dx)>(
+      std::move(factor), std::move(dx));
+}
+
 //===========================
 // Evaluation helper
 //===========================
@@ -1,5 +1,7 @@
 #pragma once
-#include <unordered_map>
+#include <cassert>
+#include <cstddef>
+#include <utility>
 #include <vector>
 #include <algorithm>
 
@@ -8,15 +10,95 @@
 
 namespace et {
 
-using Bindings = std::unordered_map<int,int>; // pid -> single node id
-using MultiBindings = std::unordered_map<int, std::vector<int>>; // pid -> list of node ids (for spreads)
+// Placeholder bindings: one flat slot per placeholder id plus an undo trail,
+// so the AC matcher can backtrack by rewinding to a mark instead of copying
+// maps. Lookup keeps the map-like find/end/count/emplace and `it->second`
+// interface that guards use. Unbinding keeps the slot's storage, so a reused
+// table does not allocate once warm. Placeholder ids must be non-negative.
+template <class V>
+class BindingTable {
+public:
+  using value_type = std::pair<int, V>; // first is the placeholder id, -1 while unbound
+
+  class const_iterator {
+  public:
+    const_iterator() = default;
+    const_iterator(const value_type* p, const value_type* last) : p_(p), last_(last) { skip(); }
+    const value_type& operator*() const { return *p_; }
+    const value_type* operator->() const { return p_; }
+    const_iterator& operator++() { ++p_; skip(); return *this; }
+    bool operator==(const const_iterator& o) const { return p_ == o.p_; }
+    bool operator!=(const const_iterator& o) const { return p_ != o.p_; }
+  private:
+    void skip() { while (p_ != last_ && p_->first < 0) ++p_; }
+    const value_type* p_ = nullptr;
+    const value_type* last_ = nullptr;
+  };
+
+  const_iterator begin() const { return { slots_.data(), slots_.data() + slots_.size() }; }
+  const_iterator end() const { return { slots_.data() + slots_.size(), slots_.data() + slots_.size() }; }
+  const_iterator find(int pid) const {
+    if (!bound(pid)) return end();
+    return { slots_.data() + pid, slots_.data() + slots_.size() };
+  }
+  std::size_t count(int pid) const { return bound(pid) ? 1 : 0; }
+  std::size_t size() const { return trail_.size(); }
+  bool empty() const { return trail_.empty(); }
+
+  // Binds an unbound pid and returns its value slot (holding stale contents
+  // from an earlier binding, which the caller overwrites)
+  V& bind(int pid) {
+    assert(pid >= 0 && !bound(pid));
+    if ((std::size_t)pid >= slots_.size()) slots_.resize((std::size_t)pid + 1, value_type(-1, V{}));
+    slots_[pid].first = pid;
+    trail_.push_back(pid);
+    return slots_[pid].second;
+  }
+  // Map-style access: at() requires a binding, [] binds a default value if needed
+  const V& at(int pid) const { assert(bound(pid)); return slots_[pid].second; }
+  V& operator[](int pid) {
+    if (!bound(pid)) bind(pid) = V{};
+    return slots_[pid].second;
+  }
+  // Map-style insert: no effect if pid is already bound
+  std::pair<const_iterator, bool> emplace(int pid, V v) {
+    if (bound(pid)) return { find(pid), false };
+    bind(pid) = std::move(v);
+    return { find(pid), true };
+  }
+
+  // Undo trail: mark() before a tentative match, undo(mark) to drop every
+  // binding made since
+  std::size_t mark() const { return trail_.size(); }
+  void undo(std::size_t m) {
+    while (trail_.size() > m) { slots_[trail_.back()].first = -1; trail_.pop_back(); }
+  }
+  void clear() { undo(0); }
+
+private:
+  bool bound(int pid) const { return pid >= 0 && (std::size_t)pid < slots_.size() && slots_[pid].first >= 0; }
+  std::vector<value_type> slots_;
+  std::vector<int> trail_;
+};
+
+using Bindings = BindingTable<int>;                    // pid -> single node id
+using MultiBindings = BindingTable<std::vector<int>>;  // pid -> list of node ids (for spreads)
 
 inline bool is_ac(NodeKind k) { return k == NodeKind::Add || k == NodeKind::Mul; }
 
 // Forward decl
 bool match_node(const RGraph& g, int id, const pat::Pattern& p, Bindings& b, MultiBindings& mb);
 
-// AC multiset matching with backtracking
+namespace detail {
+// Scratch stack shared by nested match_ac calls; each call works above the
+// size it found and truncates back on exit. Accessed by index only, since
+// nested calls may grow it.
+inline std::vector<int>& match_scratch() { static thread_local std::vector<int> s; return s; }
+}
+
+// AC multiset matching with backtracking. Iterative: one frame per pattern
+// child records the next candidate to try, the child it consumed and the
+// binding marks to rewind to.
 inline bool match_ac(const RGraph& g, const RNode& n, const pat::Pattern& p, Bindings& b, MultiBindings& mb) {
   if (n.kind != p.node_kind) return false;
   // Spreads allowed: at most one spread captures the remainder. Without spread, require exact cover.
@@ -26,55 +108,71 @@ inline bool match_ac(const RGraph& g, const RNode& n, const pat::Pattern& p, Bin
   if (spreads == 0 && p.ch.size() != n.ch.size()) return false;
   if (spreads == 1 && p.ch.size()-1 > n.ch.size()) return false;
 
+  std::vector<int>& s = detail::match_scratch();
+  struct Truncate { std::vector<int>& s; std::size_t size; ~Truncate() { s.resize(size); } } truncate{ s, s.size() };
+
+  // Layout above the entry size: [pidx: k][remaining: m][frames: k * kFrame]
+  const std::size_t base = s.size();
   // Order pattern children by decreasing specificity, excluding spread
-  std::vector<std::size_t> pidx; pidx.reserve(p.ch.size());
-  for (std::size_t i = 0; i < pidx.size(); ++i) pidx[i] = i;
-  pidx.clear();
-  for (std::size_t i=0;i<p.ch.size();++i) if (!(p.ch[i].kind==pat::Pattern::Kind::Placeholder && p.ch[i].is_spread)) pidx.push_back(i);
-  std::sort(pidx.begin(), pidx.end(), [&](std::size_t a, std::size_t c){
+  for (std::size_t i=0;i<p.ch.size();++i) if (i != spread_idx) s.push_back((int)i);
+  const std::size_t k = s.size() - base;
+  std::sort(s.begin() + base, s.end(), [&](int a, int c){
     return pat::specificity(p.ch[a]) > pat::specificity(p.ch[c]);
   });
-
   // Remaining candidate children of n (ids)
-  std::vector<int> remaining = n.ch;
-
-  std::function<bool(std::size_t)> dfs = [&](std::size_t i) -> bool {
-    if (i == pidx.size()) return true;
-    const pat::Pattern& pc = p.ch[pidx[i]];
-    for (std::size_t r = 0; r < remaining.size(); ++r) {
-      int cand = remaining[r];
-      // Snapshot bindings for backtracking
-      auto b_snapshot = b; auto mb_snapshot = mb;
+  const std::size_t rem = s.size();
+  s.insert(s.end(), n.ch.begin(), n.ch.end());
+  std::size_t rem_size = n.ch.size();
+  enum { kNext, kChosen, kCand, kLast, kBMark, kMbMark, kFrame };
+  const std::size_t frames = s.size();
+  s.resize(frames + k * kFrame);
+  auto frame = [&](std::size_t i, int field) -> int& { return s[frames + i * kFrame + field]; };
+  auto enter = [&](std::size_t i) {
+    if (i == k) return;
+    frame(i, kNext) = 0; frame(i, kBMark) = (int)b.mark(); frame(i, kMbMark) = (int)mb.mark();
+  };
+
+  std::size_t i = 0;
+  enter(0);
+  while (i < k) {
+    const pat::Pattern& pc = p.ch[s[base + i]];
+    bool advanced = false;
+    while (frame(i, kNext) < (int)rem_size) {
+      const int r = frame(i, kNext)++;
+      const int cand = s[rem + r];
       if (match_node(g, cand, pc, b, mb)) {
-        // consume cand
-        int last = remaining.back();
-        remaining[r] = last;
-        remaining.pop_back();
-        if (dfs(i+1)) return true;
-        // backtrack
-        remaining.push_back(last);
-        remaining[r] = cand;
+        // consume cand: move the last remaining child into its slot
+        const int last = s[rem + rem_size - 1];
+        s[rem + r] = last; --rem_size;
+        frame(i, kChosen) = r; frame(i, kCand) = cand; frame(i, kLast) = last;
+        enter(++i);
+        advanced = true;
+        break;
       }
-      b = std::move(b_snapshot); mb = std::move(mb_snapshot);
+      b.undo(frame(i, kBMark)); mb.undo(frame(i, kMbMark));
     }
-    return false;
-  };
+    if (advanced) continue;
+    if (i == 0) return false;
+    // backtrack: give back the child consumed one level up and try its next candidate
+    --i;
+    s[rem + rem_size] = frame(i, kLast); ++rem_size;
+    s[rem + frame(i, kChosen)] = frame(i, kCand);
+    b.undo(frame(i, kBMark)); mb.undo(frame(i, kMbMark));
+  }
 
-  bool ok = dfs(0);
-  if (!ok) return false;
   // Assign spread binding to remainder if present
   if (spreads == 1) {
     const auto& sp = p.ch[spread_idx];
     auto it = mb.find(sp.placeholder_id);
     if (it == mb.end()) {
-      mb.emplace(sp.placeholder_id, remaining);
+      mb.bind(sp.placeholder_id).assign(s.begin() + rem, s.begin() + rem + rem_size);
     } else {
       // Must be identical by structure and size
       const auto& prev = it->second;
-      if (prev.size() != remaining.size()) return false;
-      for (std::size_t i=0;i<prev.size();++i) if (!r_equal(g, prev[i], remaining[i])) return false;
+      if (prev.size() != rem_size) return false;
+      for (std::size_t j=0;j<prev.size();++j) if (!r_equal(g, prev[j], s[rem + j])) return false;
     }
-  } else if (!remaining.empty()) {
+  } else if (rem_size != 0) {
     return false;
   }
   return true;
@@ -85,12 +183,12 @@ inline bool match_node(const RGraph& g, int id, const pat::Pattern& p, Bindings&
     if (p.is_spread) {
       // Spread outside AC context unsupported: treat as single binding
       auto itv = mb.find(p.placeholder_id);
-      if (itv == mb.end()) { mb.emplace(p.placeholder_id, std::vector<int>{id}); return true; }
+      if (itv == mb.end()) { mb.bind(p.placeholder_id).assign(1, id); return true; }
       const auto& vec = itv->second;
       return vec.size()==1 && r_equal(g, vec[0], id);
     } else {
       auto it = b.find(p.placeholder_id);
-      if (it == b.end()) { b.emplace(p.placeholder_id, id); return true; }
+      if (it == b.end()) { b.bind(p.placeholder_id) = id; return true; }
       return r_equal(g, it->second, id);
     }
   }
@@ -40,6 +40,8 @@ inline Pattern exp(const Pattern& a) { return Pattern::node(NodeKind::Exp, {a});
 inline Pattern log(const Pattern& a) { return Pattern::node(NodeKind::Log, {a}); }
 inline Pattern sqrt(const Pattern& a){ return Pattern::node(NodeKind::Sqrt,{a}); }
 inline Pattern tanh(const Pattern& a){ return Pattern::node(NodeKind::Tanh,{a}); }
+inline Pattern recip(const Pattern& a){ return Pattern::node(NodeKind::Recip,{a}); }
+inline Pattern rsqrt(const Pattern& a){ return Pattern::node(NodeKind::Rsqrt,{a}); }
 
 // Binary builders
 inline Pattern add(const Pattern& a, const Pattern& b) { return Pattern::node(NodeKind::Add, {a,b}); }
@@ -1,22 +1,17 @@
 #pragma once
 #include <vector>
 #include <functional>
+#include <unordered_map>
 #include <utility>
 
 #include "et/runtime_ast.hpp"
 #include "et/normalize.hpp"
 #include "et/match.hpp"
+#include "et/rule_index.hpp"
+#include "et/cost_model.hpp"
 
 namespace et {
 
-struct Rule {
-  pat::Pattern lhs;
-  pat::Pattern rhs;
-  std::function<bool(const RGraph&, const Bindings&, const MultiBindings&)> guard; // optional
-  const char* name = "";
-  int priority = 0;
-};
-
 // Clone subtree from src graph into dst graph (memoized to preserve sharing)
 inline int clone_subtree(const RGraph& src, RGraph& dst, int id, std::unordered_map<int,int>& memo) {
   auto it = memo.find(id);
@@ -69,53 +64,123 @@ inline int instantiate_rhs(const pat::Pattern& p, const RGraph& src, const Bindi
   return dst.add(std::move(n));
 }
 
-// Rewrite a single node (postorder) into dst graph; returns dst node id
-inline int rewrite_node(const RGraph& src, int id, const std::vector<Rule>& rules,
-                        RGraph& dst) {
-  const RNode& n = src.nodes[id];
+// Instantiate RHS pattern directly in g, where the bindings already refer to
+// g's ids: placeholders are reused as-is, so nothing is cloned. Only ids are
+// held across g.add(), never references into g.nodes.
+inline int instantiate_in_place(const pat::Pattern& p, RGraph& g, const Bindings& b, const MultiBindings& mb) {
+  using Kind = pat::Pattern::Kind;
+  if (p.kind == Kind::Placeholder) {
+    if (p.is_spread) {
+      RNode nn; nn.kind = NodeKind::Add;
+      auto itv = mb.find(p.placeholder_id);
+      if (itv != mb.end()) nn.ch = itv->second;
+      return g.add(std::move(nn));
+    }
+    auto it = b.find(p.placeholder_id);
+    return it == b.end() ? -1 : it->second;
+  }
+  RNode n; n.kind = p.node_kind;
+  if (n.kind == NodeKind::Const) { n.cval = p.cval; }
+  if (n.kind == NodeKind::Var)   { n.var_index = p.var_index; }
+  n.ch.reserve(p.ch.size());
+  for (const auto& c : p.ch) {
+    if (c.kind == Kind::Placeholder && c.is_spread && (n.kind==NodeKind::Add || n.kind==NodeKind::Mul)) {
+      auto itv = mb.find(c.placeholder_id);
+      if (itv != mb.end()) n.ch.insert(n.ch.end(), itv->second.begin(), itv->second.end());
+    } else {
+      n.ch.push_back(instantiate_in_place(c, g, b, mb));
+    }
+  }
+  return g.add(std::move(n));
+}
 
-  // First, rewrite children to dst ids
-  std::vector<int> ch; ch.reserve(n.ch.size());
-  for (int cid : n.ch) ch.push_back(rewrite_node(src, cid, rules, dst));
+// Counters for one rewrite pass
+struct RewritePassStats {
+  std::size_t visited = 0;   // distinct source nodes rewritten
+  std::size_t attempts = 0;  // rule matches tried
+  std::size_t rewrites = 0;  // rules fired
+  std::size_t rejected = 0;  // matches dropped by the cost model
+};
 
-  // Try rules at this node (on the original shape, but we could also match against normalized children)
-  for (const auto& r : rules) {
-    Bindings bind; MultiBindings mbind;
-    if (match_node(src, id, r.lhs, bind, mbind)) {
-      if (!r.guard || r.guard(src, bind, mbind)) {
-        std::unordered_map<int,int> memo_clone;
-        int rid = instantiate_rhs(r.rhs, src, bind, mbind, dst, memo_clone);
-        return rid;
+// One bottom-up pass over the DAG below `id`, memoized by source id so a node
+// shared by several parents is rewritten once. Each node is first rebuilt in
+// dst on its already-rewritten children, then the candidate rules from the
+// index (priority order, first match wins) are matched against that rebuilt
+// node and the RHS is instantiated in dst. With a cost model, a rewrite whose
+// RHS would cost more than the node it replaces is dropped and the next
+// candidate is tried. Uses an explicit stack rather than recursion.
+inline int rewrite_subgraph(const RGraph& src, int id, const RuleIndex& index, RGraph& dst,
+                            std::vector<int>& memo, RewritePassStats* stats = nullptr,
+                            const CostModel* cost = nullptr) {
+  if (memo.size() < src.nodes.size()) memo.resize(src.nodes.size(), -1);
+  std::vector<std::pair<int, bool>> stack{ {id, false} };
+  Bindings bind; MultiBindings mbind;
+  std::vector<const Rule*> rules;
+  while (!stack.empty()) {
+    auto [cur, expanded] = stack.back();
+    if (memo[cur] != -1) { stack.pop_back(); continue; }
+    const RNode& n = src.nodes[cur];
+    if (!expanded) {
+      stack.back().second = true;
+      for (auto it = n.ch.rbegin(); it != n.ch.rend(); ++it)
+        if (memo[*it] == -1) stack.push_back({ *it, false });
+      continue;
+    }
+    stack.pop_back();
+    RNode nn; nn.kind = n.kind; nn.cval = n.cval; nn.var_index = n.var_index;
+    nn.ch.reserve(n.ch.size());
+    for (int c : n.ch) nn.ch.push_back(memo[c]);
+    int out = dst.add(std::move(nn));
+    if (stats) ++stats->visited;
+    rules.clear();
+    index.candidates(dst, out, rules);
+    for (const Rule* r : rules) {
+      bind.clear(); mbind.clear();
+      if (stats) ++stats->attempts;
+      if (match_node(dst, out, r->lhs, bind, mbind) && (!r->guard || r->guard(dst, bind, mbind))) {
+        const int rid = instantiate_in_place(r->rhs, dst, bind, mbind);
+        if (rid < 0) continue;
+        if (cost && cost->rewrite_delta(dst, out, rid) > 0.0) { if (stats) ++stats->rejected; continue; }
+        out = rid; if (stats) ++stats->rewrites;
+        break;
       }
     }
+    memo[cur] = out;
   }
-
-  // No rule matched: rebuild node with rewritten children
-  RNode nn; nn.kind = n.kind; nn.cval = n.cval; nn.var_index = n.var_index; nn.ch = std::move(ch);
-  return dst.add(std::move(nn));
+  return memo[id];
 }
 
-inline RGraph apply_rules_once(const RGraph& g, const std::vector<Rule>& rules) {
-  // Sort rules by priority desc, stable
-  std::vector<const Rule*> order; order.reserve(rules.size());
-  for (auto& r : rules) order.push_back(&r);
-  std::stable_sort(order.begin(), order.end(), [](const Rule* a, const Rule* b){ return a->priority > b->priority; });
-  // Build a vector in sorted order
-  std::vector<Rule> sorted; sorted.reserve(rules.size());
-  for (auto* pr : order) sorted.push_back(*pr);
+// Rewrite a single node (postorder) into dst graph; returns dst node id
+inline int rewrite_node(const RGraph& src, int id, const std::vector<Rule>& rules,
+                        RGraph& dst) {
+  RuleIndex index(rules);
+  std::vector<int> memo(src.nodes.size(), -1);
+  return rewrite_subgraph(src, id, index, dst, memo);
+}
 
-  RGraph dst;
-  dst.root = rewrite_node(g, g.root, sorted, dst);
+inline RGraph apply_rules_once(const RGraph& g, const RuleIndex& index, RewritePassStats* stats = nullptr,
+                               const CostModel* cost = nullptr) {
+  RGraph dst = g.empty_like();
+  std::vector<int> memo(g.nodes.size(), -1);
+  dst.root = rewrite_subgraph(g, g.root, index, dst, memo, stats, cost);
   return dst;
 }
 
-inline RGraph rewrite_fixed_point(const RGraph& g0, const std::vector<Rule>& rules, int max_passes = 5) {
+inline RGraph apply_rules_once(const RGraph& g, const std::vector<Rule>& rules, RewritePassStats* stats = nullptr,
+                               const CostModel* cost = nullptr) {
+  return apply_rules_once(g, RuleIndex(rules), stats, cost);
+}
+
+// `cost` (optional) rejects rewrites that increase the model's cost
+inline RGraph rewrite_fixed_point(const RGraph& g0, const std::vector<Rule>& rules, int max_passes = 5,
+                                  const CostModel* cost = nullptr) {
+  const RuleIndex index(rules); // built once for all passes
   RGraph prev = g0;
   for (int i = 0; i < max_passes; ++i) {
-    RGraph cur = apply_rules_once(prev, rules);
+    RGraph cur = apply_rules_once(prev, index, nullptr, cost);
     // Normalize to canonical form between passes
     cur = normalize(cur);
-    if (cur.nodes.size() == prev.nodes.size() && r_equal(cur, cur.root, prev.root)) return cur;
+    if (cur.nodes.size() == prev.nodes.size() && r_equal(cur, cur.root, prev, prev.root)) return cur;
     prev = std::move(cur);
   }
   return prev;
@@ -0,0 +1,196 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/match.hpp"
+#include "et/rewrite.hpp"
+
+namespace et {
+
+// Copy of the part of g reachable from g.root, in id order, into a graph in
+// g's mode (drops nodes left behind by in-place rewriting)
+inline RGraph r_compact(const RGraph& g) {
+  RGraph out = g.empty_like();
+  if (g.root < 0) return out;
+  std::vector<char> live(g.nodes.size(), 0);
+  live[g.root] = 1;
+  for (int i = g.root; i >= 0; --i)
+    if (live[i]) for (int c : g.nodes[i].ch) live[c] = 1;
+  std::vector<int> remap(g.nodes.size(), -1);
+  for (int i = 0; i <= g.root; ++i) {
+    if (!live[i]) continue;
+    RNode n = g.nodes[i];
+    for (int& c : n.ch) c = remap[c];
+    remap[i] = out.add(std::move(n));
+  }
+  out.root = remap[g.root];
+  return out;
+}
+
+struct WorklistStats {
+  std::size_t visited = 0;   // worklist entries examined
+  std::size_t attempts = 0;  // rule matches tried
+  std::size_t rewrites = 0;  // rules fired
+  std::size_t rebuilt = 0;   // ancestors re-created after a change below them
+  std::size_t rejected = 0;  // matches dropped by the cost model
+};
+
+// Incremental rewriting to a fixed point. Instead of rebuilding the whole
+// graph every pass, the rewriter keeps parent links and a worklist: when a
+// rule replaces a node, only its ancestors are rebuilt (re-normalized locally
+// with normalize_node, so Add/Mul stay flat and sorted) and re-queued, along
+// with the freshly instantiated nodes. Untouched subgraphs are never visited
+// again. Expects a normalized input; stops when the worklist drains or after
+// max_rewrites rule applications. Nodes are append-only, so the working
+// graph is compacted at the end. `cost` (optional) rejects rewrites whose
+// normalized RHS costs more than the node it replaces.
+inline RGraph rewrite_worklist(const RGraph& g, const std::vector<Rule>& rules,
+                               std::size_t max_rewrites = 100000, WorklistStats* stats = nullptr,
+                               const CostModel* cost = nullptr) {
+  const RuleIndex index(rules);
+  std::vector<const Rule*> cands;
+
+  // Work without interning: a rebuilt node must get a fresh id even when an
+  // equal (possibly replaced) node already exists
+  RGraph w;
+  w.nodes = g.nodes;
+  w.root = g.root;
+  if (w.root < 0) return g;
+
+  std::vector<std::vector<int>> parents(w.nodes.size());
+  std::vector<char> dead(w.nodes.size(), 0), queued(w.nodes.size(), 0);
+  std::deque<int> work;
+  auto grow = [&]() {
+    const std::size_t n = w.nodes.size();
+    if (parents.size() < n) { parents.resize(n); dead.resize(n, 0); queued.resize(n, 0); }
+  };
+  auto enqueue = [&](int id) { if (!queued[id]) { queued[id] = 1; work.push_back(id); } };
+
+  // Links new nodes (ids >= mark) reachable from `top` into the structure:
+  // registers them as parents of their children and queues them, children first
+  auto adopt = [&](int top, int mark) {
+    grow();
+    if (top < mark) return;
+    std::vector<int> order_new, stack{ top };
+    std::vector<char> seen(w.nodes.size() - (std::size_t)mark, 0); // new nodes only
+    while (!stack.empty()) {
+      int id = stack.back(); stack.pop_back();
+      if (id < mark || seen[id - mark]) continue;
+      seen[id - mark] = 1;
+      order_new.push_back(id);
+      for (int c : w.nodes[id].ch) stack.push_back(c);
+    }
+    std::sort(order_new.begin(), order_new.end());
+    for (int id : order_new) {
+      for (int c : w.nodes[id].ch) parents[c].push_back(id);
+      enqueue(id);
+    }
+  };
+
+  // Reachable part of the input: parent links and a bottom-up initial worklist
+  {
+    std::vector<char> live(w.nodes.size(), 0);
+    live[w.root] = 1;
+    for (int i = w.root; i >= 0; --i)
+      if (live[i]) for (int c : w.nodes[i].ch) live[c] = 1;
+    for (int i = 0; i <= w.root; ++i) {
+      if (!live[i]) continue;
+      for (int c : w.nodes[i].ch) parents[c].push_back(i);
+      enqueue(i);
+    }
+  }
+
+  // Replaces `from` by `to` and rebuilds every live ancestor on the way up
+  auto replace = [&](int from, int to) {
+    std::vector<std::pair<int,int>> pending{ {from, to} };
+    while (!pending.empty()) {
+      auto [old_id, new_id] = pending.back(); pending.pop_back();
+      if (dead[old_id]) continue;
+      dead[old_id] = 1;
+      if (w.root == old_id) w.root = new_id;
+      // a parent using old_id twice (Pow(t,t)) is listed twice; rebuild it once
+      std::vector<int> ps = parents[old_id];
+      std::sort(ps.begin(), ps.end());
+      ps.erase(std::unique(ps.begin(), ps.end()), ps.end());
+      for (int p : ps) {
+        if (dead[p]) continue;
+        std::vector<int> ch = w.nodes[p].ch;
+        bool touched = false;
+        for (int& c : ch) if (c == old_id) { c = new_id; touched = true; }
+        if (!touched) continue;
+        const RNode& pn = w.nodes[p];
+        const NodeKind kind = pn.kind; const double cval = pn.cval; const std::size_t vi = pn.var_index;
+        const int mark = (int)w.nodes.size();
+        const int np = normalize_node(w, kind, ch, cval, vi);
+        adopt(np, mark);
+        if (stats) ++stats->rebuilt;
+        pending.push_back({ p, np });
+      }
+    }
+  };
+
+  // Normalizes the nodes of a fresh RHS instance (ids >= mark) bottom-up
+  auto renormalize = [&](int top, int mark) {
+    std::vector<int> memo;
+    std::vector<std::pair<int,bool>> stack{ {top, false} };
+    auto slot = [&](int id) -> int& {
+      const std::size_t k = (std::size_t)(id - mark);
+      if (memo.size() <= k) memo.resize(k + 1, -1);
+      return memo[k];
+    };
+    while (!stack.empty()) {
+      auto [id, expanded] = stack.back();
+      if (id < mark || slot(id) != -1) { stack.pop_back(); continue; }
+      if (!expanded) {
+        stack.back().second = true;
+        for (int c : w.nodes[id].ch) if (c >= mark && slot(c) == -1) stack.push_back({ c, false });
+        continue;
+      }
+      stack.pop_back();
+      const RNode& n = w.nodes[id];
+      std::vector<int> ch; ch.reserve(n.ch.size());
+      for (int c : n.ch) ch.push_back(c >= mark ? slot(c) : c);
+      const NodeKind kind = n.kind; const double cval = n.cval; const std::size_t vi = n.var_index;
+      const int r = normalize_node(w, kind, ch, cval, vi);
+      slot(id) = r;
+    }
+    return top < mark ? top : slot(top);
+  };
+
+  std::size_t fired = 0;
+  Bindings bind; MultiBindings mbind;
+  while (!work.empty() && fired < max_rewrites) {
+    const int id = work.front(); work.pop_front();
+    queued[id] = 0;
+    if (dead[id]) continue;
+    if (stats) ++stats->visited;
+    cands.clear();
+    index.candidates(w, id, cands);
+    for (const Rule* r : cands) {
+      bind.clear(); mbind.clear();
+      if (stats) ++stats->attempts;
+      if (!match_node(w, id, r->lhs, bind, mbind) || (r->guard && !r->guard(w, bind, mbind))) continue;
+      const int mark = (int)w.nodes.size();
+      int rid = instantiate_in_place(r->rhs, w, bind, mbind);
+      if (rid < 0) continue;
+      rid = renormalize(rid, mark);
+      if (rid == id || r_equal(w, rid, id)) continue; // no structural change
+      if (cost && cost->rewrite_delta(w, id, rid) > 0.0) { if (stats) ++stats->rejected; continue; }
+      adopt(rid, mark);
+      replace(id, rid);
+      ++fired;
+      if (stats) ++stats->rewrites;
+      break;
+    }
+  }
+
+  RGraph out = r_compact(w);
+  if (g.interning) out = intern(out);
+  return out;
+}
+
+} // namespace et
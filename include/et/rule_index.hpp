@@ -0,0 +1,144 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "et/runtime_ast.hpp"
+#include "et/pattern.hpp"
+#include "et/match.hpp"
+
+namespace et {
+
+struct Rule {
+  pat::Pattern lhs;
+  pat::Pattern rhs;
+  std::function<bool(const RGraph&, const Bindings&, const MultiBindings&)> guard; // optional
+  const char* name = "";
+  int priority = 0;
+};
+
+// Compiled index over a rule set: a discrimination tree on the preorder walk
+// of each LHS. Every pattern node contributes its NodeKind as a symbol;
+// placeholders are wildcards that skip a whole term subtree, and AC (Add/Mul)
+// pattern nodes stop the descent after their head symbol since their children
+// are matched as a multiset. A lookup walks the term alongside the tree
+// (following both the exact and the wildcard edge) and yields a superset of
+// the rules match_node can accept, in priority order. Root-level AC rules are
+// additionally filtered by arity and by the kinds of their concrete children.
+// The index points into the rule vector it was built from, which must outlive it.
+struct RuleIndex {
+  static constexpr std::size_t kKinds = kNodeKinds;
+  static constexpr std::size_t kWild = kKinds; // edge slot for placeholders
+
+  struct TrieNode {
+    std::array<int, kKinds + 1> next;
+    std::vector<int> rules; // ranks of the rules whose LHS ends here
+    TrieNode() { next.fill(-1); }
+  };
+
+  // Cheap necessary conditions for a root-level AC pattern
+  struct AcFilter {
+    std::size_t min_arity = 0, max_arity = 0;           // max is SIZE_MAX with a spread
+    std::array<std::uint32_t, kKinds> need{};            // concrete children per kind
+  };
+
+  std::vector<const Rule*> order;   // all rules, priority desc (stable): index = rank
+  std::vector<TrieNode> trie;
+  std::vector<char> has_ac_filter;  // per rank
+  std::vector<AcFilter> ac_filter;  // per rank
+
+  RuleIndex() : trie(1) {}
+  explicit RuleIndex(const std::vector<Rule>& rules) : trie(1) {
+    order.reserve(rules.size());
+    for (auto& r : rules) order.push_back(&r);
+    std::stable_sort(order.begin(), order.end(), [](const Rule* a, const Rule* b){ return a->priority > b->priority; });
+    has_ac_filter.assign(order.size(), 0);
+    ac_filter.resize(order.size());
+    for (std::size_t rank = 0; rank < order.size(); ++rank) insert((int)rank);
+  }
+
+  std::size_t size() const { return order.size(); }
+
+  // Appends the rules that may match node `id` of g to `out`, in priority order
+  void candidates(const RGraph& g, int id, std::vector<const Rule*>& out) const {
+    std::vector<int> ranks, pending{ id };
+    collect(g, 0, pending, ranks);
+    std::sort(ranks.begin(), ranks.end());
+    const RNode& n = g.nodes[id];
+    std::array<std::uint32_t, kKinds> have{};
+    if (is_ac(n.kind)) for (int c : n.ch) ++have[std::size_t(g.nodes[c].kind)];
+    for (int rank : ranks)
+      if (!has_ac_filter[rank] || ac_admits(ac_filter[rank], n, have)) out.push_back(order[rank]);
+  }
+
+private:
+  static bool is_spread(const pat::Pattern& p) { return p.kind == pat::Pattern::Kind::Placeholder && p.is_spread; }
+
+  int edge(int tn, std::size_t slot) {
+    if (trie[tn].next[slot] < 0) {
+      const int nn = (int)trie.size();
+      trie.emplace_back();
+      trie[tn].next[slot] = nn;
+    }
+    return trie[tn].next[slot];
+  }
+
+  void insert(int rank) {
+    const pat::Pattern& lhs = order[rank]->lhs;
+    int tn = 0;
+    std::vector<const pat::Pattern*> stack{ &lhs };
+    while (!stack.empty()) {
+      const pat::Pattern* p = stack.back(); stack.pop_back();
+      if (p->kind == pat::Pattern::Kind::Placeholder) { tn = edge(tn, kWild); continue; }
+      tn = edge(tn, std::size_t(p->node_kind));
+      if (is_ac(p->node_kind)) continue;
+      for (auto it = p->ch.rbegin(); it != p->ch.rend(); ++it) stack.push_back(&*it);
+    }
+    trie[tn].rules.push_back(rank);
+
+    if (lhs.kind == pat::Pattern::Kind::Node && is_ac(lhs.node_kind)) {
+      AcFilter& f = ac_filter[rank];
+      std::size_t spreads = 0;
+      for (const auto& c : lhs.ch) {
+        if (is_spread(c)) { ++spreads; continue; }
+        ++f.min_arity;
+        if (c.kind == pat::Pattern::Kind::Node) ++f.need[std::size_t(c.node_kind)];
+      }
+      f.max_arity = spreads ? ~std::size_t(0) : f.min_arity;
+      has_ac_filter[rank] = 1;
+    }
+  }
+
+  // `pending` holds the term ids still to be consumed, next one at the back
+  void collect(const RGraph& g, int tn, std::vector<int>& pending, std::vector<int>& ranks) const {
+    if (pending.empty()) {
+      ranks.insert(ranks.end(), trie[tn].rules.begin(), trie[tn].rules.end());
+      return;
+    }
+    const int id = pending.back(); pending.pop_back();
+    if (trie[tn].next[kWild] >= 0) collect(g, trie[tn].next[kWild], pending, ranks);
+    const RNode& n = g.nodes[id];
+    const int exact = trie[tn].next[std::size_t(n.kind)];
+    if (exact >= 0) {
+      if (is_ac(n.kind)) {
+        collect(g, exact, pending, ranks);
+      } else {
+        for (auto it = n.ch.rbegin(); it != n.ch.rend(); ++it) pending.push_back(*it);
+        collect(g, exact, pending, ranks);
+        pending.resize(pending.size() - n.ch.size());
+      }
+    }
+    pending.push_back(id);
+  }
+
+  static bool ac_admits(const AcFilter& f, const RNode& n, const std::array<std::uint32_t, kKinds>& have) {
+    if (n.ch.size() < f.min_arity || n.ch.size() > f.max_arity) return false;
+    for (std::size_t k = 0; k < kKinds; ++k) if (have[k] < f.need[k]) return false;
+    return true;
+  }
+};
+
+} // namespace et
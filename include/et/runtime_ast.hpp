@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
+#include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <cstdint>
 #include <utility>
 #include <type_traits>
@@ -10,6 +12,8 @@
 #include <cmath>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "et/expr.hpp"
 
@@ -19,26 +23,124 @@ namespace et {
 enum class NodeKind : uint8_t {
   Var, Const,
   Add, Sub, Mul, Div, Pow,
-  Neg, Sin, Cos, Exp, Log, Sqrt, Tanh
+  Neg, Sin, Cos, Exp, Log, Sqrt, Tanh,
+  Recip, Rsqrt
 };
+// Number of NodeKind values, for tables indexed by kind
+constexpr std::size_t kNodeKinds = std::size_t(NodeKind::Rsqrt) + 1;
 
 struct RNode {
   NodeKind kind{};
   std::vector<int> ch;     // children node ids
   double cval = 0.0;       // for Const
   std::size_t var_index{}; // for Var
+  // Filled in by RGraph::add from the children's cached values
+  std::uint64_t hash = 0;  // structural hash of the subtree (see r_hash)
+  std::uint32_t depth = 0; // longest path down to a leaf; leaves are 0
+  std::uint32_t size = 1;  // node count of the subtree as a tree, saturating
 };
 
+// Combiner used for structural hashes
+inline std::uint64_t r_hash_mix(std::uint64_t h, std::uint64_t x) {
+  x ^= x >> 33; x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33; return h ^ (x + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2));
+}
+
 struct RGraph {
   std::vector<RNode> nodes;
   int root = -1;
 
+  // Hash-consing mode: add() returns the existing id of a node with the same
+  // kind, constant bits, var index and child ids, so in an interned graph
+  // structurally equal subtrees are the same id. Enable it on an empty graph
+  // (or build one with intern()); nodes must not be mutated after add().
+  bool interning = false;
+  std::unordered_multimap<std::uint64_t, int> index; // shallow key -> node id
+  std::size_t intern_hits = 0;                        // add() calls answered from the index
+
+  void enable_interning() { assert(nodes.empty()); interning = true; }
+
+  // Empty graph in the same mode; passes that build a new graph start from this
+  RGraph empty_like() const { RGraph g; g.interning = interning; return g; }
+
   int add(RNode n) {
+    seal(n);
+    if (interning) {
+      const std::uint64_t key = shallow_key(n);
+      auto range = index.equal_range(key);
+      for (auto it = range.first; it != range.second; ++it)
+        if (shallow_equal(nodes[it->second], n)) { ++intern_hits; return it->second; }
+      nodes.push_back(std::move(n));
+      const int id = (int)nodes.size() - 1;
+      index.emplace(key, id);
+      return id;
+    }
     nodes.push_back(std::move(n));
     return (int)nodes.size() - 1;
   }
+
+  // Computes n's cached hash/depth/size from its (already added) children
+  void seal(RNode& n) const {
+    std::uint64_t h = r_hash_mix(1469598103934665603ULL, static_cast<std::uint64_t>(n.kind));
+    std::uint32_t depth = 0;
+    std::uint64_t size = 1;
+    if (n.kind == NodeKind::Const) {
+      const double v = n.cval == 0.0 ? 0.0 : n.cval; // -0 == +0 for r_equal
+      std::uint64_t u; std::memcpy(&u, &v, sizeof u); h = r_hash_mix(h, u);
+    } else if (n.kind == NodeKind::Var) h = r_hash_mix(h, static_cast<std::uint64_t>(n.var_index));
+    else {
+      for (int c : n.ch) {
+        const RNode& cn = nodes[c];
+        h = r_hash_mix(h, cn.hash);
+        depth = std::max(depth, cn.depth + 1);
+        size += cn.size;
+      }
+    }
+    n.hash = h;
+    n.depth = depth;
+    n.size = (std::uint32_t)std::min<std::uint64_t>(size, std::numeric_limits<std::uint32_t>::max());
+  }
+
+  // Key over the node's own fields and child ids (not the child structures)
+  static std::uint64_t shallow_key(const RNode& n) {
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    auto mix = [&](std::uint64_t x) { h ^= x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2); };
+    mix(static_cast<std::uint64_t>(n.kind));
+    if (n.kind == NodeKind::Const) {
+      const double v = n.cval == 0.0 ? 0.0 : n.cval; // -0 and +0 intern to one node, as r_equal
+      std::uint64_t u; std::memcpy(&u, &v, sizeof u); mix(u);
+    }
+    else if (n.kind == NodeKind::Var) mix(static_cast<std::uint64_t>(n.var_index));
+    for (int c : n.ch) mix(static_cast<std::uint64_t>(static_cast<std::uint32_t>(c)));
+    return h;
+  }
+
+  static bool shallow_equal(const RNode& a, const RNode& b) {
+    if (a.kind != b.kind || a.ch != b.ch) return false;
+    if (a.kind == NodeKind::Const) {
+      if (a.cval == 0.0 && b.cval == 0.0) return true;
+      return std::memcmp(&a.cval, &b.cval, sizeof a.cval) == 0;
+    }
+    if (a.kind == NodeKind::Var) return a.var_index == b.var_index;
+    return true;
+  }
 };
 
+// Interned copy of g: duplicate subtrees collapse to one id. Relies on the
+// usual id order (children before parents).
+inline RGraph intern(const RGraph& g) {
+  RGraph out; out.enable_interning();
+  std::vector<int> remap(g.nodes.size(), -1);
+  for (std::size_t i = 0; i < g.nodes.size(); ++i) {
+    RNode n = g.nodes[i];
+    for (int& c : n.ch) c = remap[c];
+    remap[i] = out.add(std::move(n));
+  }
+  out.root = g.root >= 0 ? remap[g.root] : -1;
+  return out;
+}
+
 // Map ET op tag to NodeKind
 template <class Op> struct nodekind_of;
 template <> struct nodekind_of<AddOp>  { static constexpr NodeKind value = NodeKind::Add; };
@@ -53,6 +155,8 @@ template <> struct nodekind_of<ExpOp>  { static constexpr NodeKind value = NodeK
 template <> struct nodekind_of<LogOp>  { static constexpr NodeKind value = NodeKind::Log; };
 template <> struct nodekind_of<SqrtOp> { static constexpr NodeKind value = NodeKind::Sqrt; };
 template <> struct nodekind_of<TanhOp> { static constexpr NodeKind value = NodeKind::Tanh; };
+template <> struct nodekind_of<RecipOp> { static constexpr NodeKind value = NodeKind::Recip; };
+template <> struct nodekind_of<RsqrtOp> { static constexpr NodeKind value = NodeKind::Rsqrt; };
 
 // Compile ET expression to runtime graph (returns node id)
 template <class T, std::size_t I>
@@ -73,12 +177,14 @@ inline int compile_to_runtime(const Apply<Op,Ch...>& a, RGraph& g) {
   return g.add(std::move(n));
 }
 
-// Structural equality on subtrees
+// Structural equality on subtrees (id equality in an interned graph). Cached
+// hashes reject almost all unequal pairs without descending.
 inline bool r_equal(const RGraph& g, int a, int b) {
   if (a == b) return true;
+  if (g.interning) return false;
   const RNode& na = g.nodes[a];
   const RNode& nb = g.nodes[b];
-  if (na.kind != nb.kind) return false;
+  if (na.hash != nb.hash || na.kind != nb.kind) return false;
   if (na.kind == NodeKind::Const) return na.cval == nb.cval;
   if (na.kind == NodeKind::Var)   return na.var_index == nb.var_index;
   if (na.ch.size() != nb.ch.size()) return false;
@@ -87,6 +193,24 @@ inline bool r_equal(const RGraph& g, int a, int b) {
   return true;
 }
 
+// Structural equality across two graphs; pairs already compared are skipped,
+// so shared subgraphs are walked once
+inline bool r_equal(const RGraph& ga, int a, const RGraph& gb, int b) {
+  std::vector<std::pair<int,int>> stack{ {a, b} };
+  std::unordered_set<std::uint64_t> seen;
+  while (!stack.empty()) {
+    auto [x, y] = stack.back(); stack.pop_back();
+    const RNode& nx = ga.nodes[x];
+    const RNode& ny = gb.nodes[y];
+    if (nx.hash != ny.hash || nx.kind != ny.kind || nx.ch.size() != ny.ch.size()) return false;
+    if (nx.kind == NodeKind::Const && !(nx.cval == ny.cval)) return false;
+    if (nx.kind == NodeKind::Var && nx.var_index != ny.var_index) return false;
+    if (!seen.insert((std::uint64_t(std::uint32_t(x)) << 32) | std::uint32_t(y)).second) continue;
+    for (std::size_t i = 0; i < nx.ch.size(); ++i) stack.push_back({ nx.ch[i], ny.ch[i] });
+  }
+  return true;
+}
+
 // Evaluate runtime graph numerically given input vector (by var_index)
 inline double eval(const RGraph& g, const std::vector<double>& inputs) {
   std::vector<double> memo(g.nodes.size(), std::numeric_limits<double>::quiet_NaN());
@@ -109,6 +233,8 @@ inline double eval(const RGraph& g, const std::vector<double>& inputs) {
       case NodeKind::Log:   slot = std::log(rec(n.ch[0])); break;
       case NodeKind::Sqrt:  slot = std::sqrt(rec(n.ch[0])); break;
       case NodeKind::Tanh:  slot = std::tanh(rec(n.ch[0])); break;
+      case NodeKind::Recip: slot = 1.0 / rec(n.ch[0]); break;
+      case NodeKind::Rsqrt: slot = 1.0 / std::sqrt(rec(n.ch[0])); break;
     }
     return slot;
   };
@@ -149,6 +275,8 @@ inline std::string r_to_string(const RGraph& g) {
       case NodeKind::Log:   return std::string("Log(") + rec(n.ch[0]) + ")";
       case NodeKind::Sqrt:  return std::string("Sqrt(") + rec(n.ch[0]) + ")";
       case NodeKind::Tanh:  return std::string("Tanh(") + rec(n.ch[0]) + ")";
+      case NodeKind::Recip: return std::string("Recip(") + rec(n.ch[0]) + ")";
+      case NodeKind::Rsqrt: return std::string("Rsqrt(") + rec(n.ch[0]) + ")";
     }
     return "";
   };
@@ -207,6 +335,8 @@ inline auto build_et(const RGraph& g, int id) {
     case NodeKind::Log: { auto a = build_et<T>(g, n.ch[0]); return Apply<LogOp, decltype(a)>(std::move(a)); }
     case NodeKind::Sqrt:{ auto a = build_et<T>(g, n.ch[0]); return Apply<SqrtOp, decltype(a)>(std::move(a)); }
     case NodeKind::Tanh:{ auto a = build_et<T>(g, n.ch[0]); return Apply<TanhOp, decltype(a)>(std::move(a)); }
+    case NodeKind::Recip:{ auto a = build_et<T>(g, n.ch[0]); return Apply<RecipOp, decltype(a)>(std::move(a)); }
+    case NodeKind::Rsqrt:{ auto a = build_et<T>(g, n.ch[0]); return Apply<RsqrtOp, decltype(a)>(std::move(a)); }
     case NodeKind::Add:  return fold_nary_build<T,AddOp>(g, n);
     case NodeKind::Sub:  return make_bin_build<T,SubOp>(g, n);
     case NodeKind::Mul:  return fold_nary_build<T,MulOp>(g, n);
@@ -223,8 +353,9 @@ inline auto to_et(const RGraph& g) {
 
 // Entry: end-to-end ET -> runtime graph
 template <class Expr>
-inline RGraph compile_to_runtime(const Expr& e) {
+inline RGraph compile_to_runtime(const Expr& e, bool interned = false) {
   RGraph g;
+  if (interned) g.enable_interning();
   g.root = compile_to_runtime(e, g);
   return g;
 }
@@ -101,6 +101,28 @@ constexpr auto simplify(const Apply<TanhOp, A>& node) {
   }
 }
 
+template <class A>
+constexpr auto simplify(const Apply<RecipOp, A>& node) {
+  auto a = simplify(node.template child<0>());
+  if constexpr (is_const_node_v<decltype(a)>) {
+    using T = typename decltype(a)::value_type;
+    return Const<T>{ T(1) / const_value<decltype(a)>::get(a) };
+  } else {
+    return Apply<RecipOp, decltype(a)>(std::move(a));
+  }
+}
+template <class A>
+constexpr auto simplify(const Apply<RsqrtOp, A>& node) {
+  auto a = simplify(node.template child<0>());
+  if constexpr (is_const_node_v<decltype(a)>) {
+    using T = typename decltype(a)::value_type;
+    using std::sqrt;
+    return Const<T>{ T(1) / sqrt(const_value<decltype(a)>::get(a)) };
+  } else {
+    return Apply<RsqrtOp, decltype(a)>(std::move(a));
+  }
+}
+
 // ---- binary ops: only fold when BOTH sides are Const; otherwise rebuild
 template <class L, class R>
 constexpr auto simplify_add(L&& l, R&& r) {
@@ -0,0 +1,88 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "et/runtime_ast.hpp"
+
+namespace et {
+
+struct StrengthReduceStats {
+  std::size_t pows = 0;    // Pow nodes with a constant exponent
+  std::size_t lowered = 0; // of those, replaced by cheaper ops
+  std::size_t muls = 0;    // binary Mul nodes created for power chains
+};
+
+// Lowers Pow with a constant exponent to cheaper operations:
+//   x^0 -> 1, x^1 -> x, x^0.5 -> Sqrt(x), x^-0.5 -> Rsqrt(x), x^-1 -> Recip(x),
+//   x^n -> a binary Mul chain by repeated squaring (|n| <= max_exponent),
+//   x^-n -> Recip of that chain.
+// Powers of the same base are cached, so x^2, x^3 and x^6 share t = x*x and
+// t*x. Other exponents are kept as Pow. Binary Mul nodes are emitted as they
+// are; run this after normalize/rewriting (which would flatten the chains
+// back into n-ary products) and right before compile_runtime.
+inline RGraph strength_reduce(const RGraph& g, int max_exponent = 32, StrengthReduceStats* stats = nullptr) {
+  RGraph dst = g.empty_like();
+  if (g.root < 0) return dst;
+  dst.nodes.reserve(g.nodes.size());
+  std::vector<int> memo(g.nodes.size(), -1);
+  std::unordered_map<std::uint64_t, int> powers; // (base id, k) -> id of base^k
+
+  auto unary = [&](NodeKind k, int a) { RNode n; n.kind = k; n.ch = { a }; return dst.add(std::move(n)); };
+  auto constant = [&](double v) { RNode n; n.kind = NodeKind::Const; n.cval = v; return dst.add(std::move(n)); };
+
+  // base^k for k >= 1: x^(2m) = (x^m)^2, x^(2m+1) = x^(2m) * x
+  auto power = [&](int base, unsigned k) {
+    std::vector<unsigned> chain; // exponents still to build, largest first
+    for (unsigned e = k; e > 1 && !powers.count((std::uint64_t(base) << 32) | e); e = (e % 2) ? e - 1 : e / 2)
+      chain.push_back(e);
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+      const unsigned e = *it;
+      auto get = [&](unsigned j) { return j == 1 ? base : powers.at((std::uint64_t(base) << 32) | j); };
+      RNode n; n.kind = NodeKind::Mul;
+      n.ch = (e % 2) ? std::vector<int>{ get(e - 1), base } : std::vector<int>{ get(e / 2), get(e / 2) };
+      powers[(std::uint64_t(base) << 32) | e] = dst.add(std::move(n));
+      if (stats) ++stats->muls;
+    }
+    return k == 1 ? base : powers.at((std::uint64_t(base) << 32) | k);
+  };
+
+  // Lowered id of a Pow(base, c) node, or -1 to keep it
+  auto lower = [&](int base, double c) -> int {
+    if (dst.nodes[base].kind == NodeKind::Const) return constant(std::pow(dst.nodes[base].cval, c));
+    if (c == 0.0) return constant(1.0);
+    if (c == 0.5) return unary(NodeKind::Sqrt, base);
+    if (c == -0.5) return unary(NodeKind::Rsqrt, base);
+    const double m = std::fabs(c);
+    if (m != std::floor(m) || m > double(max_exponent)) return -1;
+    const int p = power(base, unsigned(m));
+    return c < 0.0 ? unary(NodeKind::Recip, p) : p;
+  };
+
+  // Iterative post-order, as in compile_runtime
+  std::vector<int> stack{ g.root };
+  while (!stack.empty()) {
+    const int id = stack.back();
+    if (memo[id] >= 0) { stack.pop_back(); continue; }
+    const RNode& n = g.nodes[id];
+    bool ready = true;
+    for (auto it = n.ch.rbegin(); it != n.ch.rend(); ++it)
+      if (memo[*it] < 0) { stack.push_back(*it); ready = false; }
+    if (!ready) continue;
+    stack.pop_back();
+    if (n.kind == NodeKind::Pow && g.nodes[n.ch[1]].kind == NodeKind::Const) {
+      if (stats) ++stats->pows;
+      const int r = lower(memo[n.ch[0]], g.nodes[n.ch[1]].cval);
+      if (r >= 0) { memo[id] = r; if (stats) ++stats->lowered; continue; }
+    }
+    RNode copy = n;
+    for (int& c : copy.ch) c = memo[c];
+    memo[id] = dst.add(std::move(copy));
+  }
+  dst.root = memo[g.root];
+  return dst;
+}
+
+} // namespace et
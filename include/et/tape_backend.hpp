@@ -5,70 +5,223 @@
 #include <cstdint>
 #include <algorithm>
 #include <type_traits>
+#include <utility>
+
+#include "et/dual.hpp"
+#include "et/vmath.hpp"
 
 namespace et {
 
-struct Tape {
-  enum Kind : uint8_t { KVar, KConst, KAdd, KSub, KMul, KDiv, KPow, KNeg, KSin, KExp, KLog, KSqrt, KTanh, KCos };
+// Instruction kinds shared by every scalar type of BasicTape
+struct TapeKinds {
+  enum Kind : uint8_t { KVar, KConst, KAdd, KSub, KMul, KDiv, KPow, KNeg, KSin, KExp, KLog, KSqrt, KTanh, KCos,
+              KSum, KProd,  // n-ary: operands are args[a .. a+b)
+              KRecip, KRsqrt,
+              // Produced by fuse_tape (et/tape_fuse.hpp): KFma/KFms are a*b +/- e,
+              // KSquare is a*a, and a KSinCos node (value sin a) is always directly
+              // followed by its KCosPair (value cos a), which sweeps fill together
+              KFma, KFms, KSquare, KSinCos, KCosPair };
+
+  static bool is_nary(Kind k) { return k == KSum || k == KProd; }
+};
+
+// Linear instruction tape over the scalar Real (constants, values, batch
+// lanes, tangents). Acc is the type of adjoints, gradients and local partials
+// and of the running sum/product of KSum/KProd, so BasicTape<float, double>
+// stores and evaluates in float but accumulates reductions and the reverse
+// sweep in double. Tape is the double instantiation used by everything else.
+template <class Real, class Acc = Real>
+struct BasicTape : TapeKinds {
+  using value_type = Real;
+  using acc_type = Acc;
 
   struct Node {
     Kind kind;
     int  a = -1;
     int  b = -1;
-    double c = 0;
+    int  e = -1; // third operand (KFma/KFms)
+    Real c = 0;
     std::size_t var_index = ~std::size_t(0);
   };
 
   std::vector<Node> nodes;
   int output_id = -1;
+  // Multi-output tapes list every output here (output_id aliases outputs[0]);
+  // single-output tapes may leave it empty and set only output_id.
+  std::vector<int> outputs;
+  std::size_t arity = 0; // number of inputs (max var_index + 1), maintained by TapeBackend; see input_count()
+  // Operand lists of the n-ary reductions KSum/KProd; such a node stores its
+  // offset into args in `a` and its operand count in `b`.
+  std::vector<int> args;
+  std::size_t max_args = 0; // longest operand list, sizes Workspace::scratch
+
+  // a*b + c, rounded once when the target has a fast fma
+  template <class S>
+  static S fmadd(const S& a, const S& b, const S& c) {
+#ifdef FP_FAST_FMA
+    if constexpr (std::is_same<S, double>::value) return std::fma(a, b, c);
+#endif
+#ifdef FP_FAST_FMAF
+    if constexpr (std::is_same<S, float>::value) return std::fma(a, b, c);
+#endif
+    return a * b + c;
+  }
+
+  // Scratch buffers sized once from a tape. Evaluating through a workspace
+  // performs no heap allocation, so one workspace can be reused across calls.
+  struct Workspace {
+    std::vector<Real> val;
+    std::vector<Acc> bar;
+    std::vector<Real> block;  // batch lanes, grown on first forward_batch call
+    std::vector<Real> dot;    // forward-mode tangents, grown on first jvp call
+    std::vector<Acc> partial; // local partials, grown on first value_and_grad call
+    std::vector<Dual<Real>> dval, dbar, dio; // second-order sweeps, grown on first hvp call
+    std::vector<Acc> scratch;                // KProd prefix products in reverse sweeps
+    std::vector<Dual<Real>> dscratch;
+    Workspace() = default;
+    explicit Workspace(const BasicTape& t) { reset(t); }
+    void reset(const BasicTape& t) {
+      val.assign(t.nodes.size(), 0.0);
+      bar.assign(t.nodes.size(), 0.0);
+      scratch.assign(t.max_args, 0.0);
+    }
+  };
 
-  double forward(const std::vector<double>& inputs) const {
-    std::vector<double> val(nodes.size());
+  // Value of one instruction given operand values in val (indexed by the
+  // node's operand fields). Templated on the scalar so the same op semantics
+  // serve plain values and derived number types; on Real, KSum/KProd
+  // accumulate in Acc.
+  template <class S>
+  S node_value(const Node& n, const S* val, const S* inputs) const {
+    using R = std::conditional_t<std::is_same<S, Real>::value, Acc, S>;
+    using std::pow; using std::sin; using std::cos; using std::exp;
+    using std::log; using std::sqrt; using std::tanh;
+    switch (n.kind) {
+      case KVar:  return inputs[n.var_index];
+      case KConst:return S(n.c);
+      case KAdd:  return val[n.a] + val[n.b];
+      case KSub:  return val[n.a] - val[n.b];
+      case KMul:  return val[n.a] * val[n.b];
+      case KDiv:  return val[n.a] / val[n.b];
+      case KPow:  return pow(val[n.a], val[n.b]);
+      case KNeg:  return -val[n.a];
+      case KSin:  return sin(val[n.a]);
+      case KExp:  return exp(val[n.a]);
+      case KLog:  return log(val[n.a]);
+      case KSqrt: return sqrt(val[n.a]);
+      case KTanh: return tanh(val[n.a]);
+      case KCos:  return cos(val[n.a]);
+      case KRecip:return S(1.0) / val[n.a];
+      case KRsqrt:return S(1.0) / sqrt(val[n.a]);
+      case KFma:  return fmadd(val[n.a], val[n.b], val[n.e]);
+      case KFms:  return fmadd(val[n.a], val[n.b], -val[n.e]);
+      case KSquare: return val[n.a] * val[n.a];
+      case KSinCos: return sin(val[n.a]);
+      case KCosPair:return cos(val[n.a]);
+      case KSum: {
+        const int* p = &args[n.a];
+        R acc = R(val[p[0]]);
+        for (int k = 1; k < n.b; ++k) acc += R(val[p[k]]);
+        return S(acc); }
+      case KProd: {
+        const int* p = &args[n.a];
+        R acc = R(val[p[0]]);
+        for (int k = 1; k < n.b; ++k) acc = acc * R(val[p[k]]);
+        return S(acc); }
+    }
+    return S(0.0);
+  }
+
+  // Primal sweep: val[i] for every node
+  template <class S>
+  void forward_sweep(const S* inputs, S* val) const {
+    using std::sin; using std::cos;
     for (int i = 0; i < (int)nodes.size(); ++i) {
-      const auto& n = nodes[i];
-      switch (n.kind) {
-        case KVar:  val[i] = inputs[n.var_index]; break;
-        case KConst:val[i] = n.c; break;
-        case KAdd:  val[i] = val[n.a] + val[n.b]; break;
-        case KSub:  val[i] = val[n.a] - val[n.b]; break;
-        case KMul:  val[i] = val[n.a] * val[n.b]; break;
-        case KDiv:  val[i] = val[n.a] / val[n.b]; break;
-        case KPow:  val[i] = std::pow(val[n.a], val[n.b]); break;
-        case KNeg:  val[i] = -val[n.a]; break;
-        case KSin:  val[i] = std::sin(val[n.a]); break;
-        case KExp:  val[i] = std::exp(val[n.a]); break;
-        case KLog:  val[i] = std::log(val[n.a]); break;
-        case KSqrt: val[i] = std::sqrt(val[n.a]); break;
-        case KTanh: val[i] = std::tanh(val[n.a]); break;
-        case KCos:  val[i] = std::cos(val[n.a]); break;
-      }
+      const Node& n = nodes[i];
+      if (n.kind == KSinCos) { val[i] = sin(val[n.a]); val[i + 1] = cos(val[n.a]); ++i; continue; }
+      val[i] = node_value(n, val, inputs);
     }
-    return val[output_id];
   }
 
-  std::vector<double> backward(const std::vector<double>& inputs) const {
-    const int N = (int)nodes.size();
-    std::vector<double> val(N), bar(N, 0.0);
-    for (int i = 0; i < N; ++i) {
-      const auto& n = nodes[i];
-      switch (n.kind) {
-        case KVar:  val[i] = inputs[n.var_index]; break;
-        case KConst:val[i] = n.c; break;
-        case KAdd:  val[i] = val[n.a] + val[n.b]; break;
-        case KSub:  val[i] = val[n.a] - val[n.b]; break;
-        case KMul:  val[i] = val[n.a] * val[n.b]; break;
-        case KDiv:  val[i] = val[n.a] / val[n.b]; break;
-        case KNeg:  val[i] = -val[n.a]; break;
-        case KSin:  val[i] = std::sin(val[n.a]); break;
-        case KExp:  val[i] = std::exp(val[n.a]); break;
-        case KLog:  val[i] = std::log(val[n.a]); break;
-        case KSqrt: val[i] = std::sqrt(val[n.a]); break;
-        case KTanh: val[i] = std::tanh(val[n.a]); break;
-        case KCos:  val[i] = std::cos(val[n.a]); break;
-      }
+  // Local partial derivatives of node n w.r.t. its operands a, b and e, given
+  // operand values in val and the node's own value self. Not defined for the
+  // n-ary kinds, whose sweeps handle them directly.
+  template <class S>
+  void local_partials(const Node& n, const S* val, const S& self, S& da, S& db, S& de) const {
+    using std::pow; using std::sin; using std::cos; using std::log;
+    da = S(0.0); db = S(0.0); de = S(0.0);
+    switch (n.kind) {
+      case KVar:  case KConst: break;
+      case KAdd:  da = S(1.0); db = S(1.0); break;
+      case KSub:  da = S(1.0); db = S(-1.0); break;
+      case KMul:  da = val[n.b]; db = val[n.a]; break;
+      case KDiv:  da = S(1.0) / val[n.b]; db = -val[n.a] / (val[n.b] * val[n.b]); break;
+      case KPow:
+        da = val[n.b] * pow(val[n.a], val[n.b] - 1.0);
+        if (val[n.a] > 0.0) db = self * log(val[n.a]);
+        break;
+      case KNeg:  da = S(-1.0); break;
+      case KSin:  da = cos(val[n.a]); break;
+      case KExp:  da = self; break;
+      case KLog:  da = S(1.0) / val[n.a]; break;
+      case KSqrt: da = 0.5 / self; break;
+      case KTanh: da = 1.0 - self * self; break;
+      case KCos:  da = -sin(val[n.a]); break;
+      case KRecip:da = -(self * self); break;
+      case KRsqrt:da = -0.5 * (self * self * self); break;
+      case KFma:  da = val[n.b]; db = val[n.a]; de = S(1.0); break;
+      case KFms:  da = val[n.b]; db = val[n.a]; de = S(-1.0); break;
+      case KSquare: da = 2.0 * val[n.a]; break;
+      case KSinCos: da = cos(val[n.a]); break;
+      case KCosPair:da = -sin(val[n.a]); break;
+      case KSum:  case KProd: break;
     }
-    bar[output_id] = 1.0;
-    for (int i = N - 1; i >= 0; --i) {
+  }
+
+  // Calls f(operand) for each operand of n
+  template <class F>
+  void for_each_operand(const Node& n, F&& f) const {
+    if (is_nary(n.kind)) { for (int k = 0; k < n.b; ++k) f(args[n.a + k]); return; }
+    if (n.a >= 0) f(n.a);
+    if (n.b >= 0) f(n.b);
+    if (n.e >= 0) f(n.e);
+  }
+
+  std::size_t num_outputs() const { return outputs.empty() ? 1 : outputs.size(); }
+  int output(std::size_t k) const { return outputs.empty() ? output_id : outputs[k]; }
+  // Number of inputs: arity when a backend recorded the tape, else max
+  // var_index + 1 over the nodes, for tapes whose nodes were pushed directly
+  std::size_t input_count() const {
+    if (arity) return arity;
+    std::size_t n = 0;
+    for (const auto& nd : nodes) if (nd.kind == KVar) n = std::max(n, nd.var_index + 1);
+    return n;
+  }
+
+  // Adjoint sweep: accumulates bar[] of operands from bar[] of results given
+  // the primal values of a completed forward_sweep. bar must be seeded by the
+  // caller; nodes after `last` (default: all) are assumed to carry no adjoint.
+  // scratch (max_args entries) holds KProd prefix products; without it a
+  // temporary is allocated when the tape has products. Adjoints (S) may be
+  // wider than values (V).
+  template <class V, class S>
+  void reverse_sweep(const V* val, S* bar, int last = -1, S* scratch = nullptr) const {
+    if (last < 0) last = (int)nodes.size() - 1;
+    std::vector<S> tmp;
+    if (!scratch && max_args) { tmp.resize(max_args); scratch = tmp.data(); }
+    reverse_range(last, 0, val, bar, scratch);
+  }
+
+  // Adjoint step of node i alone: pushes bar[i] to its operands
+  template <class V, class S>
+  void reverse_node(int i, const V* val, S* bar, S* scratch) const { reverse_range(i, i, val, bar, scratch); }
+
+  // Adjoint steps of nodes last down to first (the switch stays inside the loop)
+  template <class V, class S>
+  void reverse_range(int last, int first, const V* val, S* bar, S* scratch) const {
+    using std::pow; using std::sin; using std::cos; using std::exp;
+    using std::log; using std::sqrt; using std::tanh;
+    for (int i = last; i >= first; --i) {
       const auto& n = nodes[i];
       switch (n.kind) {
         case KVar:   break;
@@ -89,74 +242,620 @@ struct Tape {
           bar[n.a] += bar[i] / val[n.b];
           bar[n.b] -= bar[i] * val[n.a] / (val[n.b] * val[n.b]);
           break;
-        case KPow: {
-          double f = std::pow(val[n.a], val[n.b]);
-          bar[n.a] += bar[i] * f * (val[n.b] / val[n.a]);
-          bar[n.b] += bar[i] * f * std::log(val[n.a]);
-          break; }
+        case KPow:
+          bar[n.a] += bar[i] * (val[n.b] * pow(val[n.a], val[n.b] - 1.0));
+          bar[n.b] += bar[i] * val[i] * log(val[n.a]);
+          break;
         case KNeg:
           bar[n.a] -= bar[i];
           break;
         case KSin:
-          bar[n.a] += bar[i] * std::cos(val[n.a]);
+          bar[n.a] += bar[i] * cos(val[n.a]);
           break;
         case KExp:
-          bar[n.a] += bar[i] * std::exp(val[n.a]);
+          bar[n.a] += bar[i] * exp(val[n.a]);
           break;
         case KLog:
           bar[n.a] += bar[i] / val[n.a];
           break;
         case KSqrt:
-          bar[n.a] += bar[i] * (0.5 / std::sqrt(val[n.a]));
+          bar[n.a] += bar[i] * (0.5 / sqrt(val[n.a]));
           break;
         case KTanh: {
-          double t = std::tanh(val[n.a]);
+          S t = tanh(val[n.a]);
           bar[n.a] += bar[i] * (1.0 - t * t);
           break; }
         case KCos:
-          bar[n.a] -= bar[i] * std::sin(val[n.a]);
+          bar[n.a] -= bar[i] * sin(val[n.a]);
+          break;
+        case KRecip:
+          bar[n.a] -= bar[i] * (val[i] * val[i]);
+          break;
+        case KRsqrt:
+          bar[n.a] -= bar[i] * (0.5 * (val[i] * val[i] * val[i]));
+          break;
+        case KFma:
+          bar[n.a] += bar[i] * val[n.b];
+          bar[n.b] += bar[i] * val[n.a];
+          bar[n.e] += bar[i];
+          break;
+        case KFms:
+          bar[n.a] += bar[i] * val[n.b];
+          bar[n.b] += bar[i] * val[n.a];
+          bar[n.e] -= bar[i];
+          break;
+        case KSquare:
+          bar[n.a] += bar[i] * (2.0 * val[n.a]);
+          break;
+        case KSinCos: // the pair's values are each other's derivatives
+          bar[n.a] += bar[i] * val[i + 1];
+          break;
+        case KCosPair:
+          bar[n.a] -= bar[i] * val[i - 1];
           break;
+        case KSum: {
+          const int* p = &args[n.a];
+          for (int k = 0; k < n.b; ++k) bar[p[k]] += bar[i];
+          break; }
+        case KProd: {
+          // d/dx_k = (x_0 ... x_{k-1}) * (x_{k+1} ... x_{m-1}); no division, so zeros are exact
+          const int* p = &args[n.a];
+          scratch[0] = S(1.0);
+          for (int k = 1; k < n.b; ++k) scratch[k] = scratch[k - 1] * val[p[k - 1]];
+          S suffix(1.0);
+          for (int k = n.b - 1; k >= 0; --k) {
+            bar[p[k]] += bar[i] * (scratch[k] * suffix);
+            suffix = suffix * val[p[k]];
+          }
+          break; }
       }
     }
-    std::size_t arity = 0;
-    for (auto& n : nodes) if (n.kind == KVar) arity = std::max(arity, n.var_index+1);
-    std::vector<double> grad(arity, 0.0);
-    for (int i = 0; i < N; ++i)
+  }
+
+  // Sum adjoints of Var nodes (up to `last`, default all) into grad[0..arity)
+  template <class S>
+  void gather_grad(const S* bar, S* grad, int last = -1) const {
+    if (last < 0) last = (int)nodes.size() - 1;
+    std::fill(grad, grad + input_count(), S(0.0));
+    for (int i = 0; i <= last; ++i)
       if (nodes[i].kind == KVar) grad[nodes[i].var_index] += bar[i];
+  }
+
+  Real forward(const Real* inputs, Workspace& ws) const {
+    assert(ws.val.size() == nodes.size());
+    forward_sweep(inputs, ws.val.data());
+    return ws.val[output_id];
+  }
+
+  // Writes d(output)/d(inputs) into grad[0..arity) and returns the primal value
+  Real backward(const Real* inputs, Workspace& ws, Acc* grad) const {
+    assert(ws.val.size() == nodes.size() && ws.bar.size() == nodes.size());
+    forward_sweep(inputs, ws.val.data());
+    std::fill(ws.bar.begin(), ws.bar.end(), Acc(0.0));
+    ws.bar[output_id] = Acc(1.0);
+    reverse_sweep(ws.val.data(), ws.bar.data(), -1, ws.scratch.data());
+    gather_grad(ws.bar.data(), grad);
+    return ws.val[output_id];
+  }
+
+  // Value of node n and its local partials in one dispatch (see local_partials):
+  // p[0..2] against operands a, b, e, or npart[slot] per operand slot of an
+  // n-ary node. KSinCos/KCosPair are handled on their own (as KSin/KCos).
+  Real value_partials(const Node& n, const Real* val, const Real* inputs, Acc* p, Acc* npart) const {
+    const Real x = n.a >= 0 && !is_nary(n.kind) ? val[n.a] : Real(0.0);
+    switch (n.kind) {
+      case KVar:   return inputs[n.var_index];
+      case KConst: return n.c;
+      case KAdd:   p[0] = 1.0; p[1] = 1.0; return x + val[n.b];
+      case KSub:   p[0] = 1.0; p[1] = -1.0; return x - val[n.b];
+      case KMul:   p[0] = val[n.b]; p[1] = x; return x * val[n.b];
+      case KDiv: {
+        const Real y = x / val[n.b];
+        p[0] = Acc(1.0) / val[n.b]; p[1] = -y * p[0];
+        return y; }
+      case KPow: {
+        const Real e = val[n.b], y = std::pow(x, e);
+        p[0] = e * std::pow(x, e - Real(1.0));
+        p[1] = x > 0.0 ? y * std::log(x) : 0.0;
+        return y; }
+      case KNeg:   p[0] = -1.0; return -x;
+      case KSin: case KSinCos:  p[0] = std::cos(x); return std::sin(x);
+      case KCos: case KCosPair: p[0] = -std::sin(x); return std::cos(x);
+      case KExp:   { const Real y = std::exp(x); p[0] = y; return y; }
+      case KLog:   p[0] = 1.0 / x; return std::log(x);
+      case KSqrt:  { const Real y = std::sqrt(x); p[0] = 0.5 / y; return y; }
+      case KTanh:  { const Real y = std::tanh(x); p[0] = 1.0 - y * y; return y; }
+      case KRecip: { const Real y = Real(1.0) / x; p[0] = -(y * y); return y; }
+      case KRsqrt: { const Real y = Real(1.0) / std::sqrt(x); p[0] = -0.5 * (y * y * y); return y; }
+      case KFma:   p[0] = val[n.b]; p[1] = x; p[2] = 1.0; return fmadd(x, val[n.b], val[n.e]);
+      case KFms:   p[0] = val[n.b]; p[1] = x; p[2] = -1.0; return fmadd(x, val[n.b], -val[n.e]);
+      case KSquare:p[0] = 2.0 * x; return x * x;
+      case KSum: {
+        const int* q = &args[n.a];
+        Acc y = val[q[0]];
+        for (int k = 1; k < n.b; ++k) y += val[q[k]];
+        std::fill(npart + n.a, npart + n.a + n.b, Acc(1.0));
+        return Real(y); }
+      case KProd: { // product of the other factors, as in reverse_sweep
+        const int* q = &args[n.a];
+        Acc prefix = 1.0;
+        for (int k = 0; k < n.b; ++k) { npart[n.a + k] = prefix; prefix *= val[q[k]]; }
+        Acc suffix = 1.0;
+        for (int k = n.b - 1; k >= 0; --k) { npart[n.a + k] *= suffix; suffix *= val[q[k]]; }
+        return Real(prefix); }
+    }
+    return Real(0.0);
+  }
+
+  // Same result as backward, in one forward sweep (up to output_id) that also
+  // stores each node's local partials: partial[3i .. 3i+2] against operands
+  // a, b, e, and for n-ary nodes partial[3N + slot] per operand slot in args.
+  // The reverse sweep is then a multiply-accumulate per operand with no
+  // dispatch on kind and no transcendental calls. Unlike backward, the
+  // exponent partial of a Pow with a non-positive base is 0 (as in jvp).
+  Real value_and_grad(const Real* inputs, Workspace& ws, Acc* grad) const {
+    assert(ws.val.size() == nodes.size() && ws.bar.size() == nodes.size());
+    const std::size_t N = nodes.size();
+    if (ws.partial.size() < 3 * N + args.size()) ws.partial.resize(3 * N + args.size());
+    Real* val = ws.val.data();
+    Acc* bar = ws.bar.data();
+    Acc* part = ws.partial.data();
+    Acc* npart = part + 3 * N;
+    const int last = output_id;
+    for (int i = 0; i <= last; ++i) {
+      const Node& n = nodes[i];
+      if (n.kind == KSinCos) { // the pair's values are each other's derivatives
+        val[i] = std::sin(val[n.a]); val[i + 1] = std::cos(val[n.a]);
+        part[3 * i] = val[i + 1]; part[3 * i + 3] = -val[i];
+        ++i;
+        continue;
+      }
+      val[i] = value_partials(n, val, inputs, part + 3 * i, npart);
+    }
+    std::fill(bar, bar + last + 1, Acc(0.0));
+    bar[last] = Acc(1.0);
+    for (int i = last; i >= 0; --i) {
+      const Node& n = nodes[i];
+      const Acc g = bar[i];
+      if (is_nary(n.kind)) {
+        for (int k = 0; k < n.b; ++k) bar[args[n.a + k]] += g * npart[n.a + k];
+        continue;
+      }
+      const Acc* p = part + 3 * i;
+      if (n.a >= 0) bar[n.a] += g * p[0];
+      if (n.b >= 0) bar[n.b] += g * p[1];
+      if (n.e >= 0) bar[n.e] += g * p[2];
+    }
+    gather_grad(bar, grad, last);
+    return val[last];
+  }
+
+  // All outputs: out[k] = value of output(k)
+  void forward_all(const Real* inputs, Workspace& ws, Real* out) const {
+    assert(ws.val.size() == nodes.size());
+    forward_sweep(inputs, ws.val.data());
+    for (std::size_t k = 0; k < num_outputs(); ++k) out[k] = ws.val[output(k)];
+  }
+
+  // Vector-Jacobian product: grad = seed^T J for an adjoint seed over the
+  // outputs (num_outputs entries). Optionally also writes the output values.
+  void vjp(const Real* inputs, const Acc* seed, Workspace& ws, Acc* grad, Real* out = nullptr) const {
+    assert(ws.val.size() == nodes.size() && ws.bar.size() == nodes.size());
+    forward_sweep(inputs, ws.val.data());
+    std::fill(ws.bar.begin(), ws.bar.end(), Acc(0.0));
+    int last = 0;
+    for (std::size_t k = 0; k < num_outputs(); ++k) {
+      ws.bar[output(k)] += seed[k];
+      last = std::max(last, output(k));
+      if (out) out[k] = ws.val[output(k)];
+    }
+    reverse_sweep(ws.val.data(), ws.bar.data(), last, ws.scratch.data());
+    gather_grad(ws.bar.data(), grad);
+  }
+
+  // Dense Jacobian, row-major num_outputs x arity. One forward sweep is shared
+  // by all rows; each row is a reverse sweep seeded with a unit adjoint that
+  // starts at its output node.
+  void jacobian(const Real* inputs, Workspace& ws, Acc* J) const {
+    assert(ws.val.size() == nodes.size() && ws.bar.size() == nodes.size());
+    forward_sweep(inputs, ws.val.data());
+    const std::size_t A = input_count();
+    for (std::size_t k = 0; k < num_outputs(); ++k) {
+      const int o = output(k);
+      std::fill(ws.bar.begin(), ws.bar.begin() + o + 1, Acc(0.0));
+      ws.bar[o] = Acc(1.0);
+      reverse_sweep(ws.val.data(), ws.bar.data(), o, ws.scratch.data());
+      gather_grad(ws.bar.data(), J + k * A, o);
+    }
+  }
+
+  // Forward mode: carries primal and tangent through one sweep. tangent is a
+  // direction in input space (arity entries); out_dot[k] receives the
+  // directional derivative of output(k), out[k] (optional) its value.
+  // Returns the primary output value.
+  Real jvp(const Real* inputs, const Real* tangent, Workspace& ws, Real* out_dot, Real* out = nullptr) const {
+    assert(ws.val.size() == nodes.size());
+    if (ws.dot.size() < nodes.size()) ws.dot.resize(nodes.size());
+    Real* val = ws.val.data();
+    Real* dot = ws.dot.data();
+    for (int i = 0; i < (int)nodes.size(); ++i) {
+      const auto& n = nodes[i];
+      val[i] = node_value(n, val, inputs);
+      if (n.kind == KVar) { dot[i] = tangent[n.var_index]; continue; }
+      if (is_nary(n.kind)) { dot[i] = nary_tangent(n, val, dot); continue; }
+      Real da, db, de;
+      local_partials(n, val, val[i], da, db, de);
+      Real d = 0.0;
+      if (n.a >= 0) d += da * dot[n.a];
+      if (n.b >= 0) d += db * dot[n.b];
+      if (n.e >= 0) d += de * dot[n.e];
+      dot[i] = d;
+    }
+    for (std::size_t k = 0; k < num_outputs(); ++k) {
+      out_dot[k] = dot[output(k)];
+      if (out) out[k] = val[output(k)];
+    }
+    return val[output(0)];
+  }
+
+  // Batched forward mode: pushes K tangent directions through one sweep as a
+  // dense block. tangents is arity x K row-major (tangents[j*K + k] is input j
+  // of direction k); out_dot is num_outputs x K row-major.
+  void jvp_batch(const Real* inputs, const Real* tangents, std::size_t K, Workspace& ws, Real* out_dot) const {
+    assert(ws.val.size() == nodes.size());
+    if (ws.dot.size() < nodes.size() * K) ws.dot.resize(nodes.size() * K);
+    Real* val = ws.val.data();
+    Real* dot = ws.dot.data();
+    for (int i = 0; i < (int)nodes.size(); ++i) {
+      const auto& n = nodes[i];
+      val[i] = node_value(n, val, inputs);
+      Real* di = dot + (std::size_t)i * K;
+      if (n.kind == KVar) { std::copy(tangents + n.var_index * K, tangents + (n.var_index + 1) * K, di); continue; }
+      if (is_nary(n.kind)) {
+        // Running product rule: (p, dp) <- (p * x, dp * x + p * dx)
+        const int* p = &args[n.a];
+        const Real* d0 = dot + (std::size_t)p[0] * K;
+        std::copy(d0, d0 + K, di);
+        Real prod = val[p[0]];
+        for (int j = 1; j < n.b; ++j) {
+          const Real* dx = dot + (std::size_t)p[j] * K;
+          const Real x = val[p[j]];
+          if (n.kind == KSum) for (std::size_t k = 0; k < K; ++k) di[k] += dx[k];
+          else                for (std::size_t k = 0; k < K; ++k) di[k] = di[k] * x + prod * dx[k];
+          prod *= x;
+        }
+        continue;
+      }
+      Real da, db, de;
+      local_partials(n, val, val[i], da, db, de);
+      if (n.a < 0) { std::fill(di, di + K, 0.0); continue; }
+      const Real* dx = dot + (std::size_t)n.a * K;
+      if (n.b < 0) { for (std::size_t k = 0; k < K; ++k) di[k] = da * dx[k]; continue; }
+      const Real* dz = dot + (std::size_t)n.b * K;
+      for (std::size_t k = 0; k < K; ++k) di[k] = da * dx[k] + db * dz[k];
+      if (n.e >= 0) {
+        const Real* dw = dot + (std::size_t)n.e * K;
+        for (std::size_t k = 0; k < K; ++k) di[k] += de * dw[k];
+      }
+    }
+    for (std::size_t o = 0; o < num_outputs(); ++o) {
+      const Real* d = dot + (std::size_t)output(o) * K;
+      std::copy(d, d + K, out_dot + o * K);
+    }
+  }
+
+  // Tangent of a KSum/KProd node; products use the running product rule, which
+  // needs no division
+  Real nary_tangent(const Node& n, const Real* val, const Real* dot) const {
+    const int* p = &args[n.a];
+    Real d = dot[p[0]];
+    if (n.kind == KSum) { for (int k = 1; k < n.b; ++k) d += dot[p[k]]; return d; }
+    Real prod = val[p[0]];
+    for (int k = 1; k < n.b; ++k) { d = d * val[p[k]] + prod * dot[p[k]]; prod *= val[p[k]]; }
+    return d;
+  }
+
+  std::pair<Real, std::vector<Acc>> value_and_grad(const std::vector<Real>& inputs) const {
+    Workspace ws(*this);
+    std::vector<Acc> grad(input_count(), Acc(0.0));
+    const Real v = value_and_grad(inputs.data(), ws, grad.data());
+    return { v, std::move(grad) };
+  }
+
+  std::pair<Real, Real> jvp(const std::vector<Real>& inputs, const std::vector<Real>& tangent) const {
+    Workspace ws(*this);
+    std::vector<Real> out_dot(num_outputs());
+    Real v = jvp(inputs.data(), tangent.data(), ws, out_dot.data());
+    return { v, out_dot[0] };
+  }
+
+  // Dense Jacobian (num_outputs x arity, row-major) in one forward sweep with
+  // the identity as the tangent block
+  std::vector<Real> jacobian_forward(const std::vector<Real>& inputs) const {
+    Workspace ws(*this);
+    const std::size_t A = input_count();
+    std::vector<Real> seed(A * A, 0.0);
+    for (std::size_t j = 0; j < A; ++j) seed[j * A + j] = 1.0;
+    std::vector<Real> J(num_outputs() * A, 0.0);
+    jvp_batch(inputs.data(), seed.data(), A, ws, J.data());
+    return J;
+  }
+
+  // Hessian-vector product of the primary output, forward-over-reverse: the
+  // primal and adjoint sweeps run on Dual<Real> seeded with direction v, so
+  // the tangent of the gradient is H v. Optionally writes the gradient too.
+  // Returns the primal.
+  Real hvp(const Real* inputs, const Real* v, Workspace& ws, Real* Hv, Real* grad = nullptr) const {
+    const std::size_t A = input_count();
+    if (ws.dval.size() < nodes.size()) { ws.dval.resize(nodes.size()); ws.dbar.resize(nodes.size()); }
+    if (ws.dio.size() < 2 * A) ws.dio.resize(2 * A);
+    if (ws.dscratch.size() < max_args) ws.dscratch.resize(max_args);
+    Dual<Real>* din = ws.dio.data();
+    Dual<Real>* dgrad = din + A;
+    for (std::size_t j = 0; j < A; ++j) din[j] = Dual<Real>(inputs[j], v[j]);
+    forward_sweep(din, ws.dval.data());
+    std::fill(ws.dbar.begin(), ws.dbar.end(), Dual<Real>());
+    ws.dbar[output_id] = Dual<Real>(1.0);
+    reverse_sweep(ws.dval.data(), ws.dbar.data(), -1, ws.dscratch.data());
+    gather_grad(ws.dbar.data(), dgrad);
+    for (std::size_t j = 0; j < A; ++j) {
+      Hv[j] = dgrad[j].d;
+      if (grad) grad[j] = dgrad[j].v;
+    }
+    return ws.dval[output_id].v;
+  }
+
+  // Dense Hessian (arity x arity, row-major) from one hvp per unit direction;
+  // meant for small arity
+  void hessian(const Real* inputs, Workspace& ws, Real* H) const {
+    const std::size_t A = input_count();
+    if (ws.dot.size() < A) ws.dot.resize(A);
+    Real* e = ws.dot.data();
+    std::fill(e, e + A, 0.0);
+    for (std::size_t j = 0; j < A; ++j) {
+      e[j] = 1.0;
+      hvp(inputs, e, ws, H + j * A);
+      e[j] = 0.0;
+    }
+  }
+
+  std::vector<Real> hvp(const std::vector<Real>& inputs, const std::vector<Real>& v) const {
+    Workspace ws(*this);
+    std::vector<Real> Hv(input_count());
+    hvp(inputs.data(), v.data(), ws, Hv.data());
+    return Hv;
+  }
+
+  std::vector<Real> hessian(const std::vector<Real>& inputs) const {
+    Workspace ws(*this);
+    const std::size_t A = input_count();
+    std::vector<Real> H(A * A);
+    hessian(inputs.data(), ws, H.data());
+    return H;
+  }
+
+  std::vector<Real> forward_all(const std::vector<Real>& inputs) const {
+    Workspace ws(*this);
+    std::vector<Real> out(num_outputs());
+    forward_all(inputs.data(), ws, out.data());
+    return out;
+  }
+
+  std::vector<Acc> vjp(const std::vector<Real>& inputs, const std::vector<Acc>& seed) const {
+    assert(seed.size() == num_outputs());
+    Workspace ws(*this);
+    std::vector<Acc> grad(input_count(), Acc(0.0));
+    vjp(inputs.data(), seed.data(), ws, grad.data());
     return grad;
   }
+
+  std::vector<Acc> jacobian(const std::vector<Real>& inputs) const {
+    Workspace ws(*this);
+    std::vector<Acc> J(num_outputs() * input_count(), Acc(0.0));
+    jacobian(inputs.data(), ws, J.data());
+    return J;
+  }
+
+  Real forward(const std::vector<Real>& inputs) const {
+    std::vector<Real> val(nodes.size());
+    forward_sweep(inputs.data(), val.data());
+    return val[output_id];
+  }
+
+  std::vector<Acc> backward(const std::vector<Real>& inputs) const {
+    Workspace ws(*this);
+    std::vector<Acc> grad(input_count(), Acc(0.0));
+    backward(inputs.data(), ws, grad.data());
+    return grad;
+  }
+
+  // Batched forward over n points in structure-of-arrays layout: cols[k][r] is
+  // input k of row r. Rows are processed in blocks of batch_block so that each
+  // instruction is dispatched once per block and runs a vectorizable kernel.
+  static constexpr std::size_t batch_block = 64;
+
+  void forward_batch(const Real* const* cols, std::size_t n, Real* out, Workspace& ws) const {
+    if (ws.block.size() < nodes.size() * batch_block) ws.block.resize(nodes.size() * batch_block);
+    for (std::size_t r0 = 0; r0 < n; r0 += batch_block) {
+      const std::size_t m = std::min(batch_block, n - r0);
+      forward_block(cols, r0, m, ws.block.data());
+      const Real* o = ws.block.data() + (std::size_t)output_id * batch_block;
+      std::copy(o, o + m, out + r0);
+    }
+  }
+
+  void forward_batch(const Real* const* cols, std::size_t n, Real* out) const {
+    Workspace ws;
+    forward_batch(cols, n, out, ws);
+  }
+
+  std::vector<Real> forward_batch(const std::vector<std::vector<Real>>& cols) const {
+    std::vector<const Real*> ptrs; ptrs.reserve(cols.size());
+    for (auto& c : cols) ptrs.push_back(c.data());
+    const std::size_t n = cols.empty() ? 0 : cols[0].size();
+    std::vector<Real> out(n);
+    forward_batch(ptrs.data(), n, out.data());
+    return out;
+  }
+
+  // One block of m <= batch_block rows; val holds batch_block lanes per node
+  void forward_block(const Real* const* cols, std::size_t r0, std::size_t m, Real* val) const {
+    constexpr std::size_t B = batch_block;
+    for (int i = 0; i < (int)nodes.size(); ++i) {
+      const auto& n = nodes[i];
+      Real* y = val + (std::size_t)i * B;
+      if (is_nary(n.kind)) {
+        const int* p = &args[n.a];
+        const Real* x0 = val + (std::size_t)p[0] * B;
+        if constexpr (std::is_same<Acc, Real>::value) {
+          std::copy(x0, x0 + m, y);
+          for (int k = 1; k < n.b; ++k) {
+            const Real* xk = val + (std::size_t)p[k] * B;
+            if (n.kind == KSum) for (std::size_t r = 0; r < m; ++r) y[r] += xk[r];
+            else                for (std::size_t r = 0; r < m; ++r) y[r] *= xk[r];
+          }
+        } else { // running sum/product in Acc lanes
+          Acc acc[B];
+          std::copy(x0, x0 + m, acc);
+          for (int k = 1; k < n.b; ++k) {
+            const Real* xk = val + (std::size_t)p[k] * B;
+            if (n.kind == KSum) for (std::size_t r = 0; r < m; ++r) acc[r] += xk[r];
+            else                for (std::size_t r = 0; r < m; ++r) acc[r] *= xk[r];
+          }
+          std::copy(acc, acc + m, y);
+        }
+        continue;
+      }
+      const Real* x = n.a >= 0 ? val + (std::size_t)n.a * B : nullptr;
+      const Real* z = n.b >= 0 ? val + (std::size_t)n.b * B : nullptr;
+      const Real* w = n.e >= 0 ? val + (std::size_t)n.e * B : nullptr;
+      switch (n.kind) {
+        case KVar:  std::copy(cols[n.var_index] + r0, cols[n.var_index] + r0 + m, y); break;
+        case KConst:std::fill(y, y + m, n.c); break;
+        case KAdd:  for (std::size_t r = 0; r < m; ++r) y[r] = x[r] + z[r]; break;
+        case KSub:  for (std::size_t r = 0; r < m; ++r) y[r] = x[r] - z[r]; break;
+        case KMul:  for (std::size_t r = 0; r < m; ++r) y[r] = x[r] * z[r]; break;
+        case KDiv:  for (std::size_t r = 0; r < m; ++r) y[r] = x[r] / z[r]; break;
+        case KNeg:  for (std::size_t r = 0; r < m; ++r) y[r] = -x[r]; break;
+        case KPow:  case KSin: case KExp: case KLog: case KSqrt: case KTanh: case KCos:
+        case KSinCos: case KCosPair:
+          math_block(n.kind, x, z, y, m); break;
+        case KRecip:for (std::size_t r = 0; r < m; ++r) y[r] = Real(1.0) / x[r]; break;
+        case KRsqrt:for (std::size_t r = 0; r < m; ++r) y[r] = Real(1.0) / std::sqrt(x[r]); break;
+        case KFma:  for (std::size_t r = 0; r < m; ++r) y[r] = fmadd(x[r], z[r], w[r]); break;
+        case KFms:  for (std::size_t r = 0; r < m; ++r) y[r] = fmadd(x[r], z[r], -w[r]); break;
+        case KSquare: for (std::size_t r = 0; r < m; ++r) y[r] = x[r] * x[r]; break;
+        case KSum:  case KProd: break;
+      }
+    }
+  }
+
+  // Transcendental kind k over m lanes (z is the exponent of KPow). The vmath
+  // kernels are double precision: narrower lanes are widened through a double
+  // buffer, wider ones fall back to std:: per lane.
+  static void math_block(Kind k, const Real* x, const Real* z, Real* y, std::size_t m) {
+    if constexpr (std::is_same<Real, double>::value) {
+      switch (k) {
+        case KPow:  vmath::vpow(x, z, y, m); break;
+        case KSin:  case KSinCos: vmath::vsin(x, y, m); break;
+        case KCos:  case KCosPair:vmath::vcos(x, y, m); break;
+        case KExp:  vmath::vexp(x, y, m); break;
+        case KLog:  vmath::vlog(x, y, m); break;
+        case KSqrt: vmath::vsqrt(x, y, m); break;
+        case KTanh: vmath::vtanh(x, y, m); break;
+        default: break;
+      }
+    } else if constexpr (sizeof(Real) <= sizeof(double)) {
+      double dx[batch_block], dz[batch_block], dy[batch_block];
+      std::copy(x, x + m, dx);
+      if (z) std::copy(z, z + m, dz);
+      BasicTape<double>::math_block(k, dx, dz, dy, m);
+      std::copy(dy, dy + m, y);
+    } else {
+      using std::pow; using std::sin; using std::cos; using std::exp;
+      using std::log; using std::sqrt; using std::tanh;
+      for (std::size_t r = 0; r < m; ++r) {
+        switch (k) {
+          case KPow:  y[r] = pow(x[r], z[r]); break;
+          case KSin:  case KSinCos: y[r] = sin(x[r]); break;
+          case KCos:  case KCosPair:y[r] = cos(x[r]); break;
+          case KExp:  y[r] = exp(x[r]); break;
+          case KLog:  y[r] = log(x[r]); break;
+          case KSqrt: y[r] = sqrt(x[r]); break;
+          case KTanh: y[r] = tanh(x[r]); break;
+          default: break;
+        }
+      }
+    }
+  }
+
 };
 
-struct TapeBackend {
+using Tape = BasicTape<double>;
+
+// Converts a tape to another scalar type (constants are cast); lets a tape
+// built or rewritten in double (fuse_tape, ...) run in float or long double
+template <class R2, class A2 = R2, class R, class A>
+BasicTape<R2, A2> tape_cast(const BasicTape<R, A>& t) {
+  BasicTape<R2, A2> r;
+  r.nodes.resize(t.nodes.size());
+  for (std::size_t i = 0; i < t.nodes.size(); ++i) {
+    const auto& n = t.nodes[i];
+    auto& m = r.nodes[i];
+    m.kind = n.kind; m.a = n.a; m.b = n.b; m.e = n.e;
+    m.c = static_cast<R2>(n.c); m.var_index = n.var_index;
+  }
+  r.output_id = t.output_id;
+  r.outputs = t.outputs;
+  r.arity = t.input_count();
+  r.args = t.args;
+  r.max_args = t.max_args;
+  return r;
+}
+
+// Records compiled expressions into a BasicTape<Real, Acc>; TapeBackend
+// builds the double Tape
+template <class Real, class Acc = Real>
+struct BasicTapeBackend {
   using result_type = int;
-  Tape tape;
+  using tape_type = BasicTape<Real, Acc>;
+  tape_type tape;
 
-  explicit TapeBackend(std::size_t /*arity*/) { tape.nodes.reserve(64); }
+  explicit BasicTapeBackend(std::size_t /*arity*/) { tape.nodes.reserve(64); }
+
+  // Register a compiled node as an output; the first one also becomes output_id
+  void add_output(result_type id) {
+    if (tape.outputs.empty()) tape.output_id = id;
+    tape.outputs.push_back(id);
+  }
 
   template <class T>
   result_type emitVar(std::size_t idx) {
-    Tape::Node n; n.kind = Tape::KVar; n.var_index = idx;
+    typename tape_type::Node n; n.kind = TapeKinds::KVar; n.var_index = idx;
+    tape.arity = std::max(tape.arity, idx + 1);
     tape.nodes.push_back(n);
     return (int)tape.nodes.size() - 1;
   }
 
   template <class T>
   result_type emitConst(Const<T> c) {
-    Tape::Node n; n.kind = Tape::KConst; n.c = static_cast<double>(c.value);
+    typename tape_type::Node n; n.kind = TapeKinds::KConst; n.c = static_cast<Real>(c.value);
     tape.nodes.push_back(n);
     return (int)tape.nodes.size() - 1;
   }
 
   template <class Op>
   result_type emitApply(Op, int a) {
-    Tape::Node n;
-    if constexpr (std::is_same<Op, NegOp>::value) n.kind = Tape::KNeg;
-    else if constexpr (std::is_same<Op, SinOp>::value) n.kind = Tape::KSin;
-    else if constexpr (std::is_same<Op, ExpOp>::value) n.kind = Tape::KExp;
-    else if constexpr (std::is_same<Op, LogOp>::value) n.kind = Tape::KLog;
-    else if constexpr (std::is_same<Op, SqrtOp>::value) n.kind = Tape::KSqrt;
-    else if constexpr (std::is_same<Op, TanhOp>::value) n.kind = Tape::KTanh;
-    else if constexpr (std::is_same<Op, CosOp>::value) n.kind = Tape::KCos;
+    typename tape_type::Node n;
+    if constexpr (std::is_same<Op, NegOp>::value) n.kind = TapeKinds::KNeg;
+    else if constexpr (std::is_same<Op, SinOp>::value) n.kind = TapeKinds::KSin;
+    else if constexpr (std::is_same<Op, ExpOp>::value) n.kind = TapeKinds::KExp;
+    else if constexpr (std::is_same<Op, LogOp>::value) n.kind = TapeKinds::KLog;
+    else if constexpr (std::is_same<Op, SqrtOp>::value) n.kind = TapeKinds::KSqrt;
+    else if constexpr (std::is_same<Op, TanhOp>::value) n.kind = TapeKinds::KTanh;
+    else if constexpr (std::is_same<Op, CosOp>::value) n.kind = TapeKinds::KCos;
+    else if constexpr (std::is_same<Op, RecipOp>::value) n.kind = TapeKinds::KRecip;
+    else if constexpr (std::is_same<Op, RsqrtOp>::value) n.kind = TapeKinds::KRsqrt;
     else static_assert(!std::is_same<Op,Op>::value, "Unary op not mapped to Tape");
     n.a = a;
     tape.nodes.push_back(n);
@@ -165,17 +864,36 @@ struct TapeBackend {
 
   template <class Op>
   result_type emitApply(Op, int a, int b) {
-    Tape::Node n;
-    if constexpr      (std::is_same<Op, AddOp>::value) n.kind = Tape::KAdd;
-    else if constexpr (std::is_same<Op, SubOp>::value) n.kind = Tape::KSub;
-    else if constexpr (std::is_same<Op, MulOp>::value) n.kind = Tape::KMul;
-    else if constexpr (std::is_same<Op, DivOp>::value) n.kind = Tape::KDiv;
-    else if constexpr (std::is_same<Op, PowOp>::value) n.kind = Tape::KPow;
+    typename tape_type::Node n;
+    if constexpr      (std::is_same<Op, AddOp>::value) n.kind = TapeKinds::KAdd;
+    else if constexpr (std::is_same<Op, SubOp>::value) n.kind = TapeKinds::KSub;
+    else if constexpr (std::is_same<Op, MulOp>::value) n.kind = TapeKinds::KMul;
+    else if constexpr (std::is_same<Op, DivOp>::value) n.kind = TapeKinds::KDiv;
+    else if constexpr (std::is_same<Op, PowOp>::value) n.kind = TapeKinds::KPow;
     else static_assert(!std::is_same<Op,Op>::value, "Binary op not mapped to Tape");
     n.a = a; n.b = b;
     tape.nodes.push_back(n);
     return (int)tape.nodes.size() - 1;
   }
+
+  // One n-ary reduction instruction over ids (AddOp -> KSum, MulOp -> KProd).
+  // Picked up by compile_runtime for Add/Mul nodes with more than two terms.
+  template <class Op>
+  result_type emitNary(Op, const std::vector<int>& ids) {
+    typename tape_type::Node n;
+    if constexpr      (std::is_same<Op, AddOp>::value) n.kind = TapeKinds::KSum;
+    else if constexpr (std::is_same<Op, MulOp>::value) n.kind = TapeKinds::KProd;
+    else static_assert(!std::is_same<Op,Op>::value, "N-ary op not mapped to Tape");
+    assert(!ids.empty());
+    n.a = (int)tape.args.size(); n.b = (int)ids.size();
+    tape.args.insert(tape.args.end(), ids.begin(), ids.end());
+    tape.max_args = std::max(tape.max_args, ids.size());
+    tape.nodes.push_back(n);
+    return (int)tape.nodes.size() - 1;
+  }
 };
 
+using TapeBackend = BasicTapeBackend<double>;
+using TapeWorkspace = Tape::Workspace;
+
 } // namespace et
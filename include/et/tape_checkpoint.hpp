@@ -0,0 +1,362 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "et/tape_backend.hpp"
+
+namespace et {
+
+// Binomial checkpointing (revolve) for reversing s steps with c free
+// snapshot slots, the state at the first step being available. beta(c, r) =
+// (c + r choose c) steps can be reversed with c slots when no step is
+// advanced more than r times.
+namespace revolve {
+
+// Saturates instead of overflowing; callers only compare against step counts
+inline std::uint64_t beta(std::uint64_t c, std::uint64_t r) {
+  const std::uint64_t cap = std::uint64_t(1) << 62;
+  std::uint64_t b = 1;
+  const std::uint64_t k = std::min(c, r), n = c + r;
+  for (std::uint64_t i = 1; i <= k; ++i) {
+    if (b > cap / (n - k + i)) return cap;
+    b = b * (n - k + i) / i;
+  }
+  return b;
+}
+
+// Smallest r with beta(c, r) >= s
+inline std::uint64_t repetitions(std::uint64_t s, std::uint64_t c) {
+  std::uint64_t r = 0;
+  while (beta(c, r) < s) ++r;
+  return r;
+}
+
+// Minimal number of step advances (re-evaluations besides the one recording
+// pass per step) to reverse s steps with c slots
+inline std::uint64_t advances(std::uint64_t s, std::uint64_t c) {
+  if (s <= 1) return 0;
+  if (c == 0) return s * (s - 1) / 2;
+  const std::uint64_t r = repetitions(s, c + 1);
+  return r * s - beta(c + 2, r - 1);
+}
+
+// Steps to advance before taking the next snapshot (1 <= m < s, c >= 1):
+// the left part is then reversed with c slots, the right one with c - 1
+inline std::uint64_t split(std::uint64_t s, std::uint64_t c) {
+  const std::uint64_t r = repetitions(s, c + 1);
+  const std::uint64_t m = std::min(beta(c + 1, r - 1), s - beta(c, r - 1));
+  return std::min(std::max<std::uint64_t>(m, 1), s - 1);
+}
+
+} // namespace revolve
+
+// Segmentation and snapshot count chosen for a memory budget, with the
+// memory and recomputation it costs
+struct CheckpointPlan {
+  std::size_t nodes = 0;        // nodes up to the output
+  std::size_t segments = 0;     // contiguous tape segments (revolve steps)
+  std::size_t snapshots = 0;    // checkpoint slots
+  std::size_t max_live = 0;     // values crossing a segment boundary (checkpoint size)
+  std::size_t max_segment = 0;  // largest segment with its live-in and leaf copies
+  std::size_t advances = 0;     // segment re-evaluations per gradient
+  std::size_t memory_bytes = 0; // workspace of one gradient evaluation
+  std::size_t plain_bytes = 0;  // workspace of Tape::backward, for comparison
+  bool fits = true;             // false if even the leanest plan exceeds the budget
+
+  // Primal node evaluations per gradient relative to Tape::backward (1 = no recomputation)
+  double recompute() const { return segments ? 1.0 + double(advances) / double(segments) : 0.0; }
+};
+
+// Reverse mode with bounded memory for long tapes. The nodes up to the
+// output are cut into contiguous segments; each becomes a small Tape whose
+// first slots hold its live-in values (earlier non-leaf values it or later
+// segments read), followed by copies of the Var/Const leaves it reads and
+// its own nodes with operands renumbered. A checkpoint is the live-in of a
+// segment, which is enough to re-run everything after it; adjoints of the
+// same values carry between segments in the reverse sweep. Segments are
+// reversed with binomial snapshot placement (revolve), so a workspace holds
+// the values and adjoints of one segment plus `snapshots` checkpoints
+// instead of the whole tape. The planner tries segment lengths from 8 nodes
+// to the whole tape in steps of 5/4 and keeps the one with the least
+// recomputation that fits the budget. Values match Tape::forward exactly,
+// gradients up to summation order.
+struct CheckpointedTape {
+  struct Segment {
+    Tape local;            // [live-in slots][leaf copies][own nodes]
+    std::size_t live = 0;  // live-in slots
+    std::vector<int> next; // local index of each live-in value of the next segment
+    int out = -1;          // local index of the output if it is in this segment
+  };
+
+  std::vector<Segment> segs;
+  CheckpointPlan plan;
+  std::size_t arity = 0;
+
+  // Per-evaluation buffers, sized from the plan
+  struct Workspace {
+    std::vector<double> val, bar, scratch;
+    std::vector<double> state, carry; // live-in values / adjoints at one boundary
+    std::vector<double> snaps;        // snapshots x max_live
+    std::size_t advanced = 0;         // segment re-evaluations of the last backward
+    Workspace() = default;
+    explicit Workspace(const CheckpointedTape& c) { reset(c); }
+    void reset(const CheckpointedTape& c) {
+      std::size_t len = 0, args = 0;
+      for (auto& g : c.segs) { len = std::max(len, g.local.nodes.size()); args = std::max(args, g.local.max_args); }
+      val.assign(len, 0.0);
+      bar.assign(len, 0.0);
+      scratch.assign(args, 0.0);
+      state.assign(c.plan.max_live, 0.0);
+      carry.assign(c.plan.max_live, 0.0);
+      snaps.assign(c.plan.snapshots * c.plan.max_live, 0.0);
+    }
+  };
+
+  CheckpointedTape(const Tape& t, std::size_t budget_bytes) : arity(t.input_count()) {
+    assert(t.output_id >= 0);
+    Analysis a(t);
+    plan = choose(t, a, budget_bytes);
+    build(t, a, boundaries(t, a.N, seg_length));
+    // exact sizes (the planner bounded the leaf copies)
+    plan.max_segment = 0;
+    for (auto& g : segs) plan.max_segment = std::max(plan.max_segment, g.local.nodes.size());
+    plan.memory_bytes = (2 * plan.max_segment + (2 + plan.snapshots) * plan.max_live + t.max_args) * sizeof(double);
+  }
+
+  // Value of output_id, one segment at a time
+  double forward(const double* inputs, Workspace& ws) const {
+    double v = 0.0;
+    for (std::size_t s = 0; s < segs.size(); ++s) {
+      step(s, inputs, ws.state.data(), ws);
+      if (segs[s].out >= 0) v = ws.val[segs[s].out];
+    }
+    return v;
+  }
+
+  // Writes d(output)/d(inputs) into grad[0..arity) and returns the value
+  double backward(const double* inputs, Workspace& ws, double* grad) const {
+    std::fill(grad, grad + arity, 0.0);
+    ws.advanced = 0;
+    double v = 0.0;
+    reverse(0, segs.size(), plan.snapshots, ws.state.data(), ws.snaps.data(), inputs, ws, grad, v);
+    return v;
+  }
+
+  double forward(const std::vector<double>& inputs) const {
+    Workspace ws(*this);
+    return forward(inputs.data(), ws);
+  }
+
+  std::vector<double> backward(const std::vector<double>& inputs) const {
+    Workspace ws(*this);
+    std::vector<double> grad(arity, 0.0);
+    backward(inputs.data(), ws, grad.data());
+    return grad;
+  }
+
+private:
+  std::size_t seg_length = 0;
+
+  static bool leaf(const Tape::Node& n) { return n.kind == Tape::KVar || n.kind == Tape::KConst; }
+
+  // Last reader of every node, the number of non-leaf values live across
+  // each position (live[p]: nodes j < p read at or after p), and prefix
+  // counts of leaves and of operand reads of leaves, which bound the leaf
+  // copies of a segment
+  struct Analysis {
+    int N;
+    std::vector<int> last_use;
+    std::vector<std::size_t> live, leaves, leaf_reads;
+    explicit Analysis(const Tape& t) {
+      N = t.output_id + 1 + (t.nodes[t.output_id].kind == Tape::KSinCos ? 1 : 0);
+      last_use.assign(N, -1);
+      leaves.assign(N + 1, 0);
+      leaf_reads.assign(N + 1, 0);
+      for (int i = 0; i < N; ++i) {
+        leaves[i + 1] = leaves[i] + leaf(t.nodes[i]);
+        leaf_reads[i + 1] = leaf_reads[i];
+        t.for_each_operand(t.nodes[i], [&](int j) { last_use[j] = i; leaf_reads[i + 1] += leaf(t.nodes[j]); });
+      }
+      std::vector<long long> d(N + 2, 0);
+      for (int j = 0; j < N; ++j)
+        if (!leaf(t.nodes[j]) && last_use[j] > j) { ++d[j + 1]; --d[last_use[j] + 1]; }
+      live.assign(N + 1, 0);
+      long long run = 0;
+      for (int p = 0; p <= N; ++p) { run += d[p]; live[p] = (std::size_t)run; }
+    }
+  };
+
+  // Segment starts every L nodes (plus the end), never between a KSinCos and its KCosPair
+  static std::vector<int> boundaries(const Tape& t, int N, std::size_t L) {
+    std::vector<int> b{ 0 };
+    for (std::size_t p = L; p < (std::size_t)N; p += L) {
+      int q = (int)p;
+      if (t.nodes[q].kind == Tape::KCosPair) ++q;
+      if (q < N && q > b.back()) b.push_back(q);
+    }
+    b.push_back(N);
+    return b;
+  }
+
+  CheckpointPlan choose(const Tape& t, const Analysis& a, std::size_t budget) {
+    const std::size_t N = (std::size_t)a.N;
+    CheckpointPlan best, lean;
+    std::size_t best_L = 0, lean_L = 0;
+    for (std::size_t L = 8;; L = std::min(std::max(L + 1, L * 5 / 4), N)) {
+      const std::vector<int> b = boundaries(t, a.N, L);
+      const std::size_t S = b.size() - 1;
+      CheckpointPlan p;
+      p.nodes = N;
+      p.segments = S;
+      p.plain_bytes = (2 * t.nodes.size() + t.max_args) * sizeof(double);
+      for (std::size_t s = 1; s < S; ++s) p.max_live = std::max(p.max_live, a.live[b[s]]);
+      // segment size: live-in + leaf copies (bounded by reads and by earlier leaves) + own nodes
+      for (std::size_t s = 0; s < S; ++s) {
+        const std::size_t copies = std::min(a.leaves[b[s]], a.leaf_reads[b[s + 1]] - a.leaf_reads[b[s]]);
+        p.max_segment = std::max(p.max_segment, a.live[b[s]] + copies + std::size_t(b[s + 1] - b[s]));
+      }
+      const std::size_t base = 2 * p.max_segment + 2 * p.max_live + t.max_args;
+      const std::size_t have = budget / sizeof(double);
+      const bool ok = have >= base;
+      p.snapshots = S - 1;
+      if (p.max_live && ok) p.snapshots = std::min(p.snapshots, (have - base) / p.max_live);
+      if (!ok) p.snapshots = 0;
+      p.advances = (std::size_t)revolve::advances(S, p.snapshots);
+      p.memory_bytes = (base + p.snapshots * p.max_live) * sizeof(double);
+      if (ok && (!best.segments || p.advances * best.segments < best.advances * S
+                 || (p.advances * best.segments == best.advances * S && p.memory_bytes < best.memory_bytes))) {
+        best = p; best_L = L;
+      }
+      if (!lean.segments || p.memory_bytes < lean.memory_bytes) { lean = p; lean_L = L; }
+      if (L >= N) break;
+    }
+    if (!best.segments) { best = lean; best_L = lean_L; best.fits = false; }
+    seg_length = best_L;
+    return best;
+  }
+
+  void build(const Tape& t, const Analysis& a, const std::vector<int>& b) {
+    const std::size_t S = b.size() - 1;
+    segs.assign(S, Segment{});
+    std::vector<int> live;        // live-in of the current segment, ascending
+    std::vector<int> leaf_slot(a.N, -1), stamp(a.N, -1);
+    for (std::size_t s = 0; s < S; ++s) {
+      const int lo = b[s], hi = b[s + 1];
+      Segment& g = segs[s];
+      Tape& L = g.local;
+      g.live = live.size();
+      L.arity = t.input_count();
+      L.nodes.resize(g.live);
+      for (auto& n : L.nodes) n.kind = Tape::KVar; // filled from the checkpoint, never evaluated
+      // copies of earlier leaves, in order of first use
+      for (int i = lo; i < hi; ++i)
+        t.for_each_operand(t.nodes[i], [&](int j) {
+          if (j < lo && leaf(t.nodes[j]) && stamp[j] != (int)s) {
+            stamp[j] = (int)s;
+            leaf_slot[j] = (int)L.nodes.size();
+            L.nodes.push_back(t.nodes[j]);
+          }
+        });
+      const int own = (int)L.nodes.size();
+      auto local = [&](int j) {
+        if (j >= lo) return own + (j - lo);
+        if (leaf(t.nodes[j])) return leaf_slot[j];
+        auto it = std::lower_bound(live.begin(), live.end(), j);
+        assert(it != live.end() && *it == j);
+        return int(it - live.begin());
+      };
+      for (int i = lo; i < hi; ++i) {
+        Tape::Node n = t.nodes[i];
+        if (Tape::is_nary(n.kind)) {
+          const int off = (int)L.args.size();
+          for (int k = 0; k < n.b; ++k) L.args.push_back(local(t.args[n.a + k]));
+          n.a = off;
+          L.max_args = std::max(L.max_args, (std::size_t)n.b);
+        } else {
+          if (n.a >= 0) n.a = local(n.a);
+          if (n.b >= 0) n.b = local(n.b);
+          if (n.e >= 0) n.e = local(n.e);
+        }
+        L.nodes.push_back(n);
+      }
+      if (t.output_id >= lo && t.output_id < hi) g.out = local(t.output_id);
+      // live-in of the next segment: still-read values among ours and our live-in
+      std::vector<int> nxt;
+      for (int j : live) if (a.last_use[j] >= hi) nxt.push_back(j);
+      for (int j = lo; j < hi; ++j) if (!leaf(t.nodes[j]) && a.last_use[j] >= hi) nxt.push_back(j);
+      for (int j : nxt) g.next.push_back(local(j));
+      live.swap(nxt);
+    }
+  }
+
+  // Evaluates segment s from its live-in values st, then overwrites st with
+  // the live-in values of segment s + 1 (st is copied first, so it may alias)
+  void step(std::size_t s, const double* inputs, double* st, Workspace& ws) const {
+    const Segment& g = segs[s];
+    double* val = ws.val.data();
+    std::copy(st, st + g.live, val);
+    const auto& nodes = g.local.nodes;
+    for (int i = (int)g.live; i < (int)nodes.size(); ++i) {
+      const auto& n = nodes[i];
+      if (n.kind == Tape::KSinCos) { val[i] = std::sin(val[n.a]); val[i + 1] = std::cos(val[n.a]); ++i; continue; }
+      val[i] = g.local.node_value(n, val, inputs);
+    }
+    for (std::size_t k = 0; k < g.next.size(); ++k) st[k] = val[g.next[k]];
+  }
+
+  // Live-in values of segment `to`, advanced from those of segment lo (from)
+  const double* advance(std::size_t lo, std::size_t to, const double* from, const double* inputs, Workspace& ws) const {
+    if (to == lo) return from;
+    double* st = ws.state.data();
+    if (from != st) std::copy(from, from + segs[lo].live, st);
+    for (std::size_t s = lo; s < to; ++s) { step(s, inputs, st, ws); ++ws.advanced; }
+    return st;
+  }
+
+  // Re-evaluates segment s from its live-in values and runs its adjoint sweep:
+  // seeds from the carried adjoints of the next segment's live-in (and the
+  // output), gathers Var adjoints and leaves the adjoints of its own live-in
+  // in ws.carry
+  void record_reverse(std::size_t s, const double* from, const double* inputs, Workspace& ws, double* grad, double& v) const {
+    const Segment& g = segs[s];
+    double* st = ws.state.data();
+    if (from != st) std::copy(from, from + g.live, st);
+    step(s, inputs, st, ws);
+    const double* val = ws.val.data();
+    double* bar = ws.bar.data();
+    const int len = (int)g.local.nodes.size();
+    std::fill(bar, bar + len, 0.0);
+    for (std::size_t k = 0; k < g.next.size(); ++k) bar[g.next[k]] += ws.carry[k];
+    if (g.out >= 0) { bar[g.out] += 1.0; v = val[g.out]; }
+    g.local.reverse_range(len - 1, (int)g.live, val, bar, ws.scratch.data());
+    for (int i = (int)g.live; i < len; ++i)
+      if (g.local.nodes[i].kind == Tape::KVar) grad[g.local.nodes[i].var_index] += bar[i];
+    std::copy(bar, bar + g.live, ws.carry.data());
+  }
+
+  // Reverses segments [lo, hi) given the live-in values of lo (from), with c
+  // free snapshot slots starting at snap
+  void reverse(std::size_t lo, std::size_t hi, std::size_t c, const double* from, double* snap,
+               const double* inputs, Workspace& ws, double* grad, double& v) const {
+    const std::size_t W = plan.max_live;
+    while (hi - lo > 1) {
+      if (c == 0) { // no slot left: advance from lo again for every segment
+        for (std::size_t k = hi; k-- > lo;) record_reverse(k, advance(lo, k, from, inputs, ws), inputs, ws, grad, v);
+        return;
+      }
+      const std::size_t m = lo + (std::size_t)revolve::split(hi - lo, c);
+      const double* st = advance(lo, m, from, inputs, ws);
+      std::copy(st, st + segs[m].live, snap);
+      reverse(m, hi, c - 1, snap, snap + W, inputs, ws, grad, v);
+      hi = m;
+    }
+    record_reverse(lo, from, inputs, ws, grad, v);
+  }
+};
+
+} // namespace et
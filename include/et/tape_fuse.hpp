@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "et/tape_backend.hpp"
+
+namespace et {
+
+struct FuseStats {
+  std::size_t fma = 0;     // a*b + c
+  std::size_t fms = 0;     // a*b - c
+  std::size_t square = 0;  // x*x
+  std::size_t sincos = 0;  // sin(x), cos(x) pairs
+  std::size_t removed = 0; // instructions saved
+};
+
+// Peephole fusion over a Tape: a Mul whose only reader is an Add (either
+// side) or the left side of a Sub is folded into it as KFma/KFms; a remaining
+// Mul of a value by itself becomes KSquare; the first Sin and Cos of the same
+// operand become an adjacent KSinCos/KCosPair, computed together in forward
+// sweeps and differentiated from each other's values in reverse. Muls that
+// are outputs are kept. The result is an equivalent tape with renumbered
+// nodes and outputs; fused arithmetic rounds once where fma is fast.
+inline Tape fuse_tape(const Tape& t, FuseStats* stats = nullptr) {
+  using K = Tape::Kind;
+  const int N = (int)t.nodes.size();
+  std::vector<int> uses(N, 0);
+  for (const auto& n : t.nodes) t.for_each_operand(n, [&](int j){ ++uses[j]; });
+  for (std::size_t k = 0; k < t.num_outputs(); ++k) if (t.output(k) >= 0) ++uses[t.output(k)];
+
+  // Plan: which Mul each Add/Sub absorbs, and the sin/cos partners
+  std::vector<int> absorb(N, -1);  // consumer -> absorbed Mul
+  std::vector<char> absorbed(N, 0);
+  std::vector<int> partner(N, -1);
+  {
+    auto single_mul = [&](int j) { return t.nodes[j].kind == K::KMul && uses[j] == 1; };
+    std::vector<int> sin_of(N, -1), cos_of(N, -1);
+    for (int i = 0; i < N; ++i) {
+      const auto& n = t.nodes[i];
+      if (n.kind == K::KAdd || n.kind == K::KSub) {
+        int m = -1;
+        if (single_mul(n.a)) m = n.a;
+        else if (n.kind == K::KAdd && single_mul(n.b)) m = n.b;
+        if (m >= 0) { absorb[i] = m; absorbed[m] = 1; }
+      } else if (n.kind == K::KSin && sin_of[n.a] < 0) {
+        sin_of[n.a] = i;
+      } else if (n.kind == K::KCos && cos_of[n.a] < 0) {
+        cos_of[n.a] = i;
+      }
+    }
+    for (int x = 0; x < N; ++x)
+      if (sin_of[x] >= 0 && cos_of[x] >= 0) { partner[sin_of[x]] = cos_of[x]; partner[cos_of[x]] = sin_of[x]; }
+  }
+
+  Tape out;
+  out.arity = t.input_count();
+  out.max_args = t.max_args;
+  out.nodes.reserve(N);
+  std::vector<int> map(N, -1);
+  auto push = [&](const Tape::Node& n) { out.nodes.push_back(n); return (int)out.nodes.size() - 1; };
+  for (int i = 0; i < N; ++i) {
+    if (absorbed[i] || map[i] >= 0) continue;
+    Tape::Node n = t.nodes[i];
+    if (Tape::is_nary(n.kind)) {
+      const int off = (int)out.args.size();
+      for (int k = 0; k < n.b; ++k) out.args.push_back(map[t.args[n.a + k]]);
+      n.a = off;
+      map[i] = push(n);
+      continue;
+    }
+    if (absorb[i] >= 0) {
+      const Tape::Node& m = t.nodes[absorb[i]];
+      const int addend = absorb[i] == n.a ? n.b : n.a;
+      const bool sub = n.kind == K::KSub;
+      n.kind = sub ? K::KFms : K::KFma;
+      n.a = map[m.a]; n.b = map[m.b]; n.e = map[addend];
+      map[i] = push(n);
+      if (stats) { ++(sub ? stats->fms : stats->fma); ++stats->removed; }
+      continue;
+    }
+    if (n.a >= 0) n.a = map[n.a];
+    if (n.b >= 0) n.b = map[n.b];
+    if (n.e >= 0) n.e = map[n.e];
+    if (n.kind == K::KMul && n.a == n.b) {
+      n.kind = K::KSquare; n.b = -1;
+      if (stats) ++stats->square;
+    } else if (partner[i] >= 0) {
+      const bool is_sin = n.kind == K::KSin;
+      n.kind = K::KSinCos;
+      const int s = push(n);
+      n.kind = K::KCosPair;
+      push(n);
+      map[is_sin ? i : partner[i]] = s;
+      map[is_sin ? partner[i] : i] = s + 1;
+      if (stats) ++stats->sincos;
+      continue;
+    }
+    map[i] = push(n);
+  }
+
+  for (std::size_t k = 0; k < t.outputs.size(); ++k) out.outputs.push_back(map[t.outputs[k]]);
+  out.output_id = t.output_id >= 0 ? map[t.output_id] : -1;
+  return out;
+}
+
+} // namespace et
@@ -0,0 +1,268 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "et/tape_backend.hpp"
+
+namespace et {
+
+// Dependency levels of a tape: Var/Const nodes are level 0 and every other
+// node sits one above its deepest operand, so the nodes of one level are
+// independent of each other. Also holds the consumer lists (CSR) used by the
+// pull-based reverse sweep: the readers of node j are cons[cbeg[j] ..
+// cbeg[j+1]), each with the index of its local partial against j in the
+// layout of Tape::value_partials (3 * reader + slot, or 3N + args slot).
+struct TapeLevels {
+  std::vector<int> level;         // per node
+  std::vector<int> order;         // nodes grouped by level, ascending within a level
+  std::vector<std::size_t> start; // level l is order[start[l] .. start[l+1])
+  std::vector<std::size_t> cbeg;
+  std::vector<int> cons, cpart;
+
+  std::size_t levels() const { return start.empty() ? 0 : start.size() - 1; } // critical path, in nodes
+  std::size_t work() const { return order.size(); }                              // total nodes
+  std::size_t width(std::size_t l) const { return start[l + 1] - start[l]; }
+  std::size_t widest() const {
+    std::size_t w = 0;
+    for (std::size_t l = 0; l < levels(); ++l) w = std::max(w, width(l));
+    return w;
+  }
+  // Average nodes per level: the speedup bound for level-synchronous sweeps
+  double parallelism() const { return levels() ? double(work()) / double(levels()) : 0.0; }
+};
+
+inline TapeLevels level_schedule(const Tape& t) {
+  const int N = (int)t.nodes.size();
+  TapeLevels s;
+  s.level.assign(N, 0);
+  int top = -1;
+  for (int i = 0; i < N; ++i) {
+    int l = 0;
+    t.for_each_operand(t.nodes[i], [&](int j){ l = std::max(l, s.level[j] + 1); });
+    s.level[i] = l;
+    top = std::max(top, l);
+  }
+  // counting sort by level keeps node order within a level
+  s.start.assign(top + 2, 0);
+  for (int i = 0; i < N; ++i) ++s.start[s.level[i] + 1];
+  for (int l = 0; l <= top; ++l) s.start[l + 1] += s.start[l];
+  s.order.resize(N);
+  std::vector<std::size_t> fill(s.start.begin(), s.start.end() - 1);
+  for (int i = 0; i < N; ++i) s.order[fill[s.level[i]]++] = i;
+
+  // consumer CSR; readers are listed in node order
+  s.cbeg.assign(N + 1, 0);
+  auto edges = [&](auto&& f) {
+    for (int i = 0; i < N; ++i) {
+      const auto& n = t.nodes[i];
+      if (Tape::is_nary(n.kind)) {
+        for (int k = 0; k < n.b; ++k) f(t.args[n.a + k], i, 3 * N + n.a + k);
+        continue;
+      }
+      if (n.a >= 0) f(n.a, i, 3 * i);
+      if (n.b >= 0) f(n.b, i, 3 * i + 1);
+      if (n.e >= 0) f(n.e, i, 3 * i + 2);
+    }
+  };
+  edges([&](int j, int, int) { ++s.cbeg[j + 1]; });
+  for (int j = 0; j < N; ++j) s.cbeg[j + 1] += s.cbeg[j];
+  s.cons.resize(s.cbeg[N]);
+  s.cpart.resize(s.cbeg[N]);
+  std::vector<std::size_t> pos(s.cbeg.begin(), s.cbeg.end() - 1);
+  edges([&](int j, int i, int p) { s.cons[pos[j]] = i; s.cpart[pos[j]] = p; ++pos[j]; });
+  return s;
+}
+
+// Copy of t with its nodes renumbered in level order (order[k] becomes node
+// k), so each level is a contiguous range of nodes. Operands, n-ary operand
+// lists and outputs are remapped; a KSinCos/KCosPair pair stays adjacent.
+inline Tape level_order(const Tape& t, const TapeLevels& s) {
+  const int N = (int)t.nodes.size();
+  std::vector<int> to(N);
+  for (int k = 0; k < N; ++k) to[s.order[k]] = k;
+  Tape r = t;
+  for (int k = 0; k < N; ++k) {
+    Tape::Node n = t.nodes[s.order[k]];
+    if (!Tape::is_nary(n.kind)) {
+      if (n.a >= 0) n.a = to[n.a];
+      if (n.b >= 0) n.b = to[n.b];
+      if (n.e >= 0) n.e = to[n.e];
+    }
+    r.nodes[k] = n;
+  }
+  for (auto& j : r.args) j = to[j];
+  if (r.output_id >= 0) r.output_id = to[r.output_id];
+  for (auto& o : r.outputs) o = to[o];
+  return r;
+}
+
+// Evaluates one large tape with its nodes spread over threads level by level,
+// on a level_order copy of the tape so each level is a contiguous range.
+// The forward sweep computes values (and, for gradients, local partials via
+// Tape::value_partials); the reverse sweep pulls: each node sums reader
+// adjoint * partial over its consumer list, so every thread writes only the
+// adjoints of its own nodes and no atomics or per-thread buffers are needed.
+// Levels narrower than min_parallel run on the calling thread alone, merged
+// into one phase with their narrow neighbours; threads meet at a barrier after
+// each phase. With no wide level (or one thread) the copy is evaluated by the
+// ordinary serial sweeps. Values match Tape::forward exactly; gradients match
+// up to summation order.
+struct LevelEvaluator {
+  Tape tape;         // level-ordered copy
+  TapeLevels sched;  // levels of `tape` (order is the identity)
+  std::size_t min_parallel;
+
+  // threads = 0 uses std::thread::hardware_concurrency()
+  explicit LevelEvaluator(const Tape& t, std::size_t threads = 0, std::size_t min_parallel = 1024)
+      : tape(level_order(t, level_schedule(t))), sched(level_schedule(tape)),
+        min_parallel(std::max<std::size_t>(min_parallel, 1)), ws(tape) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    P = threads;
+    for (std::size_t l = 0; l < sched.levels(); ++l) {
+      const bool wide = P > 1 && sched.width(l) >= this->min_parallel;
+      if (wide || phases.empty() || phases.back().parallel) phases.push_back(Phase{ l, l + 1, wide });
+      else phases.back().hi = l + 1;
+    }
+    if (parallel_phases() == 0) P = 1;
+    if (P > 1) ws.partial.resize(3 * tape.nodes.size() + tape.args.size());
+    for (std::size_t w = 1; w < P; ++w) pool.emplace_back([this, w] { worker(w); });
+  }
+
+  ~LevelEvaluator() {
+    { std::lock_guard<std::mutex> lk(mu); stop = true; }
+    wake.notify_all();
+    for (auto& th : pool) th.join();
+  }
+
+  LevelEvaluator(const LevelEvaluator&) = delete;
+  LevelEvaluator& operator=(const LevelEvaluator&) = delete;
+
+  std::size_t threads() const { return P; }
+  std::size_t parallel_phases() const {
+    std::size_t k = 0;
+    for (auto& ph : phases) k += ph.parallel;
+    return k;
+  }
+
+  // Value of output_id
+  double forward(const double* inputs) {
+    if (P == 1) return tape.forward(inputs, ws);
+    launch(inputs, false);
+    return ws.val[tape.output_id];
+  }
+
+  // Value of output_id and its gradient (grad[0..arity)), as Tape::value_and_grad
+  double value_and_grad(const double* inputs, double* grad) {
+    if (P == 1) return tape.value_and_grad(inputs, ws, grad);
+    launch(inputs, true);
+    tape.gather_grad(ws.bar.data(), grad, tape.output_id);
+    return ws.val[tape.output_id];
+  }
+
+  double forward(const std::vector<double>& inputs) { return forward(inputs.data()); }
+  std::pair<double, std::vector<double>> value_and_grad(const std::vector<double>& inputs) {
+    std::vector<double> grad(tape.input_count(), 0.0);
+    const double v = value_and_grad(inputs.data(), grad.data());
+    return { v, std::move(grad) };
+  }
+
+private:
+  struct Phase { std::size_t lo, hi; bool parallel; }; // levels [lo, hi)
+
+  Tape::Workspace ws;
+  std::vector<Phase> phases;
+  std::size_t P = 1;
+  std::vector<std::thread> pool;
+  std::mutex mu;
+  std::condition_variable wake, done;
+  const double* job_in = nullptr;
+  bool job_grad = false;
+  std::size_t active = 0;
+  std::uint64_t generation = 0;
+  bool stop = false;
+  std::atomic<std::size_t> arrived{0};
+  std::atomic<std::uint64_t> round{0};
+
+  void launch(const double* inputs, bool grad) {
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      job_in = inputs; job_grad = grad;
+      active = P - 1; // workers; the caller runs as thread 0
+      ++generation;
+    }
+    wake.notify_all();
+    run(0);
+    std::unique_lock<std::mutex> lk(mu);
+    done.wait(lk, [&] { return active == 0; });
+  }
+
+  void worker(std::size_t w) {
+    std::uint64_t seen = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lk(mu);
+        wake.wait(lk, [&] { return stop || generation != seen; });
+        if (stop) return;
+        seen = generation;
+      }
+      run(w);
+      std::lock_guard<std::mutex> lk(mu);
+      if (--active == 0) done.notify_one();
+    }
+  }
+
+  void barrier() {
+    const std::uint64_t r = round.load(std::memory_order_acquire);
+    if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == P) {
+      arrived.store(0, std::memory_order_relaxed);
+      round.fetch_add(1, std::memory_order_release);
+    } else {
+      while (round.load(std::memory_order_acquire) == r) std::this_thread::yield();
+    }
+  }
+
+  // Nodes [b, e) of phase ph handled by thread w: a slice of a wide level, or
+  // the whole run of narrow levels on thread 0 (empty elsewhere)
+  std::pair<std::size_t, std::size_t> slice(const Phase& ph, std::size_t w) const {
+    const std::size_t b = sched.start[ph.lo], n = sched.start[ph.hi] - b;
+    if (!ph.parallel) return w == 0 ? std::make_pair(b, b + n) : std::make_pair(b, b);
+    return { b + n * w / P, b + n * (w + 1) / P };
+  }
+
+  void run(std::size_t w) {
+    const Tape& t = tape;
+    const double* in = job_in;
+    double* val = ws.val.data();
+    double* bar = ws.bar.data();
+    double* part = ws.partial.data();
+    double* npart = part + 3 * t.nodes.size();
+    for (const auto& ph : phases) {
+      const auto [b, e] = slice(ph, w);
+      if (job_grad) for (std::size_t i = b; i < e; ++i) val[i] = t.value_partials(t.nodes[i], val, in, part + 3 * i, npart);
+      else          for (std::size_t i = b; i < e; ++i) val[i] = t.node_value(t.nodes[i], val, in);
+      barrier();
+    }
+    if (!job_grad) return;
+    // Nodes after the output in level order are not its operands: zero adjoint
+    const std::size_t out = (std::size_t)t.output_id;
+    for (auto ph = phases.rbegin(); ph != phases.rend(); ++ph) {
+      const auto [b, e] = slice(*ph, w);
+      for (std::size_t j = e; j-- > b;) {
+        if (j > out) { bar[j] = 0.0; continue; }
+        double g = j == out ? 1.0 : 0.0;
+        for (std::size_t k = sched.cbeg[j]; k < sched.cbeg[j + 1]; ++k) g += bar[sched.cons[k]] * part[sched.cpart[k]];
+        bar[j] = g;
+      }
+      barrier();
+    }
+  }
+};
+
+} // namespace et
@@ -0,0 +1,192 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "et/tape_backend.hpp"
+
+namespace et {
+
+// Thread pool that evaluates one Tape over many independent input rows. Rows
+// are cut into chunks; every thread starts with a contiguous run of chunks,
+// takes them from the front, and when it runs dry steals the back half of
+// another thread's run. Each thread owns a Tape::Workspace and a column
+// buffer, so steady-state calls do not allocate. The calling thread takes
+// part as worker 0; the tape must outlive the evaluator and not change.
+//   values only : each chunk is transposed to columns and run through
+//                 forward_batch (vectorized block kernels)
+//   with grads  : value_and_grad per row
+struct ParallelEvaluator {
+  struct Stats {
+    std::size_t chunks = 0; // chunks processed
+    std::size_t steals = 0; // successful steals
+  };
+
+  const Tape* tape;
+  std::size_t chunk_rows;
+
+  // threads = 0 uses std::thread::hardware_concurrency()
+  explicit ParallelEvaluator(const Tape& t, std::size_t threads = 0, std::size_t chunk = 4 * Tape::batch_block)
+      : tape(&t), chunk_rows(std::max<std::size_t>(chunk, 1)) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t w = 0; w < threads; ++w) slots.emplace_back(new Slot(t, chunk_rows));
+    for (std::size_t w = 1; w < threads; ++w) pool.emplace_back([this, w] { worker(w); });
+  }
+
+  ~ParallelEvaluator() {
+    { std::lock_guard<std::mutex> lk(mu); stop = true; }
+    wake.notify_all();
+    for (auto& th : pool) th.join();
+  }
+
+  ParallelEvaluator(const ParallelEvaluator&) = delete;
+  ParallelEvaluator& operator=(const ParallelEvaluator&) = delete;
+
+  std::size_t threads() const { return slots.size(); }
+
+  // rows: n x arity row-major inputs; values[n]; grads (optional): n x arity
+  // row-major gradients of output_id
+  void evaluate(const double* rows, std::size_t n, double* values, double* grads = nullptr, Stats* stats = nullptr) {
+    const std::size_t nchunks = (n + chunk_rows - 1) / chunk_rows;
+    const std::size_t P = slots.size();
+    for (std::size_t w = 0; w < P; ++w) {
+      slots[w]->range.store(pack(nchunks * w / P, nchunks * (w + 1) / P), std::memory_order_relaxed);
+      slots[w]->chunks = slots[w]->steals = 0;
+    }
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      job = Job{ rows, n, values, grads };
+      active = P;
+      ++generation;
+    }
+    wake.notify_all();
+    run(0);
+    {
+      std::unique_lock<std::mutex> lk(mu);
+      done.wait(lk, [&] { return active == 0; });
+    }
+    if (stats) {
+      *stats = Stats{};
+      for (auto& s : slots) { stats->chunks += s->chunks; stats->steals += s->steals; }
+    }
+  }
+
+  // Flattened-row convenience: rows.size() = n * arity
+  std::vector<double> evaluate(const std::vector<double>& rows, std::vector<double>* grads = nullptr) {
+    const std::size_t A = tape->input_count();
+    const std::size_t n = A ? rows.size() / A : 0;
+    std::vector<double> values(n);
+    if (grads) grads->assign(n * A, 0.0);
+    evaluate(rows.data(), n, values.data(), grads ? grads->data() : nullptr);
+    return values;
+  }
+
+private:
+  struct Job {
+    const double* rows = nullptr;
+    std::size_t n = 0;
+    double* values = nullptr;
+    double* grads = nullptr;
+  };
+
+  // Per-thread state; range packs [begin, end) chunk indices as two 32-bit halves
+  struct Slot {
+    Tape::Workspace ws;
+    std::vector<double> cols;
+    std::vector<const double*> ptrs;
+    std::atomic<std::uint64_t> range{0};
+    std::size_t chunks = 0, steals = 0;
+    Slot(const Tape& t, std::size_t chunk) : ws(t), cols(t.input_count() * chunk), ptrs(t.input_count()) {
+      for (std::size_t k = 0; k < ptrs.size(); ++k) ptrs[k] = cols.data() + k * chunk;
+    }
+  };
+
+  static std::uint64_t pack(std::uint64_t b, std::uint64_t e) { return (b << 32) | e; }
+
+  std::vector<std::unique_ptr<Slot>> slots;
+  std::vector<std::thread> pool;
+  std::mutex mu;
+  std::condition_variable wake, done;
+  Job job;
+  std::size_t active = 0;
+  std::uint64_t generation = 0;
+  bool stop = false;
+
+  void worker(std::size_t w) {
+    std::uint64_t seen = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lk(mu);
+        wake.wait(lk, [&] { return stop || generation != seen; });
+        if (stop) return;
+        seen = generation;
+      }
+      run(w);
+    }
+  }
+
+  // Takes the front chunk of slot s
+  static bool pop(Slot& s, std::size_t& c) {
+    std::uint64_t r = s.range.load(std::memory_order_acquire);
+    for (;;) {
+      const std::uint64_t b = r >> 32, e = r & 0xffffffffu;
+      if (b >= e) return false;
+      if (s.range.compare_exchange_weak(r, pack(b + 1, e), std::memory_order_acq_rel)) { c = b; return true; }
+    }
+  }
+
+  // Moves the back half of another slot's run into slot w
+  bool steal(std::size_t w) {
+    const std::size_t P = slots.size();
+    for (std::size_t k = 1; k < P; ++k) {
+      Slot& v = *slots[(w + k) % P];
+      std::uint64_t r = v.range.load(std::memory_order_acquire);
+      for (;;) {
+        const std::uint64_t b = r >> 32, e = r & 0xffffffffu;
+        if (b >= e) break;
+        const std::uint64_t mid = e - (e - b + 1) / 2;
+        if (v.range.compare_exchange_weak(r, pack(b, mid), std::memory_order_acq_rel)) {
+          slots[w]->range.store(pack(mid, e), std::memory_order_release);
+          ++slots[w]->steals;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  void run(std::size_t w) {
+    Slot& s = *slots[w];
+    const Job jb = [&] { std::lock_guard<std::mutex> lk(mu); return job; }();
+    std::size_t c;
+    for (;;) {
+      if (!pop(s, c) && !(steal(w) && pop(s, c))) break;
+      process(s, jb, c);
+    }
+    std::lock_guard<std::mutex> lk(mu);
+    if (--active == 0) done.notify_one();
+  }
+
+  void process(Slot& s, const Job& jb, std::size_t c) {
+    const Tape& t = *tape;
+    const std::size_t A = t.input_count();
+    const std::size_t r0 = c * chunk_rows, m = std::min(chunk_rows, jb.n - r0);
+    ++s.chunks;
+    if (jb.grads) {
+      for (std::size_t r = r0; r < r0 + m; ++r)
+        jb.values[r] = t.value_and_grad(jb.rows + r * A, s.ws, jb.grads + r * A);
+      return;
+    }
+    for (std::size_t r = 0; r < m; ++r)
+      for (std::size_t k = 0; k < A; ++k) s.cols[k * chunk_rows + r] = jb.rows[(r0 + r) * A + k];
+    t.forward_batch(s.ptrs.data(), m, jb.values + r0, s.ws);
+  }
+};
+
+} // namespace et
@@ -0,0 +1,93 @@
+#pragma once
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "et/tape_backend.hpp"
+
+namespace et {
+
+// Forward-only form of a Tape whose values live in a compact set of reusable
+// slots instead of one slot per node. code.nodes[i] is the i-th live
+// instruction with its operands renamed to slots; its result goes to dst[i].
+// Reverse mode still runs on the original Tape, which keeps every value.
+struct SlotProgram {
+  Tape code;
+  std::vector<int> dst;
+  int num_slots = 0;
+  int output_slot = -1;
+  std::vector<int> output_slots; // one per Tape::output(k)
+
+  // slots must hold num_slots entries
+  double forward(const double* inputs, double* slots) const {
+    for (std::size_t i = 0; i < code.nodes.size(); ++i)
+      slots[dst[i]] = code.node_value(code.nodes[i], slots, inputs);
+    return slots[output_slot];
+  }
+
+  double forward(const std::vector<double>& inputs) const {
+    std::vector<double> slots(num_slots);
+    return forward(inputs.data(), slots.data());
+  }
+
+  void forward_all(const double* inputs, double* slots, double* out) const {
+    forward(inputs, slots);
+    for (std::size_t k = 0; k < output_slots.size(); ++k) out[k] = slots[output_slots[k]];
+  }
+};
+
+// Liveness-based slot assignment: drops nodes no output depends on,
+// computes each value's last use, and hands freed slots (LIFO, so recently
+// touched memory is reused first) to later results. A result may reuse the
+// slot of an operand that dies at the same instruction.
+inline SlotProgram allocate_slots(const Tape& t) {
+  SlotProgram p;
+  const int N = (int)t.nodes.size();
+  if (t.output_id < 0) return p;
+
+  // Reachability from the outputs
+  std::vector<char> live(N, 0);
+  for (std::size_t k = 0; k < t.num_outputs(); ++k) live[t.output(k)] = 1;
+  for (int i = N - 1; i >= 0; --i)
+    if (live[i]) t.for_each_operand(t.nodes[i], [&](int j){ live[j] = 1; });
+
+  // Last use of every live value; outputs stay alive to the end
+  constexpr int kForever = std::numeric_limits<int>::max();
+  std::vector<int> last_use(N, -1);
+  for (int i = 0; i < N; ++i)
+    if (live[i]) t.for_each_operand(t.nodes[i], [&](int j){ last_use[j] = i; });
+  for (std::size_t k = 0; k < t.num_outputs(); ++k) last_use[t.output(k)] = kForever;
+
+  std::vector<int> slot_of(N, -1);
+  std::vector<int> free_slots;
+  p.code.arity = t.input_count();
+  p.code.max_args = t.max_args;
+  for (int i = 0; i < N; ++i) {
+    if (!live[i]) continue;
+    Tape::Node n = t.nodes[i];
+    if (Tape::is_nary(n.kind)) {
+      const int off = (int)p.code.args.size();
+      for (int k = 0; k < n.b; ++k) p.code.args.push_back(slot_of[t.args[n.a + k]]);
+      n.a = off;
+    } else {
+      if (n.a >= 0) n.a = slot_of[n.a];
+      if (n.b >= 0) n.b = slot_of[n.b];
+      if (n.e >= 0) n.e = slot_of[n.e];
+    }
+    // Release operands whose last reader is this instruction
+    t.for_each_operand(t.nodes[i], [&](int j){
+      if (last_use[j] == i && slot_of[j] >= 0) { free_slots.push_back(slot_of[j]); slot_of[j] = -1; }
+    });
+    int s;
+    if (!free_slots.empty()) { s = free_slots.back(); free_slots.pop_back(); }
+    else s = p.num_slots++;
+    slot_of[i] = s;
+    p.code.nodes.push_back(n);
+    p.dst.push_back(s);
+  }
+  for (std::size_t k = 0; k < t.num_outputs(); ++k) p.output_slots.push_back(slot_of[t.output(k)]);
+  p.output_slot = p.output_slots[0];
+  return p;
+}
+
+} // namespace et
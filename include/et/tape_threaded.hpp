@@ -0,0 +1,293 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "et/tape_backend.hpp"
+
+// Computed goto (labels as values) is a GNU extension; define
+// ET_NO_COMPUTED_GOTO to use the portable handler-pointer loop instead
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(ET_NO_COMPUTED_GOTO)
+#define ET_COMPUTED_GOTO 1
+#else
+#define ET_COMPUTED_GOTO 0
+#endif
+
+namespace et {
+
+enum class TapeEngine {
+  Switch,  // Tape's own sweeps: one switch per node
+  Threaded // pre-decoded handlers, each dispatching directly to the next
+};
+
+// Forward handlers: (name, nodes consumed, body). A handler writes val[i]
+// (and val[i+1] when it consumes two nodes) from instruction I = code[i].
+#define ET_TT_BIN_Add(k, N) val[k] = val[N.a] + val[N.b]
+#define ET_TT_BIN_Sub(k, N) val[k] = val[N.a] - val[N.b]
+#define ET_TT_BIN_Mul(k, N) val[k] = val[N.a] * val[N.b]
+#define ET_TT_PAIR(X, A, B) \
+  X(A##B, 2, { const Insn& J = code[i + 1]; ET_TT_BIN_##A(i, I); ET_TT_BIN_##B(i + 1, J); })
+#define ET_TT_FWD_OPS(X) \
+  X(Var,    1, val[i] = in[I.a]) \
+  X(Const,  1, val[i] = I.c) \
+  X(Add,    1, ET_TT_BIN_Add(i, I)) \
+  X(Sub,    1, ET_TT_BIN_Sub(i, I)) \
+  X(Mul,    1, ET_TT_BIN_Mul(i, I)) \
+  X(Div,    1, val[i] = val[I.a] / val[I.b]) \
+  X(Neg,    1, val[i] = -val[I.a]) \
+  X(Sin,    1, val[i] = std::sin(val[I.a])) \
+  X(Cos,    1, val[i] = std::cos(val[I.a])) \
+  X(Exp,    1, val[i] = std::exp(val[I.a])) \
+  X(Log,    1, val[i] = std::log(val[I.a])) \
+  X(Sqrt,   1, val[i] = std::sqrt(val[I.a])) \
+  X(Tanh,   1, val[i] = std::tanh(val[I.a])) \
+  X(Recip,  1, val[i] = 1.0 / val[I.a]) \
+  X(Rsqrt,  1, val[i] = 1.0 / std::sqrt(val[I.a])) \
+  X(Fma,    1, val[i] = Tape::fmadd(val[I.a], val[I.b], val[I.e])) \
+  X(Fms,    1, val[i] = Tape::fmadd(val[I.a], val[I.b], -val[I.e])) \
+  X(Square, 1, val[i] = val[I.a] * val[I.a]) \
+  X(SinCos, 2, { const double x = val[I.a]; val[i] = std::sin(x); val[i + 1] = std::cos(x); }) \
+  X(Generic,1, val[i] = t->node_value(t->nodes[i], val, in)) \
+  X(VarVar, 2, { val[i] = in[I.a]; val[i + 1] = in[code[i + 1].a]; }) \
+  ET_TT_PAIR(X, Add, Add) ET_TT_PAIR(X, Add, Sub) ET_TT_PAIR(X, Add, Mul) \
+  ET_TT_PAIR(X, Sub, Add) ET_TT_PAIR(X, Sub, Sub) ET_TT_PAIR(X, Sub, Mul) \
+  ET_TT_PAIR(X, Mul, Add) ET_TT_PAIR(X, Mul, Sub) ET_TT_PAIR(X, Mul, Mul)
+
+// Reverse handlers: (name, body) with g = bar[i]. Var accumulates straight
+// into grad, so no gather pass follows.
+#define ET_TT_REV_OPS(X) \
+  X(Nop,    (void)g) \
+  X(Var,    grad[I.a] += g) \
+  X(Add,    { bar[I.a] += g; bar[I.b] += g; }) \
+  X(Sub,    { bar[I.a] += g; bar[I.b] -= g; }) \
+  X(Mul,    { bar[I.a] += g * val[I.b]; bar[I.b] += g * val[I.a]; }) \
+  X(Div,    { bar[I.a] += g / val[I.b]; bar[I.b] -= g * val[i] / val[I.b]; }) \
+  X(Neg,    bar[I.a] -= g) \
+  X(Sin,    bar[I.a] += g * std::cos(val[I.a])) \
+  X(Cos,    bar[I.a] -= g * std::sin(val[I.a])) \
+  X(Exp,    bar[I.a] += g * val[i]) \
+  X(Log,    bar[I.a] += g / val[I.a]) \
+  X(Sqrt,   bar[I.a] += g * (0.5 / val[i])) \
+  X(Tanh,   bar[I.a] += g * (1.0 - val[i] * val[i])) \
+  X(Recip,  bar[I.a] -= g * (val[i] * val[i])) \
+  X(Rsqrt,  bar[I.a] -= g * (0.5 * (val[i] * val[i] * val[i]))) \
+  X(Fma,    { bar[I.a] += g * val[I.b]; bar[I.b] += g * val[I.a]; bar[I.e] += g; }) \
+  X(Fms,    { bar[I.a] += g * val[I.b]; bar[I.b] += g * val[I.a]; bar[I.e] -= g; }) \
+  X(Square, bar[I.a] += g * (2.0 * val[I.a])) \
+  X(SinCos, bar[I.a] += g * val[i + 1]) \
+  X(CosPair,bar[I.a] -= g * val[i - 1]) \
+  X(Generic,t->reverse_node(i, val, bar, scratch))
+
+// Alternative execution engine for a Tape. The tape is decoded once into an
+// instruction array whose entries carry the address of their own handler
+// (a label with computed goto, else a function pointer), so every handler
+// ends in its own indirect jump to the next one instead of going back
+// through one shared switch. Forward runs also fuse common adjacent pairs
+// (two input loads, two add/sub/mul) into superinstructions; the value
+// layout is the Tape's, so results are identical to Tape::forward/backward.
+// `engine` picks threaded or switch dispatch at runtime. The ThreadedTape
+// points into the tape it was built from, which must outlive it.
+struct ThreadedTape {
+  struct Insn;
+#if ET_COMPUTED_GOTO
+  using FwdTarget = const void*;
+  using RevTarget = const void*;
+#else
+  using FwdTarget = int (*)(const Insn*, int, double*, const double*, const Tape*);
+  using RevTarget = void (*)(const Insn*, int, const double*, double*, double*, double*, const Tape*);
+#endif
+  struct Insn {
+    FwdTarget fwd{};
+    RevTarget rev{};
+    int a = -1, b = -1, e = -1; // operands; Var keeps its input index in a
+    double c = 0.0;
+  };
+
+#define ET_TT_ENUM(name, ...) F##name,
+  enum FwdOp { ET_TT_FWD_OPS(ET_TT_ENUM) kFwdOps };
+#undef ET_TT_ENUM
+#define ET_TT_ENUM(name, ...) R##name,
+  enum RevOp { ET_TT_REV_OPS(ET_TT_ENUM) kRevOps };
+#undef ET_TT_ENUM
+
+  const Tape* tape = nullptr;
+  TapeEngine engine = TapeEngine::Threaded;
+  std::size_t supers = 0;  // superinstructions formed
+  std::vector<Insn> prog;  // [reverse sentinel, node 0 .. node N-1, forward sentinel]
+
+  static constexpr bool computed_goto() { return ET_COMPUTED_GOTO != 0; }
+
+  explicit ThreadedTape(const Tape& t, bool superinstructions = true) : tape(&t) {
+    const int N = (int)t.nodes.size();
+    std::vector<int> fop(N), rop(N);
+    for (int i = 0; i < N; ++i) {
+      const auto& n = t.nodes[i];
+      fop[i] = FGeneric; rop[i] = RGeneric;
+      switch (n.kind) {
+        case Tape::KVar:    fop[i] = FVar;    rop[i] = RVar; break;
+        case Tape::KConst:  fop[i] = FConst;  rop[i] = RNop; break;
+        case Tape::KAdd:    fop[i] = FAdd;    rop[i] = RAdd; break;
+        case Tape::KSub:    fop[i] = FSub;    rop[i] = RSub; break;
+        case Tape::KMul:    fop[i] = FMul;    rop[i] = RMul; break;
+        case Tape::KDiv:    fop[i] = FDiv;    rop[i] = RDiv; break;
+        case Tape::KNeg:    fop[i] = FNeg;    rop[i] = RNeg; break;
+        case Tape::KSin:    fop[i] = FSin;    rop[i] = RSin; break;
+        case Tape::KCos:    fop[i] = FCos;    rop[i] = RCos; break;
+        case Tape::KExp:    fop[i] = FExp;    rop[i] = RExp; break;
+        case Tape::KLog:    fop[i] = FLog;    rop[i] = RLog; break;
+        case Tape::KSqrt:   fop[i] = FSqrt;   rop[i] = RSqrt; break;
+        case Tape::KTanh:   fop[i] = FTanh;   rop[i] = RTanh; break;
+        case Tape::KRecip:  fop[i] = FRecip;  rop[i] = RRecip; break;
+        case Tape::KRsqrt:  fop[i] = FRsqrt;  rop[i] = RRsqrt; break;
+        case Tape::KFma:    fop[i] = FFma;    rop[i] = RFma; break;
+        case Tape::KFms:    fop[i] = FFms;    rop[i] = RFms; break;
+        case Tape::KSquare: fop[i] = FSquare; rop[i] = RSquare; break;
+        case Tape::KSinCos: fop[i] = FSinCos; rop[i] = RSinCos; break;
+        case Tape::KCosPair:rop[i] = RCosPair; break; // forward: written by its KSinCos
+        default: break; // KPow, KSum, KProd: through Tape
+      }
+    }
+    if (superinstructions) {
+      auto arith = [&](int i) { return fop[i] == FAdd || fop[i] == FSub || fop[i] == FMul; };
+      for (int i = 0; i + 1 < N; ++i) {
+        int pair = -1;
+        if (fop[i] == FVar && fop[i + 1] == FVar) pair = FVarVar;
+        else if (arith(i) && arith(i + 1)) pair = FAddAdd + 3 * (fop[i] - FAdd) + (fop[i + 1] - FAdd);
+        if (pair < 0) continue;
+        fop[i] = pair; ++supers; ++i;
+      }
+    }
+
+    const FwdTarget* ft; const RevTarget* rt;
+    targets(ft, rt);
+    prog.resize(N + 2);
+    prog[0].rev = rt[kRevOps];      // reverse sentinel
+    prog[N + 1].fwd = ft[kFwdOps];  // forward sentinel
+    for (int i = 0; i < N; ++i) {
+      const auto& n = t.nodes[i];
+      Insn& I = prog[i + 1];
+      I.fwd = ft[fop[i]]; I.rev = rt[rop[i]];
+      I.a = n.kind == Tape::KVar ? (int)n.var_index : n.a;
+      I.b = n.b; I.e = n.e; I.c = n.c;
+    }
+  }
+
+  double forward(const double* inputs, Tape::Workspace& ws) const {
+    if (engine == TapeEngine::Switch) return tape->forward(inputs, ws);
+    assert(ws.val.size() == tape->nodes.size());
+    run_forward(code(), inputs, ws.val.data(), tape);
+    return ws.val[tape->output_id];
+  }
+
+  // Writes d(output)/d(inputs) into grad[0..arity) and returns the primal value
+  double backward(const double* inputs, Tape::Workspace& ws, double* grad) const {
+    if (engine == TapeEngine::Switch) return tape->backward(inputs, ws, grad);
+    assert(ws.val.size() == tape->nodes.size() && ws.bar.size() == tape->nodes.size());
+    const int out = tape->output_id;
+    run_forward(code(), inputs, ws.val.data(), tape);
+    std::fill(ws.bar.begin(), ws.bar.begin() + out + 1, 0.0);
+    ws.bar[out] = 1.0;
+    std::fill(grad, grad + tape->input_count(), 0.0);
+    run_reverse(code(), out, ws.val.data(), ws.bar.data(), grad, ws.scratch.data(), tape);
+    return ws.val[out];
+  }
+
+  double forward(const std::vector<double>& inputs) const {
+    Tape::Workspace ws(*tape);
+    return forward(inputs.data(), ws);
+  }
+
+  std::vector<double> backward(const std::vector<double>& inputs) const {
+    Tape::Workspace ws(*tape);
+    std::vector<double> grad(tape->input_count(), 0.0);
+    backward(inputs.data(), ws, grad.data());
+    return grad;
+  }
+
+private:
+  const Insn* code() const { return prog.data() + 1; }
+
+#if ET_COMPUTED_GOTO
+  static void targets(const FwdTarget*& ft, const RevTarget*& rt) {
+    run_forward(nullptr, nullptr, nullptr, nullptr, &ft);
+    run_reverse(nullptr, 0, nullptr, nullptr, nullptr, nullptr, nullptr, &rt);
+  }
+
+  // With table != nullptr, only reports the handler addresses
+  static void run_forward(const Insn* code, const double* in, double* val, const Tape* t,
+                          const FwdTarget** table = nullptr) {
+#define ET_TT_ADDR(name, ...) &&F_##name,
+    static const FwdTarget labels[] = { ET_TT_FWD_OPS(ET_TT_ADDR) &&F_end };
+#undef ET_TT_ADDR
+    if (table) { *table = labels; return; }
+    int i = 0;
+    goto *code[0].fwd;
+#define ET_TT_LABEL(name, step, body) \
+    F_##name: { const Insn& I = code[i]; (void)I; body; i += step; goto *code[i].fwd; }
+    ET_TT_FWD_OPS(ET_TT_LABEL)
+#undef ET_TT_LABEL
+  F_end:
+    (void)in; (void)t;
+  }
+
+  static void run_reverse(const Insn* code, int last, const double* val, double* bar, double* grad,
+                          double* scratch, const Tape* t, const RevTarget** table = nullptr) {
+#define ET_TT_ADDR(name, ...) &&R_##name,
+    static const RevTarget labels[] = { ET_TT_REV_OPS(ET_TT_ADDR) &&R_end };
+#undef ET_TT_ADDR
+    if (table) { *table = labels; return; }
+    int i = last;
+    goto *code[i].rev;
+#define ET_TT_LABEL(name, body) \
+    R_##name: { const Insn& I = code[i]; const double g = bar[i]; (void)I; (void)g; body; --i; goto *code[i].rev; }
+    ET_TT_REV_OPS(ET_TT_LABEL)
+#undef ET_TT_LABEL
+  R_end:
+    (void)scratch; (void)t; (void)grad;
+  }
+#else
+#define ET_TT_FN(name, step, body) \
+  static int F_##name(const Insn* code, int i, double* val, const double* in, const Tape* t) { \
+    const Insn& I = code[i]; (void)I; (void)in; (void)t; body; return step; }
+  ET_TT_FWD_OPS(ET_TT_FN)
+#undef ET_TT_FN
+  static int F_end(const Insn*, int, double*, const double*, const Tape*) { return 0; }
+#define ET_TT_FN(name, body) \
+  static void R_##name(const Insn* code, int i, const double* val, double* bar, double* grad, double* scratch, const Tape* t) { \
+    const Insn& I = code[i]; const double g = bar[i]; (void)I; (void)g; (void)val; (void)grad; (void)scratch; (void)t; body; }
+  ET_TT_REV_OPS(ET_TT_FN)
+#undef ET_TT_FN
+  static void R_end(const Insn*, int, const double*, double*, double*, double*, const Tape*) {}
+
+  static void targets(const FwdTarget*& ft, const RevTarget*& rt) {
+#define ET_TT_ADDR(name, ...) &F_##name,
+    static const FwdTarget f[] = { ET_TT_FWD_OPS(ET_TT_ADDR) &F_end };
+#undef ET_TT_ADDR
+#define ET_TT_ADDR(name, ...) &R_##name,
+    static const RevTarget r[] = { ET_TT_REV_OPS(ET_TT_ADDR) &R_end };
+#undef ET_TT_ADDR
+    ft = f; rt = r;
+  }
+
+  // Each handler returns how many nodes it consumed; the sentinel returns 0
+  static void run_forward(const Insn* code, const double* in, double* val, const Tape* t) {
+    for (int i = 0, step; (step = code[i].fwd(code, i, val, in, t)) != 0; i += step) {}
+  }
+
+  static void run_reverse(const Insn* code, int last, const double* val, double* bar, double* grad,
+                          double* scratch, const Tape* t) {
+    for (int i = last; i >= 0; --i) code[i].rev(code, i, val, bar, grad, scratch, t);
+  }
+#endif
+};
+
+} // namespace et
+
+#undef ET_TT_BIN_Add
+#undef ET_TT_BIN_Sub
+#undef ET_TT_BIN_Mul
+#undef ET_TT_PAIR
+#undef ET_TT_FWD_OPS
+#undef ET_TT_REV_OPS
@@ -45,6 +45,8 @@ struct TorchJITBackend {
     else if constexpr (std::is_same<Op, LogOp>::value)  return mk("aten::log", a);
     else if constexpr (std::is_same<Op, SqrtOp>::value) return mk("aten::sqrt", a);
     else if constexpr (std::is_same<Op, TanhOp>::value) return mk("aten::tanh", a);
+    else if constexpr (std::is_same<Op, RecipOp>::value) return mk("aten::reciprocal", a);
+    else if constexpr (std::is_same<Op, RsqrtOp>::value) return mk("aten::rsqrt", a);
     else static_assert(!std::is_same<Op,Op>::value, "Unary op not mapped to Torch JIT");
   }
 
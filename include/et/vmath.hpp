@@ -0,0 +1,172 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace et { namespace vmath {
+
+// Branch-free double-precision approximations of the elementary functions used
+// by the batched tape kernels. The scalar cores avoid data-dependent branches
+// and libm calls so that loops over arrays auto-vectorize (SSE2/AVX at -O2/-O3).
+// Selections are done with bit masks rather than `?:` on doubles, since GCC will
+// not if-convert floating-point comparisons under the default -ftrapping-math.
+// Each array kernel runs the core over all lanes and then patches the lanes that
+// fall outside the core's valid range (NaN, Inf, overflow, huge trig args) with
+// the exact libm result, so results are always well defined.
+// Polynomial/rational coefficients follow Cephes (exp.c, log.c, sin.c, tanh.c).
+
+inline std::uint64_t as_bits(double x) { std::uint64_t u; std::memcpy(&u, &x, sizeof u); return u; }
+inline double from_bits(std::uint64_t u) { double x; std::memcpy(&x, &u, sizeof x); return x; }
+
+// Bitwise select: a where mask bits are set, b elsewhere
+inline double blend(std::uint64_t mask, double a, double b) {
+  return from_bits((as_bits(a) & mask) | (as_bits(b) & ~mask));
+}
+// All-ones mask when the sign bit of d is set (d < 0), zero otherwise
+inline std::uint64_t sign_mask(double d) { return std::uint64_t(0) - (as_bits(d) >> 63); }
+
+// 1.5 * 2^52: (v + kShifter) rounds v to the nearest integer, held in the low mantissa bits
+constexpr double kShifter = 6755399441055744.0;
+
+// exp(x) for x in [-708, 709]
+inline double exp_core(double x) {
+  const double t = x * 1.4426950408889634074 + kShifter;
+  const double n = t - kShifter;
+  double r = x - n * 6.93145751953125E-1;
+  r = r - n * 1.42860682030941723212E-6;
+  const double rr = r * r;
+  const double px = r * ((1.26177193074810590878E-4 * rr + 3.02994407707441961300E-2) * rr
+                         + 9.99999999999999999910E-1);
+  const double qx = ((3.00198505138664455042E-6 * rr + 2.52448340349684104192E-3) * rr
+                     + 2.27265548208155028766E-1) * rr + 2.00000000000000000009E0;
+  const double e = 1.0 + 2.0 * px / (qx - px);
+  // Scale by 2^n by adding n into the exponent field (n sits in the low bits of t)
+  return from_bits(as_bits(e) + (as_bits(t) << 52));
+}
+
+// log(x) for finite normal x > 0
+inline double log_core(double x) {
+  // Split x = 2^k * z with z in [sqrt(1/2), sqrt(2))
+  const std::uint64_t ix = as_bits(x);
+  const std::uint64_t tmp = ix - 0x3fe6a09e667f3bcdULL;
+  const std::uint64_t kk = ((tmp + (std::uint64_t(2048) << 52)) >> 52) & 0xfff; // k + 2048
+  const double k = from_bits(0x4330000000000000ULL | kk) - (4503599627370496.0 + 2048.0);
+  const double z = from_bits(ix - (tmp & (std::uint64_t(0xfff) << 52)));
+  const double f = z - 1.0;
+  const double f2 = f * f;
+  const double p = ((((1.01875663804580931796E-4 * f + 4.97494994976747001425E-1) * f
+                      + 4.70579119878881725854E0) * f + 1.44989225341610930846E1) * f
+                    + 1.79368678507819816313E1) * f + 7.70838733755885391666E0;
+  const double q = ((((f + 1.12873587189167450590E1) * f + 4.52279145837532221105E1) * f
+                     + 8.29875266912776603211E1) * f + 7.11544750618563894466E1) * f
+                   + 2.31251620126765340583E1;
+  double y = f * (f2 * p / q);
+  y = y - k * 2.121944400546905827679E-4;
+  y = y - 0.5 * f2;
+  return (f + y) + k * 0.693359375;
+}
+
+// sin/cos on the reduced argument r in [-pi/4, pi/4]
+inline double sin_poly(double r) {
+  const double zz = r * r;
+  return r + r * zz * (((((1.58962301576546568060E-10 * zz - 2.50507477628578072866E-8) * zz
+                          + 2.75573136213857245213E-6) * zz - 1.98412698295895385996E-4) * zz
+                        + 8.33333333332211858878E-3) * zz - 1.66666666666666307295E-1);
+}
+inline double cos_poly(double r) {
+  const double zz = r * r;
+  return 1.0 - 0.5 * zz + zz * zz * (((((-1.13585365213876817300E-11 * zz + 2.08757008419747316778E-9) * zz
+                                       - 2.75573141792967388112E-7) * zz + 2.48015872888517045348E-5) * zz
+                                     - 1.38888888888730564116E-3) * zz + 4.16666666666665929218E-2);
+}
+
+// Reduce x by k*pi/2 (Cody-Waite, three parts); returns r and the quadrant k mod 4
+inline double reduce_pio2(double x, std::uint64_t& q) {
+  const double t = x * 0.63661977236758134308 + kShifter;
+  const double k = t - kShifter;
+  q = as_bits(t) & 3;
+  return ((x - k * 1.57079625129699707031) - k * 7.54978941586159635336E-8) - k * 5.39030285815811905290E-15;
+}
+
+// sin(x) / cos(x) for |x| <= 1e8
+inline double sin_core(double x) {
+  std::uint64_t q; const double r = reduce_pio2(x, q);
+  const double s = sin_poly(r), c = cos_poly(r);
+  const double v = blend(std::uint64_t(0) - (q & 1), c, s);
+  return from_bits(as_bits(v) ^ ((q & 2) << 62));
+}
+inline double cos_core(double x) {
+  std::uint64_t q; const double r = reduce_pio2(x, q);
+  const double s = sin_poly(r), c = cos_poly(r);
+  const double v = blend(std::uint64_t(0) - (q & 1), s, c);
+  return from_bits(as_bits(v) ^ (((q + 1) & 2) << 62));
+}
+
+// tanh(x) for non-NaN x
+inline double tanh_core(double x) {
+  const std::uint64_t sign = as_bits(x) & 0x8000000000000000ULL;
+  const double ax = from_bits(as_bits(x) ^ sign);
+  const double z = x * x;
+  const double small = x + x * z * ((-9.64399179425052238628E-1 * z - 9.92877231001918586564E1) * z
+                                    - 1.61468768441708447952E3)
+                             / (((z + 1.12811678491632931402E2) * z + 2.23548839060100448583E3) * z
+                                + 4.84406305325125486048E3);
+  const double t = exp_core(-2.0 * blend(sign_mask(22.0 - ax), 22.0, ax));
+  const double big = from_bits(as_bits((1.0 - t) / (1.0 + t)) | sign);
+  return blend(sign_mask(ax - 0.625), small, big);
+}
+
+// ---- array kernels: y[i] = f(x[i]) ----------------------------------------
+
+inline void vexp(const double* x, double* y, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) y[i] = exp_core(x[i]);
+  for (std::size_t i = 0; i < n; ++i) if (!(x[i] >= -708.0 && x[i] <= 709.0)) y[i] = std::exp(x[i]);
+}
+
+inline void vlog(const double* x, double* y, std::size_t n) {
+  constexpr double lo = std::numeric_limits<double>::min();
+  constexpr double hi = std::numeric_limits<double>::max();
+  for (std::size_t i = 0; i < n; ++i) y[i] = log_core(x[i]);
+  for (std::size_t i = 0; i < n; ++i) if (!(x[i] >= lo && x[i] <= hi)) y[i] = std::log(x[i]);
+}
+
+inline void vsin(const double* x, double* y, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) y[i] = sin_core(x[i]);
+  for (std::size_t i = 0; i < n; ++i) if (!(std::fabs(x[i]) <= 1e8)) y[i] = std::sin(x[i]);
+}
+
+inline void vcos(const double* x, double* y, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) y[i] = cos_core(x[i]);
+  for (std::size_t i = 0; i < n; ++i) if (!(std::fabs(x[i]) <= 1e8)) y[i] = std::cos(x[i]);
+}
+
+inline void vtanh(const double* x, double* y, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) y[i] = tanh_core(x[i]);
+  for (std::size_t i = 0; i < n; ++i) if (x[i] != x[i]) y[i] = x[i];
+}
+
+// sqrt is exact in hardware; the loop vectorizes when built with -fno-math-errno
+inline void vsqrt(const double* x, double* y, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) y[i] = std::sqrt(x[i]);
+}
+
+// pow(a, b) = exp(b * log(a)) for normal a > 0 and an in-range product; other
+// lanes fall back to std::pow. Works in chunks so the product stays on the stack.
+inline void vpow(const double* a, const double* b, double* y, std::size_t n) {
+  constexpr double lo = std::numeric_limits<double>::min();
+  constexpr double hi = std::numeric_limits<double>::max();
+  constexpr std::size_t chunk = 64;
+  double l[chunk];
+  for (std::size_t i0 = 0; i0 < n; i0 += chunk) {
+    const std::size_t m = (n - i0 < chunk) ? n - i0 : chunk;
+    const double* pa = a + i0; const double* pb = b + i0; double* py = y + i0;
+    for (std::size_t i = 0; i < m; ++i) l[i] = pb[i] * log_core(pa[i]);
+    for (std::size_t i = 0; i < m; ++i) py[i] = exp_core(l[i]);
+    for (std::size_t i = 0; i < m; ++i)
+      if (!(pa[i] >= lo && pa[i] <= hi && l[i] >= -708.0 && l[i] <= 709.0)) py[i] = std::pow(pa[i], pb[i]);
+  }
+}
+
+} } // namespace et::vmath
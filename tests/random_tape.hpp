@@ -0,0 +1,3 @@
+#pragma once
+// The tape tests draw their random tapes from the benchmarks' fixture
+#include "../bench/random_tape.hpp"
@@ -0,0 +1,164 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/compile_cse.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_fuse.hpp"
+#include "et/codegen_backend.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-12) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+static bool contains(const std::string& s, const std::string& sub) { return s.find(sub) != std::string::npos; }
+
+// Compiled value, gradient and batch agree with the interpreter at pts
+static void same(const Tape& t, const std::vector<std::vector<double>>& pts) {
+  CompiledTape c;
+  std::string log;
+  const bool ok = compile_and_load(t, c, {}, &log);
+  if (!ok) std::fprintf(stderr, "%s\n", log.c_str());
+  assert(ok && c && c.arity == t.arity);
+  std::vector<std::vector<double>> cols(t.arity);
+  for (auto& p : pts) {
+    assert(approx(c.forward(p), t.forward(p)));
+    auto g = c.backward(p), gr = t.backward(p);
+    for (std::size_t j = 0; j < t.arity; ++j) assert(approx(g[j], gr[j], 1e-10));
+    for (std::size_t j = 0; j < t.arity; ++j) cols[j].push_back(p[j]);
+  }
+  std::vector<const double*> ptrs;
+  for (auto& col : cols) ptrs.push_back(col.data());
+  std::vector<double> out(pts.size());
+  c.batch(ptrs.data(), pts.size(), out.data());
+  auto ref = t.forward_batch(cols);
+  for (std::size_t r = 0; r < pts.size(); ++r) assert(approx(out[r], ref[r]));
+}
+
+int main() {
+  auto [x,y,z] = Vars<double,3>();
+
+  // 1) Source shape: straight-line locals, dead nodes dropped, no constant adjoints
+  {
+    CodegenBackend cb(2);
+    const int dead = cb.emitApply(ExpOp{}, cb.emitVar<double>(1));
+    (void)dead;
+    cb.tape.output_id = compile(sin(x) * lit(2.0), cb);
+    const std::string s = cb.source("f");
+    assert(contains(s, "double f_value(const double* in)"));
+    assert(contains(s, "double f_grad(const double* in, double* grad)"));
+    assert(contains(s, "void f_batch(const double* const* cols, std::size_t n, double* out)"));
+    assert(contains(s, "std::sin("));
+    assert(!contains(s, "std::exp(")); // not reachable from the output
+    assert(contains(s, "cols[0][r]") && contains(s, "grad[1] = 0.0;"));
+    assert(contains(s, "const double v2 = 0x1p+1;") && !contains(s, "a2")); // the constant (node 2) gets no adjoint
+  }
+
+  // Building needs a host compiler; skip the rest where there is none
+  const char* cxx = std::getenv("CXX");
+  const std::string probe = std::string(cxx && *cxx ? cxx : "c++") + " --version > /dev/null 2>&1";
+  if (std::system(probe.c_str()) != 0) return 0;
+
+  const std::vector<std::vector<double>> pts = { {0.7, -1.2, 1.9}, {1.3, 0.4, 0.6}, {-0.2, 2.1, 3.3} };
+
+  // 2) Every front end drives the backend; all kinds through compile_runtime
+  {
+    auto e = sin(x)*y + z*z + exp(x)*tanh(y) + log(z) + sqrt(z*z) - x / (y*y + lit(1.0))
+           + pow(z, x) + recip(z) + rsqrt(z) + cos(-x) + x*y*z + (x + y + z);
+    CodegenBackend rt(3);
+    rt.tape.output_id = compile_runtime(normalize(compile_to_runtime(e, true)), rt);
+    same(rt.tape, pts);
+    same(fuse_tape(rt.tape), pts); // fused kinds: fma, square, sin/cos pairs
+
+    auto f = exp(x)*tanh(y) + log(z) + exp(x)*tanh(y);
+    CodegenBackend a(3), b(3);
+    a.tape.output_id = compile(f, a);
+    b.tape.output_id = compile_cse(f, b);
+    assert(b.tape.nodes.size() < a.tape.nodes.size());
+    same(a.tape, pts);
+    same(b.tape, pts);
+
+    CompiledTape ct;
+    assert(b.build(ct));
+    assert(approx(ct.forward(pts[0]), a.tape.forward(pts[0])));
+    CompiledTape moved = std::move(ct);
+    assert(!ct && moved);
+  }
+
+  // 3) Non-finite constants, repeated variables and a sin/cos pair as the output
+  {
+    CodegenBackend cb(2);
+    const int xv = cb.emitVar<double>(0), xw = cb.emitVar<double>(0);
+    const int inf = cb.emitConst(Const<double>{ INFINITY });
+    const int m = cb.emitApply(MulOp{}, xv, xw);
+    const int d = cb.emitApply(DivOp{}, m, inf);  // 0
+    const int p = cb.emitNary(AddOp{}, std::vector<int>{ m, d, xv });
+    const int s = cb.emitApply(SinOp{}, p), c2 = cb.emitApply(CosOp{}, p);
+    cb.tape.output_id = cb.emitApply(MulOp{}, s, c2);
+    same(cb.tape, pts);
+    Tape f = fuse_tape(cb.tape);
+    same(f, pts);
+    int pairs = 0;
+    for (std::size_t i = 0; i < f.nodes.size(); ++i)
+      if (f.nodes[i].kind == Tape::KSinCos) { ++pairs; f.output_id = int(i); same(f, pts); }
+    assert(pairs == 1);
+  }
+
+  // 4) A broken compiler is reported, not fatal
+  {
+    CodegenBackend cb(1);
+    cb.tape.output_id = compile(x, cb);
+    CompiledTape c;
+    CodegenOptions opt;
+    opt.flags = "-fno-such-flag-for-et";
+    std::string log;
+    assert(!cb.build(c, opt, &log) && !c && !log.empty());
+  }
+
+  // 5) n-ary products: linear prefix/suffix adjoints, exact with a zero factor
+  {
+    CodegenBackend cb(4);
+    std::vector<int> f;
+    for (int k = 0; k < 4; ++k) f.push_back(cb.emitVar<double>(k));
+    f.push_back(cb.emitConst(Const<double>{ 1.5 }));
+    cb.tape.output_id = cb.emitNary(MulOp{}, f);
+    const std::string s = cb.source("f");
+    assert(contains(s, "const double p4 = p3 * v3;"));
+    assert(!contains(s, "a5 * v1")); // no product of the other factors per factor
+    same(cb.tape, { {0.5, -2.0, 3.0, 1.25}, {0.0, 2.0, 3.0, 4.0}, {0.0, 0.0, 3.0, 4.0} });
+    CompiledTape c;
+    assert(cb.build(c));
+    const auto g = c.backward({0.0, 2.0, 3.0, 4.0});
+    assert(g[0] == 36.0 && g[1] == 0.0 && g[2] == 0.0 && g[3] == 0.0);
+  }
+
+  // 6) A scratch directory with a single quote in its name
+  {
+    const char* t = std::getenv("TMPDIR");
+    const std::string dir = std::string(t && *t ? t : "/tmp") + "/et_codegen_it's";
+    assert(std::system(("mkdir -p \"" + dir + "\"").c_str()) == 0);
+    CodegenBackend cb(1);
+    cb.tape.output_id = compile(x * x, cb);
+    CompiledTape c;
+    CodegenOptions opt;
+    opt.dir = dir;
+    std::string log;
+    const bool ok = cb.build(c, opt, &log);
+    if (!ok) std::fprintf(stderr, "%s\n", log.c_str());
+    assert(ok && c.forward({3.0}) == 9.0);
+    assert(std::remove(dir.c_str()) == 0); // the private build directory is gone
+    // no fallback to a shared directory when the private one cannot be made
+    opt.dir = dir + "/missing";
+    assert(!cb.build(c, opt, &log) && !c && contains(log, "private directory"));
+  }
+
+  return 0;
+}
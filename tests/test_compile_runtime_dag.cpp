@@ -0,0 +1,76 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+
+using namespace et;
+
+static int var(RGraph& g, std::size_t i) { RNode n; n.kind = NodeKind::Var; n.var_index = i; return g.add(n); }
+static int app(RGraph& g, NodeKind k, std::vector<int> ch) { RNode n; n.kind = k; n.ch = std::move(ch); return g.add(n); }
+
+int main() {
+  // 1) Repeated squaring through a shared node: a tree walk would emit 2^40 nodes
+  {
+    RGraph g;
+    int t = app(g, NodeKind::Sin, { var(g, 0) });
+    for (int k = 0; k < 40; ++k) t = app(g, NodeKind::Mul, { t, t });
+    g.root = t;
+
+    TapeBackend tb(1);
+    CompileRuntimeStats st;
+    tb.tape.output_id = compile_runtime(g, tb, Reduction::Native, &st);
+    assert(st.graph_nodes == 42 && st.reachable == 42 && st.emitted == 42);
+    assert(tb.tape.nodes.size() == 42);
+
+    // A small instance: value and gradient flow through the shared operands
+    TapeBackend tc(1);
+    RGraph h;
+    int u = app(h, NodeKind::Sin, { var(h, 0) });
+    for (int k = 0; k < 3; ++k) u = app(h, NodeKind::Mul, { u, u });
+    h.root = u;
+    tc.tape.output_id = compile_runtime(h, tc);
+    const double x = 0.4;
+    assert(std::fabs(tc.tape.forward(std::vector<double>{x}) - std::pow(std::sin(x), 8.0)) < 1e-15);
+    auto gr = tc.tape.backward(std::vector<double>{x});
+    assert(std::fabs(gr[0] - 8.0 * std::pow(std::sin(x), 7.0) * std::cos(x)) < 1e-14);
+  }
+
+  // 2) Unreachable nodes are skipped; stats compare emitted size with graph size
+  {
+    RGraph g;
+    int x = var(g, 0), y = var(g, 1);
+    app(g, NodeKind::Exp, { y });                      // dead
+    int s = app(g, NodeKind::Add, { x, y, x });
+    g.root = app(g, NodeKind::Mul, { s, s, y });
+
+    TapeBackend nat(2), chain(2);
+    CompileRuntimeStats sn, sc;
+    nat.tape.output_id = compile_runtime(g, nat, Reduction::Native, &sn);
+    chain.tape.output_id = compile_runtime(g, chain, Reduction::Chain, &sc);
+    assert(sn.graph_nodes == 5 && sn.reachable == 4);
+    assert(sn.emitted == 4 && nat.tape.nodes.size() == 4);
+    assert(sc.emitted == 6 && chain.tape.nodes.size() == 6);
+    std::vector<double> in = {1.5, -0.5};
+    assert(std::fabs(nat.tape.forward(in) - eval(g, in)) < 1e-14);
+    assert(std::fabs(chain.tape.forward(in) - eval(g, in)) < 1e-14);
+  }
+
+  // 3) Deep chains lower without recursion
+  {
+    RGraph g;
+    int t = var(g, 0);
+    for (int k = 0; k < 200000; ++k) t = app(g, NodeKind::Neg, { t });
+    g.root = t;
+    TapeBackend tb(1);
+    tb.tape.output_id = compile_runtime(g, tb);
+    assert(tb.tape.nodes.size() == 200001);
+    assert(tb.tape.forward(std::vector<double>{2.0}) == 2.0);
+  }
+
+  return 0;
+}
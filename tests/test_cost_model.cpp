@@ -0,0 +1,102 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/rewrite.hpp"
+#include "et/rewrite_worklist.hpp"
+#include "et/egraph.hpp"
+#include "et/cost_model.hpp"
+
+using namespace et;
+
+int main() {
+  using namespace et::pat;
+  auto [x,y] = Vars<double,2>();
+  const CostModel m = CostModel::defaults();
+
+  // 1) DAG cost: the shared x*x (interned graph) is counted once
+  {
+    RGraph g = normalize(compile_to_runtime(x*x + sin(x*x), true));
+    assert(m.cost(g) == m.unit[size_t(NodeKind::Mul)] + m.unit[size_t(NodeKind::Sin)] + m.unit[size_t(NodeKind::Add)]);
+    RGraph s = normalize(compile_to_runtime(x + y + lit(1.0)));
+    assert(m.cost(s) == 2 * m.unit[size_t(NodeKind::Add)]);
+  }
+
+  // 2) The rewriters drop a rewrite that expands a square into a Pow
+  {
+    std::vector<Rule> rules;
+    rules.push_back(Rule{ pat::mul(P(1), P(1)), pat::pow(P(1), C(2.0)), {}, "square_to_pow", 1 });
+    RGraph g = normalize(compile_to_runtime(sin(x)*sin(x) + y));
+
+    RewritePassStats st;
+    RGraph plain = apply_rules_once(g, rules, &st);
+    assert(st.rewrites == 1 && r_to_string(normalize(plain)).find("Pow") != std::string::npos);
+
+    RewritePassStats gated;
+    RGraph kept = apply_rules_once(g, rules, &gated, &m);
+    assert(gated.rewrites == 0 && gated.rejected == 1);
+    assert(r_to_string(normalize(kept)) == r_to_string(g));
+    assert(m.cost(normalize(rewrite_fixed_point(g, rules, 4, &m))) == m.cost(g));
+
+    WorklistStats ws;
+    RGraph w = rewrite_worklist(g, rules, 100, &ws, &m);
+    assert(ws.rewrites == 0 && ws.rejected >= 1 && r_to_string(w) == r_to_string(g));
+
+    // Cost-reducing rewrites still go through: log(exp(u)) -> u
+    std::vector<Rule> le;
+    le.push_back(Rule{ pat::log(pat::exp(P(1))), P(1), {}, "log_exp", 1 });
+    RGraph h = normalize(compile_to_runtime(log(exp(x + y))));
+    RewritePassStats hs;
+    apply_rules_once(h, le, &hs, &m);
+    assert(hs.rewrites == 1 && hs.rejected == 0);
+  }
+
+  // 3) Shared subterms cancel in the delta: only the replaced operators count
+  {
+    RGraph g;
+    RNode v; v.kind = NodeKind::Var; int a = g.add(v);
+    RNode s; s.kind = NodeKind::Sin; s.ch = { a }; int sa = g.add(s);
+    RNode mul; mul.kind = NodeKind::Mul; mul.ch = { sa, sa }; int sq = g.add(mul);
+    RNode two; two.kind = NodeKind::Const; two.cval = 2.0; int c2 = g.add(two);
+    RNode pw; pw.kind = NodeKind::Pow; pw.ch = { sa, c2 }; int p = g.add(pw);
+    assert(m.rewrite_delta(g, sq, p) == m.unit[size_t(NodeKind::Pow)] - m.unit[size_t(NodeKind::Mul)]);
+    assert(m.rewrite_delta(g, p, sq) == -m.rewrite_delta(g, sq, p));
+    // the reused visited stamps follow the graph as it grows
+    RNode ex; ex.kind = NodeKind::Exp; ex.ch = { sq }; int e = g.add(ex);
+    assert(m.rewrite_delta(g, e, sq) == -m.unit[size_t(NodeKind::Exp)]);
+    assert(m.rewrite_delta(g, sq, p) == m.unit[size_t(NodeKind::Pow)] - m.unit[size_t(NodeKind::Mul)]);
+  }
+
+  // 4) Calibration gives finite, non-negative costs; save/load round-trips
+  {
+    CostModel c = CostModel::calibrate(256, 2);
+    for (double u : c.unit) assert(std::isfinite(u) && u >= 0.0);
+    assert(c.unit[size_t(NodeKind::Var)] == 0.0 && c.unit[size_t(NodeKind::Const)] == 0.0);
+    const std::string path = "et_cost_model_test.txt";
+    assert(c.save(path));
+    CostModel d;
+    assert(d.load(path) && d.unit == c.unit);
+    { std::ofstream os(path); os << "et-cost-model 1\nAdd 1\nBogus 2\n"; }
+    CostModel e = m;
+    assert(!e.load(path) && e.unit == m.unit);
+    assert(!e.load("does/not/exist.txt"));
+    std::remove(path.c_str());
+  }
+
+  // 5) E-graph extraction under the model prefers x*x over pow(x, 2)
+  {
+    std::vector<Rule> rules;
+    rules.push_back(Rule{ pat::pow(P(1), C(2.0)), pat::mul(P(1), P(1)), {}, "pow_to_square", 1 });
+    RGraph g = normalize(compile_to_runtime(pow(sin(x), lit(2.0)) + y));
+    RGraph e = egraph_optimize(g, rules, {}, egraph_model_cost(m));
+    assert(m.cost(e) < m.cost(g));
+    assert(r_to_string(e).find("Pow") == std::string::npos);
+  }
+  return 0;
+}
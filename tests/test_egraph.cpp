@@ -0,0 +1,155 @@
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/rewrite.hpp"
+#include "et/rules_default.hpp"
+#include "et/egraph.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-10) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+// Op count of the extracted tree (what the e-graph minimizes by default)
+static double op_cost(const RGraph& g) {
+  EGraph eg;
+  int root = eg.add_graph(g);
+  RGraph out; double c = 0;
+  eg.extract(root, out, egraph_op_cost, &c);
+  return c;
+}
+
+int main() {
+  using namespace et::pat;
+  auto [x,y,z,w] = Vars<double,4>();
+
+  // 1) Hashcons + congruence: merging x and y makes sin(x) and sin(y) one class
+  {
+    EGraph eg;
+    ENode vx; vx.kind = NodeKind::Var; vx.var_index = 0;
+    ENode vy; vy.kind = NodeKind::Var; vy.var_index = 1;
+    int cx = eg.add(vx), cy = eg.add(vy);
+    ENode sx; sx.kind = NodeKind::Sin; sx.ch = { cx };
+    ENode sy; sy.kind = NodeKind::Sin; sy.ch = { cy };
+    int csx = eg.add(sx), csy = eg.add(sy);
+    assert(eg.add(sx) == csx && csx != csy);
+    ENode a1; a1.kind = NodeKind::Add; a1.ch = { csx, cy };
+    ENode a2; a2.kind = NodeKind::Add; a2.ch = { cy, csx };
+    assert(eg.add(a1) == eg.add(a2)); // commutative children share an e-node
+    assert(eg.merge(cx, cy));
+    eg.rebuild();
+    assert(eg.find(csx) == eg.find(csy));
+    assert(eg.eclass(csx).nodes.size() == 1);
+    // leaf fields on a non-leaf node are ignored, and -0 is the +0 constant
+    ENode stray = sx; stray.cval = 3.0; stray.var_index = 7;
+    assert(eg.find(eg.add(stray)) == eg.find(csx));
+    ENode c0; c0.kind = NodeKind::Const; c0.cval = 0.0;
+    RGraph zg;
+    RNode z; z.kind = NodeKind::Const; z.cval = -0.0;
+    zg.root = zg.add(z);
+    assert(eg.add_graph(zg) == eg.add(c0));
+  }
+
+  // 2) Non-destructive: an expanding rule that fires first under first-match
+  //    rewriting cannot make the extracted term more expensive
+  {
+    std::vector<Rule> rules;
+    rules.push_back(Rule{ pat::log(pat::mul(P(1), P(2))), pat::add(pat::log(P(1)), pat::log(P(2))), {}, "log_prod", 5 });
+    RGraph g = normalize(compile_to_runtime(log(x * y) + log(exp(z))));
+    RGraph destructive = rewrite_fixed_point(g, rules, 6);
+    assert(op_cost(destructive) > op_cost(g));
+    EGraphStats st;
+    RGraph e = egraph_optimize(g, rules, {}, egraph_op_cost, &st);
+    assert(st.stop == EGraphStop::Saturated && st.unions >= 1);
+    assert(op_cost(e) <= op_cost(g));
+  }
+
+  // 3) Both directions of a rule pair: first-match ping-pongs, saturation keeps both and picks the cheaper
+  {
+    std::vector<Rule> rules;
+    rules.push_back(Rule{ pat::exp(pat::add(P(1), P(2))), pat::mul(pat::exp(P(1)), pat::exp(P(2))), {}, "exp_split", 1 });
+    rules.push_back(Rule{ pat::mul(pat::exp(P(1)), pat::exp(P(2))), pat::exp(pat::add(P(1), P(2))), {}, "exp_join", 1 });
+    RGraph g = normalize(compile_to_runtime(exp(x) * exp(y) + sin(z)));
+    EGraphStats st;
+    RGraph e = egraph_optimize(g, rules, {}, egraph_op_cost, &st);
+    assert(st.stop == EGraphStop::Saturated);
+    assert(op_cost(e) == 4.0); // exp(x+y) + sin(z): add, exp, sin, add
+    std::vector<double> in{ 0.3, -0.2, 0.7, 0.0 };
+    assert(approx(eval(e, in), eval(g, in)));
+  }
+
+  // 4) Default rules on a larger workload: never worse than destructive rewriting, same value
+  {
+    auto u = log(exp(x + y)) + sin(w);
+    auto e = sin(u)*sin(u) + cos(u)*cos(u) + log(exp(u)) + (lit(2.0)*u + lit(3.0)*u)
+           + (z*z + lit(2.0)*z*w + w*w) + lit(5.0);
+    RGraph g = normalize(compile_to_runtime(e));
+    auto rules = default_rules();
+    RGraph fp = normalize(rewrite_fixed_point(g, rules, 12));
+    EGraphStats st;
+    RGraph eg = egraph_optimize(g, rules, {}, egraph_op_cost, &st);
+    assert(op_cost(eg) <= op_cost(fp));
+    std::vector<double> in{ 0.4, 0.1, -0.3, 0.9 };
+    assert(approx(eval(eg, in), eval(g, in), 1e-9));
+    // The FLOP-weighted model also gives an equivalent term
+    RGraph ef = egraph_optimize(g, rules, {}, egraph_flop_cost);
+    assert(approx(eval(ef, in), eval(g, in), 1e-9));
+  }
+
+  // 5) Budgets: associativity and commutativity over a wide binary sum keep
+  //    adding nodes until the node limit, which saturation only passes at ~750
+  {
+    std::vector<Rule> rules;
+    rules.push_back(Rule{ P(1) + P(2), P(2) + P(1), {}, "add_comm", 0 });
+    rules.push_back(Rule{ (P(1) + P(2)) + P(3), P(1) + (P(2) + P(3)), {}, "add_assoc", 0 });
+    RGraph g = compile_to_runtime(x + y + z + w + sin(x) + cos(y));
+    EGraphOptions opt; opt.max_nodes = 100; opt.max_iterations = 100;
+    EGraphStats st;
+    RGraph e = egraph_optimize(g, rules, opt, egraph_op_cost, &st);
+    assert(st.stop == EGraphStop::NodeLimit);
+    assert(st.enodes > opt.max_nodes);
+    std::vector<double> in{ 0.4, 0.1, -0.3, 0.9 };
+    assert(approx(eval(e, in), eval(g, in)));
+    assert(op_cost(e) == op_cost(g));
+    EGraphOptions it; it.max_iterations = 2;
+    egraph_optimize(g, rules, it, egraph_op_cost, &st);
+    assert(st.iterations <= 2 && st.stop == EGraphStop::IterationLimit);
+  }
+  // 6) The time limit is also checked while matching: with no time at all the
+  //    first iteration stops before applying anything
+  {
+    std::vector<Rule> rules;
+    rules.push_back(Rule{ P(1) + P(2), P(2) + P(1), {}, "add_comm", 0 });
+    RGraph g;
+    RNode v; v.kind = NodeKind::Var;
+    RNode sn; sn.kind = NodeKind::Sin;
+    RNode a; a.kind = NodeKind::Add;
+    int acc = -1;
+    for (std::size_t k = 0; k < 200; ++k) {
+      v.var_index = k; sn.ch = { g.add(v) };
+      const int t = g.add(sn);
+      if (acc < 0) { acc = t; continue; }
+      a.ch = { acc, t }; acc = g.add(a);
+    }
+    g.root = acc;
+    EGraphOptions opt; opt.max_millis = 0.0;
+    EGraphStats st;
+    RGraph e = egraph_optimize(g, rules, opt, egraph_op_cost, &st);
+    assert(st.stop == EGraphStop::TimeLimit && st.iterations == 1 && st.unions == 0);
+    assert(op_cost(e) == op_cost(g));
+    // a class with no finite-cost term is not extracted; the input is kept
+    const ECostFn never = [](const ENode&) { return std::numeric_limits<double>::infinity(); };
+    EGraph eg;
+    RGraph out;
+    assert(eg.extract(eg.add_graph(g), out, never) == -1);
+    assert(egraph_optimize(g, {}, {}, never).root == g.root);
+  }
+  return 0;
+}
@@ -54,5 +54,37 @@ int main() {
     assert(it->second.size() == 2);
   }
 
+  // 5) Backtracking rewinds bindings: the first sin(P1)^2 candidate binds P1=x, which has
+  //    no matching cos(x)^2; the match must drop that binding and succeed with P1=y
+  {
+    auto e = sin(x)*sin(x) + sin(y)*sin(y) + cos(y)*cos(y) + exp(x);
+    RGraph g = normalize(compile_to_runtime(e));
+    Bindings b; MultiBindings mb;
+    bool ok = match(g, pat::Pattern::node(NodeKind::Add, { sin(P(1))*sin(P(1)), cos(P(1))*cos(P(1)), S(9) }), b, mb);
+    assert(ok);
+    assert(g.nodes[b.at(1)].kind == NodeKind::Var && g.nodes[b.at(1)].var_index == 1);
+    assert(b.size() == 1 && mb.find(9)->second.size() == 2);
+    // A failed match leaves no bindings behind
+    ok = match(g, pat::Pattern::node(NodeKind::Add, { tanh(P(1)), S(9) }), b, mb);
+    assert(!ok && b.empty() && mb.empty());
+  }
+
+  // 6) Binding table trail: undo drops later bindings, iteration skips unbound slots
+  {
+    Bindings b;
+    b.emplace(3, 30);
+    const std::size_t m = b.mark();
+    b.emplace(1, 10); b[7] = 70;
+    assert(b.size() == 3 && b.count(7) == 1);
+    assert(!b.emplace(1, 11).second && b.at(1) == 10);
+    b.undo(m);
+    assert(b.size() == 1 && b.find(1) == b.end() && b.find(7) == b.end());
+    int seen = 0;
+    for (const auto& kv : b) { assert(kv.first == 3 && kv.second == 30); ++seen; }
+    assert(seen == 1);
+    b.clear();
+    assert(b.begin() == b.end() && b.count(3) == 0);
+  }
+
   return 0;
 }
@@ -0,0 +1,72 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/rewrite.hpp"
+#include "et/rules_default.hpp"
+
+using namespace et;
+
+static int var(RGraph& g, std::size_t i) { RNode n; n.kind = NodeKind::Var; n.var_index = i; return g.add(n); }
+static int app(RGraph& g, NodeKind k, std::vector<int> ch) { RNode n; n.kind = k; n.ch = std::move(ch); return g.add(n); }
+
+int main() {
+  auto rules = default_rules();
+
+  // 1) Matching sees rewritten children: log(exp(log(exp(x)))) collapses in one pass
+  {
+    RGraph g;
+    int x = var(g, 0);
+    int t = x;
+    for (int k = 0; k < 4; ++k) t = app(g, NodeKind::Log, { app(g, NodeKind::Exp, { t }) });
+    g.root = t;
+    RewritePassStats st;
+    RGraph r = apply_rules_once(g, rules, &st);
+    assert(r.nodes[r.root].kind == NodeKind::Var);
+    assert(st.rewrites == 4 && st.visited == g.nodes.size());
+  }
+
+  // 2) Shared DAG: each source node is rewritten once per pass
+  {
+    RGraph g;
+    int t = var(g, 0);
+    for (int k = 0; k < 50; ++k) {
+      int le = app(g, NodeKind::Log, { app(g, NodeKind::Exp, { t }) });
+      t = app(g, NodeKind::Pow, { le, t });
+    }
+    g.root = t;
+    RewritePassStats st;
+    RGraph r = apply_rules_once(g, rules, &st);
+    assert(st.visited == g.nodes.size());
+    assert(st.rewrites == 50);
+    // No Log(Exp(.)) is reachable any more; unmatched candidates are left unreachable
+    std::vector<char> seen(r.nodes.size(), 0);
+    std::vector<int> todo{ r.root };
+    while (!todo.empty()) {
+      int c = todo.back(); todo.pop_back();
+      if (seen[c]) continue;
+      seen[c] = 1;
+      assert(r.nodes[c].kind != NodeKind::Log && r.nodes[c].kind != NodeKind::Exp);
+      for (int ch : r.nodes[c].ch) todo.push_back(ch);
+    }
+    RGraph n = normalize(r);
+    assert(n.nodes[n.root].depth == 50);
+  }
+
+  // 3) Fixed point still agrees numerically with the input
+  {
+    auto [x,y,w] = Vars<double,3>();
+    auto u = log(exp(x + y)) + sin(w);
+    auto e = sin(u)*sin(u) + cos(u)*cos(u) + log(exp(u)) + lit(2.0)*u + lit(3.0)*u;
+    RGraph g0 = normalize(compile_to_runtime(e));
+    RGraph gr = normalize(rewrite_fixed_point(g0, rules, 12));
+    const std::vector<double> pt = {0.3, -0.2, 1.1};
+    assert(std::fabs(eval(gr, pt) - e(pt[0], pt[1], pt[2])) < 1e-10);
+    assert(gr.nodes.size() < g0.nodes.size());
+  }
+
+  return 0;
+}
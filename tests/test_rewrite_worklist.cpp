@@ -0,0 +1,106 @@
+#include <cassert>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/rewrite.hpp"
+#include "et/rewrite_worklist.hpp"
+#include "et/rules_default.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-10) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+static int var(RGraph& g, std::size_t i) { RNode n; n.kind = NodeKind::Var; n.var_index = i; return g.add(n); }
+static int app(RGraph& g, NodeKind k, std::vector<int> ch) { RNode n; n.kind = k; n.ch = std::move(ch); return g.add(n); }
+
+int main() {
+  auto rules = default_rules();
+
+  // 1) Same canonical result as the pass-based fixed point on the nested workload
+  {
+    auto [x,y,z,p,q,r,s,w] = Vars<double,8>();
+    auto u = log(exp(x + y)) + sin(w);
+    auto e = sin(u)*sin(u) + cos(u)*cos(u)
+           + log(exp(u))
+           + (lit(2.0)*u + lit(3.0)*u)
+           + (p*p + lit(2.0)*p*q + q*q)
+           + ( (p*p) - (lit(2.0)*p*q) + (q*q) )
+           + lit(5.0);
+    RGraph g0 = normalize(compile_to_runtime(e));
+    RGraph a = normalize(rewrite_fixed_point(g0, rules, 12));
+    WorklistStats st;
+    RGraph b = normalize(rewrite_worklist(g0, rules, 100000, &st));
+    assert(st.rewrites > 0);
+    assert(r_to_string(a) == r_to_string(b));
+    std::vector<double> pt = {0.7, 0.9, -0.3, 1.1, -0.4, 0.2, 0.5, 0.8};
+    assert(approx(eval(b, pt), e(pt[0],pt[1],pt[2],pt[3],pt[4],pt[5],pt[6],pt[7])));
+    (void)z; (void)r; (void)s;
+  }
+
+  // 2) A single redex deep inside a large sum: only its ancestors are revisited
+  {
+    RGraph g;
+    std::vector<int> terms;
+    for (int k = 0; k < 2000; ++k) terms.push_back(app(g, NodeKind::Sin, { var(g, (std::size_t)k) }));
+    int leaf = app(g, NodeKind::Log, { app(g, NodeKind::Exp, { var(g, 2000) }) });
+    terms.push_back(app(g, NodeKind::Cos, { leaf }));
+    g.root = app(g, NodeKind::Add, terms);
+    g = normalize(g);
+
+    WorklistStats st;
+    RGraph r = rewrite_worklist(g, rules, 100000, &st);
+    assert(st.rewrites == 1);
+    assert(st.rebuilt == 2);                  // Cos(.) and the root sum
+    assert(st.visited <= g.nodes.size() + 3); // one initial sweep plus the touched path
+    assert(r.nodes[r.root].ch.size() == 2001);
+    std::string str = r_to_string(r);
+    assert(str.find("Log(") == std::string::npos && str.find("Cos(V(2000))") != std::string::npos);
+  }
+
+  // 2b) A parent that uses the replaced node twice is rebuilt once
+  {
+    RGraph g;
+    int t = app(g, NodeKind::Log, { app(g, NodeKind::Exp, { var(g, 0) }) });
+    g.root = app(g, NodeKind::Cos, { app(g, NodeKind::Pow, { t, t }) });
+    g = normalize(g);
+    WorklistStats st;
+    RGraph r = rewrite_worklist(g, rules, 100000, &st);
+    assert(st.rewrites == 1);
+    assert(st.rebuilt == 2); // Pow(.,.) and Cos(.)
+    assert(r_to_string(r) == "Cos(Pow(V(0),V(0)))");
+  }
+
+  // 3) Local normalization keeps sums flat when a rewrite exposes a nested Add
+  {
+    RGraph g;
+    int x = var(g, 0), y = var(g, 1), z = var(g, 2);
+    int inner = app(g, NodeKind::Add, { x, y });
+    g.root = app(g, NodeKind::Add, { app(g, NodeKind::Log, { app(g, NodeKind::Exp, { inner }) }), z });
+    g = normalize(g);
+    RGraph r = rewrite_worklist(g, rules);
+    const RNode& root = r.nodes[r.root];
+    assert(root.kind == NodeKind::Add && root.ch.size() == 3);
+    for (int c : root.ch) assert(r.nodes[c].kind == NodeKind::Var);
+    assert(r_to_string(r) == r_to_string(normalize(r)));
+  }
+
+  // 4) The budget bounds the number of rule applications
+  {
+    RGraph g;
+    int t = var(g, 0);
+    for (int k = 0; k < 10; ++k) t = app(g, NodeKind::Log, { app(g, NodeKind::Exp, { t }) });
+    g.root = t;
+    WorklistStats st;
+    RGraph r = rewrite_worklist(g, rules, 3, &st);
+    assert(st.rewrites == 3);
+    assert(approx(eval(r, {0.25}), 0.25));
+  }
+
+  return 0;
+}
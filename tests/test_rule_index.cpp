@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/rewrite.hpp"
+#include "et/rule_index.hpp"
+#include "et/rules_default.hpp"
+
+using namespace et;
+
+// A few hundred generated rules over unary/binary heads, including AC heads with spreads
+static std::vector<Rule> synthetic_rules(int count) {
+  using namespace et::pat;
+  const NodeKind un[] = { NodeKind::Neg, NodeKind::Sin, NodeKind::Cos, NodeKind::Exp, NodeKind::Log, NodeKind::Sqrt, NodeKind::Tanh };
+  const NodeKind bin[] = { NodeKind::Sub, NodeKind::Div, NodeKind::Pow, NodeKind::Add, NodeKind::Mul };
+  std::vector<Rule> rs;
+  for (int i = 0; i < count; ++i) {
+    const NodeKind u1 = un[i % 7], u2 = un[(i / 7) % 7], b = bin[(i / 49) % 5];
+    Pattern lhs;
+    switch (i % 4) {
+      case 0: lhs = Pattern::node(u1, { Pattern::node(u2, { P(1) }) }); break;
+      case 1: lhs = Pattern::node(b, { P(1), Pattern::node(u2, { P(2) }) }); break;
+      case 2: lhs = Pattern::node(u1, { Pattern::node(b, { Pattern::node(u2, { P(1) }), P(2) }) }); break;
+      default: lhs = Pattern::node(NodeKind::Add, { Pattern::node(u1, { P(1) }), Pattern::node(u2, { P(2) }), S(9) }); break;
+    }
+    rs.push_back(Rule{ lhs, P(1), {}, "synthetic", i % 3 });
+  }
+  return rs;
+}
+
+int main() {
+  auto [x,y,z,p,q,r,s,w] = Vars<double,8>();
+  auto u = log(exp(x + y)) + sin(w);
+  auto e = sin(u)*sin(u) + cos(u)*cos(u) + log(exp(u)) + (lit(2.0)*u + lit(3.0)*u)
+         + (p*p + lit(2.0)*p*q + q*q) + ((p*p) - (lit(2.0)*p*q) + (q*q))
+         + exp(-z) / tanh(r) + sqrt(cos(-s)) + lit(5.0);
+  RGraph g = normalize(compile_to_runtime(e));
+
+  std::vector<Rule> rules = default_rules();
+  for (auto& rule : synthetic_rules(600)) rules.push_back(rule);
+  const RuleIndex index(rules);
+  assert(index.size() == rules.size());
+
+  // 1) Candidates are a priority-ordered superset of the rules that match
+  std::size_t linear = 0, indexed = 0;
+  for (int id = 0; id < (int)g.nodes.size(); ++id) {
+    std::vector<const Rule*> cand;
+    index.candidates(g, id, cand);
+    for (std::size_t k = 1; k < cand.size(); ++k) assert(cand[k - 1]->priority >= cand[k]->priority);
+    for (const Rule& rule : rules) {
+      Bindings b; MultiBindings mb;
+      if (match_node(g, id, rule.lhs, b, mb))
+        assert(std::find(cand.begin(), cand.end(), &rule) != cand.end());
+    }
+    linear += rules.size();
+    indexed += cand.size();
+  }
+  assert(indexed * 10 < linear);
+
+  // 2) Equal priorities keep their input order
+  {
+    std::vector<const Rule*> cand;
+    RGraph h;
+    RNode v; v.kind = NodeKind::Var; int xv = h.add(v);
+    RNode n1; n1.kind = NodeKind::Log; n1.ch = { xv }; int l = h.add(n1);
+    RNode n2; n2.kind = NodeKind::Exp; n2.ch = { l }; h.root = h.add(n2);
+    std::vector<Rule> rs;
+    rs.push_back(Rule{ pat::exp(pat::P(1)), pat::P(1), {}, "a", 1 });
+    rs.push_back(Rule{ pat::exp(pat::log(pat::P(1))), pat::P(1), {}, "b", 2 });
+    rs.push_back(Rule{ pat::P(1), pat::P(1), {}, "c", 1 });
+    rs.push_back(Rule{ pat::sin(pat::P(1)), pat::P(1), {}, "d", 5 });
+    RuleIndex ix(rs);
+    ix.candidates(h, h.root, cand);
+    assert(cand.size() == 3);
+    assert(cand[0] == &rs[1] && cand[1] == &rs[0] && cand[2] == &rs[2]);
+  }
+
+  // 3) Passes only try the candidates
+  {
+    auto defaults = default_rules();
+    RGraph a = normalize(rewrite_fixed_point(g, defaults, 12));
+    RewritePassStats st;
+    apply_rules_once(g, defaults, &st);
+    assert(st.attempts < st.visited * defaults.size());
+    assert(r_to_string(a).find("log(exp") == std::string::npos);
+  }
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+
+using namespace et;
+
+// Reference: the recursive structural hash the cached one must reproduce
+static std::uint64_t ref_hash(const RGraph& g, int id) {
+  const RNode& n = g.nodes[id];
+  std::uint64_t h = r_hash_mix(1469598103934665603ULL, static_cast<std::uint64_t>(n.kind));
+  if (n.kind == NodeKind::Const) { std::uint64_t u; double v = n.cval == 0.0 ? 0.0 : n.cval; std::memcpy(&u, &v, sizeof u); return r_hash_mix(h, u); }
+  if (n.kind == NodeKind::Var) return r_hash_mix(h, static_cast<std::uint64_t>(n.var_index));
+  for (int c : n.ch) h = r_hash_mix(h, ref_hash(g, c));
+  return h;
+}
+
+static int var(RGraph& g, std::size_t i) { RNode n; n.kind = NodeKind::Var; n.var_index = i; return g.add(n); }
+static int app(RGraph& g, NodeKind k, std::vector<int> ch) { RNode n; n.kind = k; n.ch = std::move(ch); return g.add(n); }
+
+int main() {
+  // 1) Cached hash, depth and size are computed once at add()
+  {
+    auto [x,y] = Vars<double,2>();
+    auto e = sin(x*y) + lit(2.0)*exp(x - y) + (x*y) / (lit(1.0) + y);
+    RGraph g = normalize(compile_to_runtime(e));
+    for (std::size_t i = 0; i < g.nodes.size(); ++i) {
+      assert(g.nodes[i].hash == ref_hash(g, (int)i));
+      assert(r_hash(g, (int)i) == g.nodes[i].hash);
+    }
+    const RNode& leaf = g.nodes[0];
+    assert(leaf.depth == 0 && leaf.size == 1);
+    RGraph h;
+    int a = var(h, 0), s = app(h, NodeKind::Sin, {a}), m = app(h, NodeKind::Mul, {s, a});
+    assert(h.nodes[m].depth == 2 && h.nodes[m].size == 4);
+  }
+
+  // 2) Deep shared DAG: a recursive hash would visit 2^60 paths
+  {
+    RGraph g;
+    int t = var(g, 0);
+    for (int k = 0; k < 60; ++k) t = app(g, NodeKind::Pow, {t, t});
+    g.root = app(g, NodeKind::Add, { app(g, NodeKind::Sin, {t}), t, var(g, 1) });
+    assert(g.nodes[t].size == std::numeric_limits<std::uint32_t>::max());
+    assert(g.nodes[t].depth == 60);
+    RGraph n = normalize(g);
+    assert(n.nodes[n.root].kind == NodeKind::Add && n.nodes[n.root].ch.size() == 3);
+
+    // Equal copies compare in linear time, across graphs as well
+    RGraph c = normalize(g);
+    assert(r_equal(n, n.root, c, c.root));
+    int t2 = c.nodes[c.root].ch[2];
+    assert(!r_equal(n, n.root, c, t2));
+  }
+
+  // 3) Hash rejects unequal subtrees; equal copies still compare equal
+  {
+    RGraph g;
+    int x = var(g, 0), y = var(g, 1);
+    int a = app(g, NodeKind::Sin, {app(g, NodeKind::Add, {x, y})});
+    int b = app(g, NodeKind::Sin, {app(g, NodeKind::Add, {x, y})});
+    int c = app(g, NodeKind::Sin, {app(g, NodeKind::Add, {y, x})});
+    assert(r_equal(g, a, b) && !r_equal(g, a, c));
+    RNode z; z.kind = NodeKind::Const; z.cval = 0.0;
+    RNode nz = z; nz.cval = -0.0;
+    assert(r_equal(g, g.add(z), g.add(nz)));
+  }
+
+  return 0;
+}
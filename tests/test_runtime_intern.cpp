@@ -0,0 +1,69 @@
+#include <cassert>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/rewrite.hpp"
+#include "et/rules_default.hpp"
+
+using namespace et;
+
+int main() {
+  auto [x,y,p,q,w] = Vars<double,5>();
+  auto u = log(exp(x + y)) + sin(w);
+  auto e = sin(u)*sin(u) + cos(u)*cos(u) + log(exp(u))
+         + (lit(2.0)*u + lit(3.0)*u)
+         + (p*p + lit(2.0)*p*q + q*q) + lit(5.0);
+
+  // 1) Interned build shares every repeated subtree but prints/evaluates the same
+  RGraph plain = compile_to_runtime(e);
+  RGraph g = compile_to_runtime(e, true);
+  assert(g.interning && !plain.interning);
+  assert(g.nodes.size() * 2 < plain.nodes.size()); // 33 vs 88 nodes
+  assert(g.intern_hits > 0);
+  assert(r_to_string(g) == r_to_string(plain));
+  const std::vector<double> pt = {0.7, 0.9, 1.1, -0.4, 0.8};
+  assert(std::fabs(eval(g, pt) - eval(plain, pt)) < 1e-12);
+
+  // 2) Equality is id equality; interning an existing graph collapses duplicates
+  {
+    RGraph h = intern(plain);
+    assert(h.nodes.size() == g.nodes.size());
+    assert(r_to_string(h) == r_to_string(plain));
+    RNode v; v.kind = NodeKind::Var; v.var_index = 0;
+    RNode s; s.kind = NodeKind::Sin;
+    int a = h.add(v);
+    s.ch = { a };
+    int s1 = h.add(s), s2 = h.add(s);
+    assert(s1 == s2 && r_equal(h, s1, s2));
+    // -0 and +0 intern to one node, so r_equal agrees with plain mode
+    RNode c0; c0.kind = NodeKind::Const; c0.cval = 0.0;
+    RNode c1 = c0; c1.cval = -0.0;
+    const int z0 = h.add(c0), z1 = h.add(c1);
+    assert(z0 == z1 && r_equal(h, z0, z1));
+    RGraph pl;
+    const int p0 = pl.add(c0), p1 = pl.add(c1);
+    assert(p0 != p1 && r_equal(pl, p0, p1));
+    RNode c2 = c0; c2.cval = 1.5;
+    assert(h.add(c2) != z0);
+  }
+
+  // 3) Passes keep the mode and give the same canonical result
+  {
+    auto rules = default_rules();
+    RGraph a = normalize(plain), b = normalize(g);
+    assert(b.interning && r_to_string(a) == r_to_string(b));
+    RGraph ra = normalize(rewrite_fixed_point(a, rules, 12));
+    RGraph rb = normalize(rewrite_fixed_point(b, rules, 12));
+    assert(rb.interning);
+    assert(r_to_string(ra) == r_to_string(rb));
+    assert(rb.nodes.size() <= ra.nodes.size());
+    RGraph da = denormalize_sub(ra), db = denormalize_sub(rb);
+    assert(db.interning && r_to_string(da) == r_to_string(db));
+  }
+
+  return 0;
+}
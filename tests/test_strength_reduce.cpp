@@ -0,0 +1,103 @@
+#include <cassert>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+#include "et/strength_reduce.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-10) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+static std::size_t count(const RGraph& g, NodeKind k) {
+  std::size_t c = 0;
+  for (auto& n : g.nodes) c += n.kind == k;
+  return c;
+}
+
+static Tape to_tape(const RGraph& g) {
+  TapeBackend tb(2);
+  tb.tape.output_id = compile_runtime(g, tb);
+  return tb.tape;
+}
+
+int main() {
+  auto [x,y] = Vars<double,2>();
+
+  // 1) Special exponents map to single ops; others stay Pow
+  {
+    auto lowered = [&](double c) { return r_to_string(strength_reduce(compile_to_runtime(pow(x, lit(c))))); };
+    assert(lowered(0.0) == "C(1)");
+    assert(lowered(1.0) == "V(0)");
+    assert(lowered(2.0) == "Mul(V(0),V(0))");
+    assert(lowered(0.5) == "Sqrt(V(0))");
+    assert(lowered(-0.5) == "Rsqrt(V(0))");
+    assert(lowered(-1.0) == "Recip(V(0))");
+    assert(lowered(-2.0) == "Recip(Mul(V(0),V(0)))");
+    assert(lowered(2.5).find("Pow") != std::string::npos);
+    assert(lowered(64.0).find("Pow") != std::string::npos); // above max_exponent
+    assert(r_to_string(strength_reduce(compile_to_runtime(pow(x, y)))).find("Pow") != std::string::npos);
+  }
+
+  // 2) Repeated squaring: x^13 takes 5 multiplies; powers of one base share
+  //    their chain in an interned graph (x^2, x^3, x^6 -> 3 multiplies)
+  {
+    StrengthReduceStats st;
+    RGraph g = strength_reduce(compile_to_runtime(pow(x, lit(13.0))), 32, &st);
+    assert(st.pows == 1 && st.lowered == 1 && st.muls == 5);
+    assert(count(g, NodeKind::Mul) == 5 && count(g, NodeKind::Pow) == 0);
+
+    StrengthReduceStats sh;
+    RGraph h = strength_reduce(compile_to_runtime(pow(x, lit(2.0)) + pow(x, lit(3.0)) + pow(x, lit(6.0)), true), 32, &sh);
+    assert(sh.lowered == 3 && sh.muls == 3);
+    assert(approx(eval(h, {1.3, 0.0}), std::pow(1.3, 2) + std::pow(1.3, 3) + std::pow(1.3, 6)));
+  }
+
+  // 3) Same values and derivatives on the Tape as the Pow form
+  {
+    auto f = pow(x, lit(5.0)) * y + pow(x*y + lit(1.0), lit(-3.0)) + pow(y, lit(0.5)) * pow(x, lit(-0.5))
+           + pow(x + y, lit(-1.0)) + pow(x, lit(2.5));
+    RGraph g = normalize(compile_to_runtime(f));
+    StrengthReduceStats st;
+    RGraph r = strength_reduce(g, 32, &st);
+    assert(st.lowered == 5 && count(r, NodeKind::Pow) == 1);
+    assert(count(r, NodeKind::Recip) == 2 && count(r, NodeKind::Rsqrt) == 1 && count(r, NodeKind::Sqrt) == 1);
+
+    const Tape tp = to_tape(g), tr = to_tape(r);
+    const std::vector<std::vector<double>> pts = { {0.7, 1.9}, {1.6, 0.3}, {2.2, 2.5} };
+    for (auto& pt : pts) {
+      assert(approx(tr.forward(pt), tp.forward(pt)));
+      assert(approx(tr.forward(pt), eval(r, pt)));
+      auto gp = tp.backward(pt), gr = tr.backward(pt);
+      for (int i = 0; i < 2; ++i) assert(approx(gr[i], gp[i]));
+      const std::vector<double> v = { 0.4, -1.2 };
+      assert(approx(tr.jvp(pt, v).second, tp.jvp(pt, v).second));
+      auto hp = tp.hvp(pt, v), hr = tr.hvp(pt, v);
+      for (int i = 0; i < 2; ++i) assert(approx(hr[i], hp[i], 1e-8));
+    }
+
+    std::vector<std::vector<double>> cols(2);
+    for (int i = 0; i < 100; ++i) { cols[0].push_back(0.5 + 0.02 * i); cols[1].push_back(2.0 - 0.015 * i); }
+    auto bp = tp.forward_batch(cols), br = tr.forward_batch(cols);
+    for (int i = 0; i < 100; ++i) assert(approx(br[i], bp[i]));
+  }
+
+  // 4) ET-level Recip/Rsqrt: values and symbolic derivatives
+  {
+    auto e = recip(x) + rsqrt(x * y);
+    const double a = 1.7, b = 0.6;
+    assert(approx(e(a, b), 1.0 / a + 1.0 / std::sqrt(a * b)));
+    assert(approx(diff(e, x)(a, b), -1.0 / (a * a) - 0.5 * b / std::pow(a * b, 1.5)));
+    assert(approx(diff(e, y)(a, b), -0.5 * a / std::pow(a * b, 1.5)));
+    assert(approx(eval(compile_to_runtime(e), { a, b }), e(a, b)));
+  }
+
+  return 0;
+}
@@ -0,0 +1,131 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_fuse.hpp"
+#include "et/tape_checkpoint.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-12) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+// Checkpointed sweeps under a budget agree with Tape::forward/backward
+static CheckpointPlan same(const Tape& t, const std::vector<double>& pt, std::size_t budget) {
+  const CheckpointedTape ct(t, budget);
+  const CheckpointPlan& p = ct.plan;
+  assert(!p.fits || p.memory_bytes <= budget);
+  CheckpointedTape::Workspace ws(ct);
+  std::vector<double> g(t.arity);
+  const auto gr = t.backward(pt);
+  for (int rep = 0; rep < 2; ++rep) {
+    assert(ct.forward(pt.data(), ws) == t.forward(pt));
+    assert(ct.backward(pt.data(), ws, g.data()) == t.forward(pt));
+    assert(ws.advanced == p.advances);
+    for (std::size_t j = 0; j < g.size(); ++j) assert(approx(g[j], gr[j], 1e-10));
+  }
+  return p;
+}
+
+// Unrolled explicit time stepping of a damped pendulum with parameters
+// (theta0, omega0, k, damping): a few state values cross any boundary
+static Tape pendulum(int steps) {
+  TapeBackend tb(4);
+  int th = tb.emitVar<double>(0), om = tb.emitVar<double>(1);
+  const int k = tb.emitVar<double>(2), c = tb.emitVar<double>(3);
+  const int h = tb.emitConst(Const<double>{ 0.01 });
+  for (int s = 0; s < steps; ++s) {
+    const int acc = tb.emitApply(SubOp{}, tb.emitApply(NegOp{}, tb.emitApply(MulOp{}, k, tb.emitApply(SinOp{}, th))),
+                                 tb.emitApply(MulOp{}, c, om));
+    om = tb.emitApply(AddOp{}, om, tb.emitApply(MulOp{}, h, acc));
+    th = tb.emitApply(AddOp{}, th, tb.emitApply(MulOp{}, h, om));
+  }
+  tb.tape.output_id = tb.emitNary(AddOp{}, std::vector<int>{ tb.emitApply(MulOp{}, th, th), om, tb.emitApply(CosOp{}, th) });
+  return tb.tape;
+}
+
+// Brute-force optimum of the revolve recursion
+static std::size_t brute(std::size_t s, std::size_t c, std::vector<std::vector<std::size_t>>& memo) {
+  if (s <= 1) return 0;
+  if (c == 0) return s * (s - 1) / 2;
+  std::size_t& r = memo[s][c];
+  if (r) return r;
+  r = ~std::size_t(0);
+  for (std::size_t m = 1; m < s; ++m) r = std::min(r, m + brute(s - m, c - 1, memo) + brute(m, c, memo));
+  return r;
+}
+
+int main() {
+  // 1) Closed-form binomial costs and splits are optimal
+  {
+    std::vector<std::vector<std::size_t>> memo(121, std::vector<std::size_t>(8, 0));
+    for (std::size_t c = 0; c < 8; ++c)
+      for (std::size_t s = 1; s <= 120; ++s) {
+        assert(revolve::advances(s, c) == brute(s, c, memo));
+        if (c == 0 || s < 2) continue;
+        const std::size_t m = revolve::split(s, c);
+        assert(m >= 1 && m < s);
+        assert(m + brute(s - m, c - 1, memo) + brute(m, c, memo) == brute(s, c, memo));
+      }
+    assert(revolve::beta(3, 2) == 10 && revolve::beta(200, 200) == std::uint64_t(1) << 62);
+  }
+
+  // 2) Every kind, plain and fused: 20 chained copies of one expression, from
+  //    one segment down to the leanest plan
+  {
+    auto [x,y,z] = Vars<double,3>();
+    auto e = sin(x)*y + z*z + exp(x)*tanh(y) + log(z) + sqrt(z*z) - x / (y*y + lit(1.0))
+           + pow(z, x) + recip(z) + rsqrt(z) + cos(-x) + x*y*z + (x + y + z) + sin(z)*cos(z);
+    const auto rt = normalize(compile_to_runtime(e, true));
+    TapeBackend tb(3);
+    int acc = compile_runtime(rt, tb);
+    for (int k = 1; k < 20; ++k)
+      acc = tb.emitApply(AddOp{}, tb.emitApply(MulOp{}, acc, tb.emitApply(SinOp{}, acc)), compile_runtime(rt, tb));
+    tb.tape.output_id = acc;
+    for (const Tape& t : { tb.tape, fuse_tape(tb.tape) }) {
+      const CheckpointPlan big = same(t, {0.7, -1.2, 1.9}, 1 << 20);
+      assert(big.segments == 1 && big.advances == 0 && big.recompute() == 1.0);
+      const CheckpointPlan mid = same(t, {0.7, -1.2, 1.9}, big.memory_bytes / 2);
+      assert(mid.fits && mid.segments > 1);
+      const CheckpointPlan lean = same(t, {0.7, -1.2, 1.9}, 0);
+      assert(!lean.fits && lean.snapshots == 0 && lean.segments > 1);
+    }
+  }
+
+  // 3) Long time-stepping tape: memory shrinks with the budget, recomputation grows
+  {
+    const Tape t = pendulum(2000);
+    const std::vector<double> pt = {0.9, 0.1, 4.0, 0.3};
+    const CheckpointPlan full = same(t, pt, (2 * t.nodes.size() + t.max_args) * sizeof(double));
+    assert(full.fits && full.segments == 1 && full.memory_bytes == full.plain_bytes);
+    double last = 1.0;
+    std::size_t mem = full.memory_bytes;
+    for (std::size_t budget : { 64u << 10, 16u << 10, 4u << 10 }) {
+      const CheckpointPlan p = same(t, pt, budget);
+      assert(p.fits && p.segments > 1 && p.max_live <= 4);
+      assert(p.memory_bytes <= mem && p.recompute() >= last);
+      mem = p.memory_bytes; last = p.recompute();
+    }
+    assert(mem * 20 < full.memory_bytes && last > 1.0);
+    // vector overloads
+    const CheckpointedTape ct(t, 4u << 10);
+    assert(ct.forward(pt) == t.forward(pt));
+    const auto g = ct.backward(pt), gr = t.backward(pt);
+    for (std::size_t j = 0; j < g.size(); ++j) assert(approx(g[j], gr[j], 1e-10));
+  }
+
+  // 4) Output in the middle: later nodes are dropped
+  {
+    Tape t = pendulum(50);
+    t.output_id = (int)t.nodes.size() / 2;
+    same(t, {0.9, 0.1, 4.0, 0.3}, 512);
+  }
+
+  return 0;
+}
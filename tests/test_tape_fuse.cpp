@@ -0,0 +1,113 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_regalloc.hpp"
+#include "et/tape_fuse.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-12) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+static std::size_t count(const Tape& t, Tape::Kind k) {
+  std::size_t c = 0;
+  for (auto& n : t.nodes) c += n.kind == k;
+  return c;
+}
+
+// Every evaluation mode of f agrees with the unfused tape t at pt
+static void same(const Tape& t, const Tape& f, const std::vector<double>& pt) {
+  const std::size_t n = t.arity;
+  assert(f.arity == n && f.num_outputs() == t.num_outputs());
+  auto vt = t.forward_all(pt), vf = f.forward_all(pt);
+  for (std::size_t k = 0; k < vt.size(); ++k) assert(approx(vf[k], vt[k]));
+  auto Jt = t.jacobian(pt), Jf = f.jacobian(pt);
+  for (std::size_t k = 0; k < Jt.size(); ++k) assert(approx(Jf[k], Jt[k]));
+  auto Ft = t.jacobian_forward(pt), Ff = f.jacobian_forward(pt);
+  for (std::size_t k = 0; k < Ft.size(); ++k) assert(approx(Ff[k], Ft[k]));
+  std::vector<double> v(n);
+  for (std::size_t j = 0; j < n; ++j) v[j] = 0.3 - 0.7 * double(j);
+  assert(approx(f.jvp(pt, v).second, t.jvp(pt, v).second));
+  auto Ht = t.hvp(pt, v), Hf = f.hvp(pt, v);
+  for (std::size_t j = 0; j < n; ++j) assert(approx(Hf[j], Ht[j], 1e-10));
+  SlotProgram p = allocate_slots(f);
+  assert(approx(p.forward(pt), vt[0]));
+}
+
+int main() {
+  auto [x,y,z] = Vars<double,3>();
+
+  // 1) a*b + c, c + a*b and a*b - c fuse; c - a*b keeps its Mul
+  {
+    TapeBackend tb(3);
+    tb.add_output(compile(x*y + z, tb));
+    tb.add_output(compile(z + sin(x)*y, tb));
+    tb.add_output(compile(x*z - y, tb));
+    tb.add_output(compile(y - x*z, tb));
+    FuseStats st;
+    Tape f = fuse_tape(tb.tape, &st);
+    assert(st.fma == 2 && st.fms == 1 && st.removed == 3);
+    assert(count(f, Tape::KFma) == 2 && count(f, Tape::KFms) == 1 && count(f, Tape::KMul) == 1);
+    assert(f.nodes.size() + 3 == tb.tape.nodes.size());
+    same(tb.tape, f, {0.4, -1.3, 2.1});
+  }
+
+  // 2) A shared product is not folded into either reader; x*x becomes a square
+  {
+    TapeBackend tb(2);
+    const int p = compile(x*y, tb);
+    const int yv = tb.emitVar<double>(1);
+    tb.add_output(tb.emitApply(AddOp{}, p, yv));
+    tb.add_output(tb.emitApply(SubOp{}, p, yv));
+    const int xv = tb.emitVar<double>(0);
+    tb.add_output(tb.emitApply(MulOp{}, xv, xv));
+    FuseStats st;
+    Tape f = fuse_tape(tb.tape, &st);
+    assert(st.fma == 0 && st.fms == 0 && st.square == 1);
+    same(tb.tape, f, {1.7, -0.6});
+  }
+
+  // 3) sin and cos of one operand become an adjacent pair
+  {
+    auto e = sin(x*y) * z + cos(x*y) / (z + lit(2.0)) + cos(z);
+    RGraph g = compile_to_runtime(e, true); // interned: x*y is one node
+    TapeBackend tb(3);
+    tb.tape.output_id = compile_runtime(g, tb);
+    FuseStats st;
+    Tape f = fuse_tape(tb.tape, &st);
+    assert(st.sincos == 1 && count(f, Tape::KSinCos) == 1 && count(f, Tape::KCos) == 1);
+    for (std::size_t i = 0; i < f.nodes.size(); ++i)
+      if (f.nodes[i].kind == Tape::KSinCos) assert(f.nodes[i + 1].kind == Tape::KCosPair && f.nodes[i + 1].a == f.nodes[i].a);
+    same(tb.tape, f, {0.8, 1.1, -0.4});
+    auto gt = tb.tape.backward({0.8, 1.1, -0.4}), gf = f.backward({0.8, 1.1, -0.4});
+    for (int j = 0; j < 3; ++j) assert(approx(gf[j], gt[j]));
+  }
+
+  // 4) Mixed expression through compile_runtime, with n-ary sums and batches
+  {
+    auto e = (x*y + z) * (x*x - y) + sin(z) * cos(z) + exp(x*z + y*y) + (x + y + z) * x;
+    RGraph g = compile_to_runtime(e, true);
+    TapeBackend tb(3);
+    tb.tape.output_id = compile_runtime(g, tb);
+    FuseStats st;
+    Tape f = fuse_tape(tb.tape, &st);
+    assert(st.fma >= 2 && st.fms == 1 && st.sincos == 1);
+    assert(f.nodes.size() + st.removed == tb.tape.nodes.size());
+    same(tb.tape, f, {0.5, 0.9, -1.2});
+    same(tb.tape, f, {-1.4, 0.2, 0.7});
+
+    std::vector<std::vector<double>> cols(3);
+    for (int r = 0; r < 150; ++r)
+      for (int k = 0; k < 3; ++k) cols[k].push_back(std::sin(0.1 * r + k));
+    auto bt = tb.tape.forward_batch(cols), bf = f.forward_batch(cols);
+    for (int r = 0; r < 150; ++r) assert(approx(bf[r], bt[r]));
+  }
+
+  return 0;
+}
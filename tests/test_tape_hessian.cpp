@@ -0,0 +1,72 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/dual.hpp"
+#include "et/tape_backend.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-10) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+int main() {
+  // Dual arithmetic
+  {
+    Dual<double> a(2.0, 1.0), b(3.0, 0.0);
+    auto r = pow(a, b) + sin(a) * exp(a) / sqrt(b) - log(a) + tanh(-a) + cos(a);
+    const double x = 2.0;
+    const double d = 3*x*x + (std::cos(x)*std::exp(x) + std::sin(x)*std::exp(x)) / std::sqrt(3.0)
+                   - 1.0/x - (1.0 - std::tanh(x)*std::tanh(x)) - std::sin(x);
+    assert(approx(r.d, d));
+    assert((0.5 / a).v == 0.25);
+  }
+
+  auto [x,y,z] = Vars<double,3>();
+  auto f = pow(sin(x) + cos(y), lit(2.0)) * z + exp(x*y) / (lit(2.0) + z*z)
+         + sqrt(x*x + lit(1.0)) * tanh(y) + log(z + lit(3.0)) + pow(z*z + lit(1.0), x);
+
+  TapeBackend tb(3);
+  tb.tape.output_id = compile(f, tb);
+  const Tape& t = tb.tape;
+  const std::vector<double> pt = {0.4, -0.7, 1.1};
+  auto H2 = [&](auto a, auto b) { return diff(diff(f, a), b)(pt[0], pt[1], pt[2]); };
+  const double Href[9] = { H2(x,x), H2(x,y), H2(x,z),
+                           H2(y,x), H2(y,y), H2(y,z),
+                           H2(z,x), H2(z,y), H2(z,z) };
+
+  // 1) Dense Hessian matches symbolic second derivatives
+  {
+    auto H = t.hessian(pt);
+    assert(H.size() == 9);
+    for (int i = 0; i < 9; ++i) assert(approx(H[i], Href[i]));
+  }
+
+  // 2) Hessian-vector product in one forward-over-reverse sweep, plus the gradient
+  {
+    const double v[3] = {0.3, -1.0, 2.0};
+    double Hv[3], g[3];
+    Tape::Workspace ws(t);
+    const double val = t.hvp(pt.data(), v, ws, Hv, g);
+    assert(approx(val, f(pt[0], pt[1], pt[2])));
+    for (int i = 0; i < 3; ++i)
+      assert(approx(Hv[i], Href[3*i]*v[0] + Href[3*i+1]*v[1] + Href[3*i+2]*v[2]));
+    auto gr = t.backward(pt);
+    for (int i = 0; i < 3; ++i) assert(approx(g[i], gr[i]));
+  }
+
+  // 3) Constant power at a zero base stays finite in first and second order
+  {
+    TapeBackend tp(1);
+    tp.tape.output_id = compile(pow(x, lit(3.0)), tp);
+    auto g = tp.tape.backward(std::vector<double>{0.0});
+    auto H = tp.tape.hessian(std::vector<double>{0.0});
+    assert(g[0] == 0.0 && H[0] == 0.0);
+    auto H1 = tp.tape.hessian(std::vector<double>{2.0});
+    assert(approx(H1[0], 12.0));
+  }
+
+  return 0;
+}
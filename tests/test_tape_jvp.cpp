@@ -0,0 +1,85 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/tape_backend.hpp"
+#include "et/compile_hash_cse.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-12) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+int main() {
+  auto [x,y] = Vars<double,2>();
+  auto f = pow(sin(x) + cos(y), lit(2.0)) + log(exp(x*y)) + sqrt(x + lit(3.0))
+         + tanh(-y) + (x / (y + lit(2.0))) + pow(x*x + lit(1.0), y);
+
+  TapeBackend tb(2);
+  tb.tape.output_id = compile(f, tb);
+  const Tape& t = tb.tape;
+  std::vector<double> pt = {0.7, 1.3};
+  const double gx = diff(f, x)(pt[0], pt[1]);
+  const double gy = diff(f, y)(pt[0], pt[1]);
+
+  // 1) Single direction: value plus directional derivative
+  {
+    std::vector<double> dir = {0.3, -1.2};
+    auto [v, d] = t.jvp(pt, dir);
+    assert(approx(v, f(pt[0], pt[1])));
+    assert(approx(d, 0.3*gx - 1.2*gy));
+  }
+
+  // 2) Identity block gives the gradient; agrees with reverse mode
+  {
+    auto J = t.jacobian_forward(pt);
+    assert(J.size() == 2);
+    assert(approx(J[0], gx) && approx(J[1], gy));
+    auto g = t.backward(pt);
+    assert(approx(J[0], g[0]) && approx(J[1], g[1]));
+  }
+
+  // 3) pow with a constant exponent at a zero base has a finite tangent
+  {
+    TapeBackend tp(1);
+    tp.tape.output_id = compile(pow(x, lit(3.0)), tp);
+    auto [v, d] = tp.tape.jvp(std::vector<double>{0.0}, std::vector<double>{1.0});
+    assert(v == 0.0 && d == 0.0);
+  }
+
+  // 4) Few inputs, many outputs: one batched forward pass returns the full Jacobian
+  {
+    TapeBackend mb(2);
+    HashMemo<TapeBackend> memo;
+    auto r0 = sin(x) * y;
+    auto r1 = exp(x - y) + x*x;
+    auto r2 = sqrt(x*x + y*y);
+    auto r3 = tanh(x * lit(0.5)) / (lit(1.0) + y*y);
+    mb.add_output(compile_hash_cse(r0, mb, memo));
+    mb.add_output(compile_hash_cse(r1, mb, memo));
+    mb.add_output(compile_hash_cse(r2, mb, memo));
+    mb.add_output(compile_hash_cse(r3, mb, memo));
+    const Tape& m = mb.tape;
+
+    auto Jf = m.jacobian_forward(pt);
+    auto Jr = m.jacobian(pt);
+    assert(Jf.size() == 8 && Jr.size() == 8);
+    for (std::size_t i = 0; i < 8; ++i) assert(approx(Jf[i], Jr[i]));
+    assert(approx(Jf[2*2 + 0], diff(r2, x)(pt[0], pt[1])));
+    assert(approx(Jf[3*2 + 1], diff(r3, y)(pt[0], pt[1])));
+
+    // Arbitrary directions as a K = 3 block
+    std::vector<double> dirs = { 1.0, 0.5, -2.0,    // input 0 of directions 0..2
+                                 0.0, 1.5,  0.25 }; // input 1
+    Tape::Workspace ws(m);
+    std::vector<double> out(4 * 3);
+    m.jvp_batch(pt.data(), dirs.data(), 3, ws, out.data());
+    for (std::size_t o = 0; o < 4; ++o)
+      for (std::size_t k = 0; k < 3; ++k)
+        assert(approx(out[o*3 + k], Jr[o*2 + 0]*dirs[0*3 + k] + Jr[o*2 + 1]*dirs[1*3 + k]));
+  }
+
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_fuse.hpp"
+#include "et/tape_levels.hpp"
+
+#include "random_tape.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-12) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+// Level-parallel sweeps agree with the serial ones for several thread counts
+static void same(const Tape& t, const std::vector<double>& pt, std::size_t min_parallel) {
+  const auto [v, g] = t.value_and_grad(pt);
+  for (std::size_t threads : {1, 2, 3, 4}) {
+    LevelEvaluator le(t, threads, min_parallel);
+    for (int rep = 0; rep < 3; ++rep) {
+      auto [lv, lg] = le.value_and_grad(pt);
+      assert(lv == v);
+      for (std::size_t j = 0; j < g.size(); ++j) assert(approx(lg[j], g[j], 1e-10));
+      assert(le.forward(pt) == v);
+    }
+  }
+}
+
+int main() {
+  // 1) Levels, critical path and consumer lists of a small tape
+  {
+    TapeBackend tb(2);
+    const int x = tb.emitVar<double>(0), y = tb.emitVar<double>(1);
+    const int s = tb.emitApply(SinOp{}, x);                 // level 1
+    const int m = tb.emitApply(MulOp{}, x, y);              // level 1
+    const int a = tb.emitApply(AddOp{}, s, m);              // level 2
+    tb.tape.output_id = tb.emitApply(MulOp{}, a, a);        // level 3
+    const TapeLevels L = level_schedule(tb.tape);
+    assert(L.levels() == 4 && L.work() == 6 && L.widest() == 2);
+    assert(L.level[s] == 1 && L.level[m] == 1 && L.level[a] == 2 && L.level[tb.tape.output_id] == 3);
+    assert(L.width(0) == 2 && L.order[0] == x && L.order[1] == y);
+    assert(approx(L.parallelism(), 1.5));
+    // x is read by sin (slot a) and mul (slot a); a is read twice by the square
+    assert(L.cbeg[x + 1] - L.cbeg[x] == 2 && L.cons[L.cbeg[x]] == s && L.cpart[L.cbeg[x]] == 3 * s);
+    assert(L.cbeg[a + 1] - L.cbeg[a] == 2 && L.cpart[L.cbeg[a] + 1] == 3 * tb.tape.output_id + 1);
+    same(tb.tape, {0.4, -1.1}, 1);
+  }
+
+  // 2) Every kind, fused pairs and n-ary nodes, forced onto parallel phases
+  {
+    auto [x,y,z] = Vars<double,3>();
+    auto e = sin(x)*y + z*z + exp(x)*tanh(y) + log(z) + sqrt(z*z) - x / (y*y + lit(1.0))
+           + pow(z, x) + recip(z) + rsqrt(z) + cos(-x) + x*y*z + (x + y + z) + sin(z)*cos(z);
+    TapeBackend tb(3);
+    tb.tape.output_id = compile_runtime(normalize(compile_to_runtime(e, true)), tb);
+    same(tb.tape, {0.7, -1.2, 1.9}, 1);
+    same(fuse_tape(tb.tape), {0.7, -1.2, 1.9}, 1);
+  }
+
+  // 3) Large wide random tape: several parallel phases, output not last
+  {
+    Tape t = random_tape(20000, 6, 3, { 0, true });
+    t.output_id = (int)t.nodes.size() - 2;
+    const TapeLevels L = level_schedule(t);
+    assert(L.work() == t.nodes.size() && L.parallelism() > 10.0);
+    LevelEvaluator le(t, 4, 256);
+    assert(le.threads() == 4 && le.parallel_phases() > 0);
+    same(t, {0.1, -0.3, 0.5, 0.7, -0.9, 0.2}, 256);
+    // with every level narrow everything runs on the caller
+    LevelEvaluator serial(t, 4, t.nodes.size() + 1);
+    assert(serial.threads() == 1 && serial.parallel_phases() == 0);
+    assert(serial.forward({0.1, -0.3, 0.5, 0.7, -0.9, 0.2}) == t.forward({0.1, -0.3, 0.5, 0.7, -0.9, 0.2}));
+  }
+
+  return 0;
+}
@@ -0,0 +1,83 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_regalloc.hpp"
+#include "et/compile_hash_cse.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-12) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+int main() {
+  auto [x,y,z] = Vars<double,3>();
+  // Three residuals sharing sin(x)*y and exp(z)
+  auto shared = sin(x)*y + exp(z);
+  auto r0 = shared * shared;
+  auto r1 = shared - x*z;
+  auto r2 = log(shared + lit(3.0)) * y;
+
+  // Shared memo: common subexpressions are emitted once across outputs
+  TapeBackend tb(3);
+  HashMemo<TapeBackend> memo;
+  tb.add_output(compile_hash_cse(r0, tb, memo));
+  tb.add_output(compile_hash_cse(r1, tb, memo));
+  tb.add_output(compile_hash_cse(r2, tb, memo));
+  const Tape& t = tb.tape;
+  assert(t.num_outputs() == 3);
+  assert(t.output_id == t.outputs[0]);
+
+  TapeBackend sep(3);
+  compile_hash_cse(r0, sep); compile_hash_cse(r1, sep); compile_hash_cse(r2, sep);
+  assert(t.nodes.size() < sep.tape.nodes.size());
+
+  std::vector<double> pt = {0.4, -1.1, 0.3};
+  auto vals = t.forward_all(pt);
+  assert(vals.size() == 3);
+  assert(approx(vals[0], r0(pt[0], pt[1], pt[2])));
+  assert(approx(vals[1], r1(pt[0], pt[1], pt[2])));
+  assert(approx(vals[2], r2(pt[0], pt[1], pt[2])));
+  assert(approx(t.forward(pt), vals[0])); // primary output
+
+  // Full Jacobian matches symbolic derivatives row by row
+  auto J = t.jacobian(pt);
+  assert(J.size() == 3 * t.arity);
+  auto check_row = [&](std::size_t k, const auto& r) {
+    assert(approx(J[k*3 + 0], diff(r, x)(pt[0], pt[1], pt[2])));
+    assert(approx(J[k*3 + 1], diff(r, y)(pt[0], pt[1], pt[2])));
+    assert(approx(J[k*3 + 2], diff(r, z)(pt[0], pt[1], pt[2])));
+  };
+  check_row(0, r0); check_row(1, r1); check_row(2, r2);
+
+  // VJP with an arbitrary seed equals seed^T J
+  std::vector<double> seed = {0.5, -2.0, 3.0};
+  auto v = t.vjp(pt, seed);
+  for (std::size_t j = 0; j < 3; ++j) {
+    double ref = 0.0;
+    for (std::size_t k = 0; k < 3; ++k) ref += seed[k] * J[k*3 + j];
+    assert(approx(v[j], ref));
+  }
+
+  // Unit seed on the primary output reproduces backward()
+  auto g = t.backward(pt);
+  auto v0 = t.vjp(pt, std::vector<double>{1.0, 0.0, 0.0});
+  for (std::size_t j = 0; j < 3; ++j) assert(approx(g[j], v0[j]));
+
+  // Workspace variant also reports the outputs
+  Tape::Workspace ws(t);
+  std::vector<double> grad(3), out(3);
+  t.vjp(pt.data(), seed.data(), ws, grad.data(), out.data());
+  for (std::size_t k = 0; k < 3; ++k) assert(approx(out[k], vals[k]));
+
+  // Slot allocation keeps every output alive
+  SlotProgram p = allocate_slots(t);
+  std::vector<double> slots(p.num_slots), pout(3);
+  p.forward_all(pt.data(), slots.data(), pout.data());
+  for (std::size_t k = 0; k < 3; ++k) assert(approx(pout[k], vals[k]));
+
+  return 0;
+}
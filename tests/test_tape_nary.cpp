@@ -0,0 +1,84 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_regalloc.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-12) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+static int var(RGraph& g, std::size_t i) { RNode n; n.kind = NodeKind::Var; n.var_index = i; return g.add(n); }
+static int cst(RGraph& g, double c) { RNode n; n.kind = NodeKind::Const; n.cval = c; return g.add(n); }
+static int app(RGraph& g, NodeKind k, std::vector<int> ch) { RNode n; n.kind = k; n.ch = std::move(ch); return g.add(n); }
+
+int main() {
+  // sum_k c_k * x_{k%3} * sin(x_{(k+1)%3}) over 1000 terms, as produced by normalize
+  RGraph g;
+  int x[3] = { var(g, 0), var(g, 1), var(g, 2) };
+  int s[3] = { app(g, NodeKind::Sin, {x[0]}), app(g, NodeKind::Sin, {x[1]}), app(g, NodeKind::Sin, {x[2]}) };
+  std::vector<int> terms;
+  for (int k = 0; k < 1000; ++k)
+    terms.push_back(app(g, NodeKind::Mul, { cst(g, 1.0 + 0.001 * k), x[k % 3], s[(k + 1) % 3] }));
+  g.root = app(g, NodeKind::Add, terms);
+
+  const std::vector<double> in = {0.3, -1.1, 0.8};
+
+  TapeBackend nat(3), chain(3), pair(3);
+  nat.tape.output_id   = compile_runtime(g, nat);
+  chain.tape.output_id = compile_runtime(g, chain, Reduction::Chain);
+  pair.tape.output_id  = compile_runtime(g, pair, Reduction::Pairwise);
+  const Tape& t = nat.tape;
+
+  // 1) One instruction per reduction instead of a binary chain
+  int sums = 0, prods = 0;
+  for (auto& n : t.nodes) { sums += n.kind == Tape::KSum; prods += n.kind == Tape::KProd; }
+  assert(sums == 1 && prods == 1000);
+  assert(t.max_args == 1000);
+  assert(t.nodes.size() < chain.tape.nodes.size() - 1500);
+  assert(pair.tape.nodes.size() == chain.tape.nodes.size());
+
+  // 2) All lowerings agree on value and gradient
+  const double ref = eval(g, in);
+  assert(approx(t.forward(in), ref));
+  assert(approx(chain.tape.forward(in), ref));
+  assert(approx(pair.tape.forward(in), ref));
+  auto gn = t.backward(in), gc = chain.tape.backward(in), gp = pair.tape.backward(in);
+  for (int i = 0; i < 3; ++i) assert(approx(gn[i], gc[i]) && approx(gp[i], gc[i]));
+
+  // 3) Forward mode, second order, batch and slot allocation handle n-ary nodes
+  {
+    auto J = t.jacobian_forward(in);
+    for (int i = 0; i < 3; ++i) assert(approx(J[i], gc[i]));
+    auto Hn = t.hessian(in), Hc = chain.tape.hessian(in);
+    for (int i = 0; i < 9; ++i) assert(approx(Hn[i], Hc[i]));
+    std::vector<std::vector<double>> cols = { {in[0], 1.0}, {in[1], 2.0}, {in[2], -0.5} };
+    auto vb = t.forward_batch(cols);
+    assert(approx(vb[0], ref));
+    assert(approx(vb[1], chain.tape.forward(std::vector<double>{1.0, 2.0, -0.5})));
+    SlotProgram sp = allocate_slots(t);
+    assert(approx(sp.forward(in), ref));
+  }
+
+  // 4) Product gradients are exact with a zero factor (no division by the operand)
+  {
+    RGraph h;
+    int a = var(h, 0), b = var(h, 1), c = var(h, 2), d = var(h, 3);
+    h.root = app(h, NodeKind::Mul, { a, b, c, d });
+    TapeBackend tb(4);
+    tb.tape.output_id = compile_runtime(h, tb);
+    assert(tb.tape.nodes.back().kind == Tape::KProd);
+    auto gz = tb.tape.backward(std::vector<double>{2.0, 0.0, 3.0, 5.0});
+    assert(gz[0] == 0.0 && gz[1] == 30.0 && gz[2] == 0.0 && gz[3] == 0.0);
+    auto [v, dv] = tb.tape.jvp(std::vector<double>{2.0, 0.0, 3.0, 5.0}, std::vector<double>{1.0, 1.0, 1.0, 1.0});
+    assert(v == 0.0 && dv == 30.0);
+  }
+
+  return 0;
+}
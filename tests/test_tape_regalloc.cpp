@@ -0,0 +1,76 @@
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_regalloc.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-12) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+int main() {
+  // 1) Mixed-op expression: same value, fewer slots than nodes
+  {
+    auto [x,y] = Vars<double,2>();
+    auto f = pow(sin(x) + cos(y), lit(2.0)) + log(exp(x*y)) + sqrt(x + lit(3.0))
+           + tanh(-y) + (x / (y + lit(2.0))) + x*x;
+    RGraph g = compile_to_runtime(f);
+    TapeBackend tb(2);
+    tb.tape.output_id = compile_runtime(g, tb);
+
+    SlotProgram p = allocate_slots(tb.tape);
+    assert(p.code.nodes.size() == tb.tape.nodes.size());
+    assert(p.num_slots < (int)tb.tape.nodes.size());
+    std::vector<double> pt = {0.7, 1.3};
+    assert(approx(p.forward(pt), tb.tape.forward(pt)));
+  }
+
+  // 2) Dead nodes are dropped
+  {
+    TapeBackend tb(1);
+    int x = tb.emitVar<double>(0);
+    int dead = tb.emitApply(SinOp{}, x);
+    (void)dead;
+    int out = tb.emitApply(ExpOp{}, x);
+    tb.tape.output_id = out;
+    SlotProgram p = allocate_slots(tb.tape);
+    assert(p.code.nodes.size() == 2);
+    assert(approx(p.forward(std::vector<double>{0.5}), std::exp(0.5)));
+  }
+
+  // 3) Large random expression: the working set stays small
+  {
+    std::mt19937 rng(3);
+    TapeBackend tb(4);
+    std::vector<int> pool;
+    for (std::size_t v = 0; v < 4; ++v) pool.push_back(tb.emitVar<double>(v));
+    int acc = pool[0];
+    for (int i = 0; i < 20000; ++i) {
+      // Mostly local operands (like generated code), occasionally a far one
+      int a = acc;
+      int b = (rng() % 8 == 0) ? pool[rng() % pool.size()] : tb.emitConst<double>(Const<double>(0.5 + (rng() % 7) * 0.01));
+      switch (rng() % 4) {
+        case 0: acc = tb.emitApply(AddOp{}, a, b); break;
+        case 1: acc = tb.emitApply(MulOp{}, a, tb.emitApply(CosOp{}, b)); break;
+        case 2: acc = tb.emitApply(SubOp{}, a, b); break;
+        default: acc = tb.emitApply(TanhOp{}, a); break;
+      }
+      if (rng() % 64 == 0) pool.push_back(acc);
+    }
+    tb.tape.output_id = acc;
+    SlotProgram p = allocate_slots(tb.tape);
+    assert(p.num_slots <= (int)pool.size() + 4);
+    std::vector<double> pt = {0.1, -0.2, 0.3, 0.4};
+    std::vector<double> slots(p.num_slots);
+    assert(approx(p.forward(pt.data(), slots.data()), tb.tape.forward(pt)));
+  }
+
+  return 0;
+}
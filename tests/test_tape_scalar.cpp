@@ -0,0 +1,121 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_fuse.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+// Every sweep of t agrees with the double reference at pt to within eps
+template <class R, class A>
+static void close_to(const BasicTape<R, A>& t, const Tape& ref, const std::vector<double>& pt, double eps) {
+  const std::vector<R> in(pt.begin(), pt.end());
+  const double v = ref.forward(pt);
+  const auto g = ref.backward(pt);
+  assert(approx((double)t.forward(in), v, eps));
+  const auto gb = t.backward(in);
+  auto [vg, gg] = t.value_and_grad(in);
+  static_assert(std::is_same<typename decltype(gb)::value_type, A>::value, "gradients are Acc");
+  assert(vg == t.forward(in));
+  for (std::size_t j = 0; j < g.size(); ++j) {
+    assert(approx((double)gb[j], g[j], eps));
+    assert(approx((double)gg[j], g[j], eps));
+  }
+  // batched kernels, 70 rows (one full block and a partial one)
+  std::vector<std::vector<R>> cols(pt.size(), std::vector<R>(70));
+  for (std::size_t r = 0; r < 70; ++r)
+    for (std::size_t k = 0; k < pt.size(); ++k) cols[k][r] = in[k] * R(1.0 + 0.001 * double(r));
+  const auto out = t.forward_batch(cols);
+  for (std::size_t r = 0; r < 70; ++r) {
+    std::vector<R> row(pt.size());
+    for (std::size_t k = 0; k < pt.size(); ++k) row[k] = cols[k][r];
+    assert(approx((double)out[r], (double)t.forward(row), eps));
+  }
+}
+
+int main() {
+  auto [x,y,z] = Vars<double,3>();
+  const std::vector<double> pt = {0.7, -1.2, 1.9};
+  auto e = sin(x)*y + z*z + exp(x)*tanh(y) + log(z) + sqrt(z*z) - x / (y*y + lit(1.0))
+         + pow(z, x) + recip(z) + rsqrt(z) + cos(-x) + x*y*z + (x + y + z) + sin(z)*cos(z);
+  TapeBackend ref(3);
+  ref.tape.output_id = compile_runtime(normalize(compile_to_runtime(e, true)), ref);
+
+  // 1) Every kind recorded directly in float, float with double accumulation
+  //    and long double
+  {
+    BasicTapeBackend<float> f(3);
+    f.tape.output_id = compile_runtime(normalize(compile_to_runtime(e, true)), f);
+    close_to(f.tape, ref.tape, pt, 1e-5);
+    BasicTapeBackend<float, double> fd(3);
+    fd.tape.output_id = compile_runtime(normalize(compile_to_runtime(e, true)), fd);
+    close_to(fd.tape, ref.tape, pt, 1e-5);
+    BasicTapeBackend<long double> ld(3);
+    ld.tape.output_id = compile_runtime(normalize(compile_to_runtime(e, true)), ld);
+    close_to(ld.tape, ref.tape, pt, 1e-13);
+    // long double batches go through the same std:: calls as forward
+    const std::vector<std::vector<long double>> cols = {{0.7L}, {-1.2L}, {1.9L}};
+    assert(ld.tape.forward_batch(cols)[0] == ld.tape.forward({0.7L, -1.2L, 1.9L}));
+  }
+
+  // 2) tape_cast of a fused double tape (KFma, KSquare, KSinCos, n-ary nodes)
+  {
+    const Tape fused = fuse_tape(ref.tape);
+    close_to(tape_cast<float>(fused), ref.tape, pt, 1e-5);
+    close_to(tape_cast<float, double>(fused), ref.tape, pt, 1e-5);
+    close_to(tape_cast<long double>(fused), ref.tape, pt, 1e-13);
+    const Tape back = tape_cast<double>(tape_cast<long double>(fused));
+    assert(back.forward(pt) == fused.forward(pt));
+  }
+
+  // 3) Double accumulation keeps tiny terms that float drops: a reduction of
+  //    1 + 1000 * 1e-8, and an adjoint of 1 that then collects 1001 * 1e-8
+  {
+    BasicTapeBackend<float> f(2);
+    BasicTapeBackend<float, double> fd(2);
+    auto build_sum = [](auto& tb) {
+      const int big = tb.template emitVar<double>(0), tiny = tb.template emitVar<double>(1);
+      std::vector<int> ids(1001, tiny);
+      ids[0] = big;
+      tb.tape.output_id = tb.emitNary(AddOp{}, ids);
+    };
+    build_sum(f); build_sum(fd);
+    const std::vector<float> in = {1.0f, 1e-8f};
+    const double want = 1.0 + 1000.0 * double(1e-8f);
+    assert(f.tape.forward(in) == 1.0f);
+    assert(fd.tape.forward(in) == float(want));
+    const float* cols[2] = { &in[0], &in[1] };
+    float out = 0.0f;
+    f.tape.forward_batch(cols, 1, &out);
+    assert(out == 1.0f);
+    fd.tape.forward_batch(cols, 1, &out);
+    assert(out == float(want));
+
+    auto build_chain = [](auto& tb) {
+      const int v = tb.template emitVar<double>(0);
+      const int c = tb.emitConst(Const<double>{ 1e-8 });
+      int acc = tb.emitApply(MulOp{}, v, c);
+      for (int k = 0; k < 1000; ++k) acc = tb.emitApply(AddOp{}, acc, tb.emitApply(MulOp{}, v, c));
+      tb.tape.output_id = tb.emitApply(AddOp{}, acc, v); // reached first by the reverse sweep
+    };
+    BasicTapeBackend<float> g(1);
+    BasicTapeBackend<float, double> gd(1);
+    build_chain(g); build_chain(gd);
+    const double dwant = 1.0 + 1001.0 * double(1e-8f);
+    assert(g.tape.backward({0.5f})[0] == 1.0f);
+    assert(g.tape.value_and_grad({0.5f}).second[0] == 1.0f);
+    assert(approx(gd.tape.backward({0.5f})[0], dwant, 1e-12));
+    assert(approx(gd.tape.value_and_grad({0.5f}).second[0], dwant, 1e-12));
+  }
+
+  return 0;
+}
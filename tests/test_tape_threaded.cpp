@@ -0,0 +1,84 @@
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "et/expr.hpp"
+#include "et/runtime_ast.hpp"
+#include "et/normalize.hpp"
+#include "et/compile_runtime.hpp"
+#include "et/tape_backend.hpp"
+#include "et/tape_fuse.hpp"
+#include "et/tape_threaded.hpp"
+
+#include "random_tape.hpp"
+
+using namespace et;
+
+static bool approx(double a, double b, double eps = 1e-12) {
+  return std::fabs(a - b) <= eps * (1.0 + std::max(std::fabs(a), std::fabs(b)));
+}
+
+// Threaded and switch engines agree on value and gradient at pt
+static void same(const Tape& t, const std::vector<double>& pt, bool supers = true) {
+  ThreadedTape tt(t, supers);
+  assert(tt.engine == TapeEngine::Threaded);
+  const double v = tt.forward(pt);
+  assert(v == t.forward(pt)); // same operations in the same order
+  auto g = tt.backward(pt), gr = t.backward(pt);
+  assert(g.size() == gr.size());
+  for (std::size_t j = 0; j < g.size(); ++j) assert(approx(g[j], gr[j]));
+  tt.engine = TapeEngine::Switch;
+  assert(tt.forward(pt) == v);
+  auto gs = tt.backward(pt);
+  for (std::size_t j = 0; j < g.size(); ++j) assert(gs[j] == gr[j]);
+}
+
+int main() {
+  auto [x,y,z] = Vars<double,3>();
+  const std::vector<double> pt = {0.7, -1.2, 1.9};
+
+  // 1) Every kind, including the ones run through Tape (Pow, n-ary, pairs)
+  {
+    auto e = sin(x)*y + z*z + exp(x)*tanh(y) + log(z) + sqrt(z*z) - x / (y*y + lit(1.0))
+           + pow(z, x) + recip(z) + rsqrt(z) + cos(-x) + x*y*z + (x + y + z);
+    TapeBackend tb(3);
+    tb.tape.output_id = compile_runtime(normalize(compile_to_runtime(e, true)), tb);
+    same(tb.tape, pt);
+    same(tb.tape, pt, false);
+    same(fuse_tape(tb.tape), pt);
+  }
+
+  // 2) Superinstructions form on adjacent loads and arithmetic
+  {
+    TapeBackend tb(2);
+    const int a = tb.emitVar<double>(0), b = tb.emitVar<double>(1);
+    const int s = tb.emitApply(AddOp{}, a, b);
+    const int m = tb.emitApply(MulOp{}, s, a);
+    tb.tape.output_id = tb.emitApply(SubOp{}, m, b);
+    ThreadedTape tt(tb.tape);
+    assert(tt.supers == 2); // (Var, Var) and (Add, Mul); the Sub runs alone
+    assert(ThreadedTape(tb.tape, false).supers == 0);
+    same(tb.tape, {1.5, -0.5});
+  }
+
+  // 3) Large random tapes, reusing one workspace
+  {
+    const Tape t = random_tape(3000, 4, 11);
+    ThreadedTape tt(t);
+    assert(tt.supers > 0);
+    Tape::Workspace ws(t), wr(t);
+    std::vector<double> g(4), gr(4);
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> U(-1.0, 1.0);
+    for (int k = 0; k < 10; ++k) {
+      const double in[4] = { U(rng), U(rng), U(rng), U(rng) };
+      const double v = tt.backward(in, ws, g.data());
+      assert(approx(v, t.backward(in, wr, gr.data())));
+      assert(tt.forward(in, ws) == v);
+      for (int j = 0; j < 4; ++j) assert(approx(g[j], gr[j], 1e-9));
+    }
+  }
+
+  return 0;
+}